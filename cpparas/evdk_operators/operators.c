@@ -42,6 +42,7 @@ extern "C" {
 
 #include "operators.h"
 #include "operators_basic.h"
+#include "operators_binary.h"
 #include "operators_float.h"
 #include "operators_hsv.h"
 #include "operators_int16.h"
@@ -116,6 +117,19 @@ inline uint16_pixel_t getUInt16Pixel(const image_t* img, int32_t c, int32_t r)
     return (*((uint16_pixel_t*)(img->data) + (r * img->cols + c)));
 }
 
+inline void setBinaryPixel(image_t* img, int32_t c, int32_t r, basic_pixel_t value)
+{
+    binary_word_t* word = (binary_word_t*)(img->data) + (r * BINARY_WORDS_PER_ROW(img->cols) + c / BINARY_WORD_BITS);
+    binary_word_t bit = (binary_word_t)1 << (c % BINARY_WORD_BITS);
+    *word = value ? (*word | bit) : (*word & ~bit);
+}
+
+inline basic_pixel_t getBinaryPixel(const image_t* img, int32_t c, int32_t r)
+{
+    binary_word_t word = *((binary_word_t*)(img->data) + (r * BINARY_WORDS_PER_ROW(img->cols) + c / BINARY_WORD_BITS));
+    return (basic_pixel_t)((word >> (c % BINARY_WORD_BITS)) & 1);
+}
+
 // ----------------------------------------------------------------------------
 // Image creation
 // ----------------------------------------------------------------------------
@@ -141,6 +155,9 @@ void deleteImage(image_t* img)
     case IMGTYPE_UINT16:
         deleteUInt16Image(img);
         break;
+    case IMGTYPE_BINARY:
+        deleteBinaryImage(img);
+        break;
     default:
         fprintf(stderr, "deleteImage(): image type %d not supported\n", img->type);
         break;
@@ -168,6 +185,9 @@ void convertImage(const image_t* src, image_t* dst)
     case IMGTYPE_UINT16:
         convertToUInt16Image(src, dst);
         break;
+    case IMGTYPE_BINARY:
+        convertToBinaryImage(src, dst);
+        break;
     default:
         fprintf(stderr, "convertImage(): image type %d not supported\n", dst->type);
         break;
@@ -265,7 +285,7 @@ void rotate180(const image_t* img)
 
 void threshold(const image_t* src, image_t* dst, const int32_t low, const int32_t high, const uint8_t output)
 {
-    if (src->type != dst->type) {
+    if (src->type != dst->type && !(src->type == IMGTYPE_BASIC && dst->type == IMGTYPE_BINARY)) {
         fprintf(stderr, "threshold(): src and dst are of different type\n");
     }
 
@@ -279,7 +299,11 @@ void threshold(const image_t* src, image_t* dst, const int32_t low, const int32_
             fprintf(stderr, "threshold(): high > 255 is invalid for IMGTYPE_BASIC\n");
         }
 
-        threshold_basic(src, dst, (basic_pixel_t)low, (basic_pixel_t)high, output);
+        if (dst->type == IMGTYPE_BINARY) {
+            threshold_binary(src, dst, (basic_pixel_t)low, (basic_pixel_t)high, output);
+        } else {
+            threshold_basic(src, dst, (basic_pixel_t)low, (basic_pixel_t)high, output);
+        }
         break;
     case IMGTYPE_INT16:
     case IMGTYPE_FLOAT:
@@ -343,6 +367,59 @@ void thresholdOtsu(const image_t* src, image_t* dst, const eBrightness brightnes
     }
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void thresholdAdaptive(const image_t* src, image_t* dst, const uint8_t radius, const int32_t offset, const eBrightness brightness)
+{
+    if (src->type != IMGTYPE_BASIC || dst->type != IMGTYPE_BINARY) {
+        fprintf(stderr, "thresholdAdaptive(): src type %d to dst type %d not supported\n", src->type, dst->type);
+        return;
+    }
+
+    thresholdAdaptive_binary(src, dst, radius, offset, brightness);
+}
+
+void thresholdLevel(const image_t* src, image_t* dst, const int32_t level, const eBrightness brightness)
+{
+    if (src->type != dst->type) {
+        fprintf(stderr, "thresholdLevel(): src and dst are of different type\n");
+    }
+
+    switch (src->type) {
+    case IMGTYPE_BASIC:
+        if (level < 0 || level > 255) {
+            fprintf(stderr, "thresholdLevel(): level outside 0..255 is invalid for IMGTYPE_BASIC\n");
+        }
+
+        thresholdLevel_basic(src, dst, (basic_pixel_t)level, brightness);
+        break;
+    case IMGTYPE_INT16:
+    case IMGTYPE_FLOAT:
+        fprintf(stderr, "thresholdLevel(): image type %d not yet implemented\n", src->type);
+        break;
+    case IMGTYPE_RGB888:
+    case IMGTYPE_HSV:
+    case IMGTYPE_UINT16:
+    default:
+        fprintf(stderr, "thresholdLevel(): image type %d not supported\n", src->type);
+        break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+uint8_t threshold2MeansLevel(const uint32_t* hist)
+{
+    return threshold2MeansLevel_basic(hist);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+uint8_t thresholdOtsuLevel(const uint32_t* hist)
+{
+    return thresholdOtsuLevel_basic(hist);
+}
+
 // ----------------------------------------------------------------------------
 // Miscellaneous
 // ----------------------------------------------------------------------------
@@ -454,6 +531,27 @@ void histogram(const image_t* img, uint16_t* hist)
     }
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void histogram32(const image_t* img, uint32_t* hist)
+{
+    switch (img->type) {
+    case IMGTYPE_BASIC:
+        histogram32_basic(img, hist);
+        break;
+    case IMGTYPE_INT16:
+    case IMGTYPE_FLOAT:
+        fprintf(stderr, "histogram32(): image type %d not yet implemented\n", img->type);
+        break;
+    case IMGTYPE_RGB888:
+    case IMGTYPE_HSV:
+    case IMGTYPE_UINT16:
+    default:
+        fprintf(stderr, "histogram32(): image type %d not supported\n", img->type);
+        break;
+    }
+}
+
 // ----------------------------------------------------------------------------
 // Arithmetic
 // ----------------------------------------------------------------------------
@@ -523,6 +621,11 @@ void invert(const image_t* src, image_t* dst, uint8_t is_binary)
         fprintf(stderr, "invert(): src and dst are of different type\n");
     }
 
+    if (src->type == IMGTYPE_BINARY) {
+        invert_binary(src, dst);
+        return;
+    }
+
     // Build function call table
     // (make sure order matches the order in eImageType)
     void (*fp[])(const image_t*, image_t*, uint8_t) = {
@@ -743,11 +846,11 @@ void warp(const image_t* img, image_t* dst, int32_t colpos[3], int32_t rowpos[3]
     }
 }
 
-void warpAffine(const image_t* img, image_t* dst, float warpMatrix[2][3])
+void warpAffine(const image_t* img, image_t* dst, float warpMatrix[2][3], const eInterpolation interpolation)
 {
     switch (img->type) {
     case IMGTYPE_RGB888:
-        warpAffine_rgb888(img, dst, warpMatrix);
+        warpAffine_rgb888(img, dst, warpMatrix, interpolation);
         break;
     default:
         fprintf(stderr, "warpAffine(): image type %d not supported\n", img->type);
@@ -755,12 +858,31 @@ void warpAffine(const image_t* img, image_t* dst, float warpMatrix[2][3])
     }
 }
 
+void warpPerspective(const image_t* img, image_t* dst, float homography[3][3], const eInterpolation interpolation)
+{
+    switch (img->type) {
+    case IMGTYPE_RGB888:
+        warpPerspective_rgb888(img, dst, homography, interpolation);
+        break;
+    default:
+        fprintf(stderr, "warpPerspective(): image type %d not supported\n", img->type);
+        break;
+    }
+}
+
 void scaleImage(const image_t* src, image_t* dst)
 {
     switch (src->type) {
     case IMGTYPE_BASIC:
         scaleImage_basic(src, dst);
         break;
+    case IMGTYPE_BINARY:
+        if (dst->type != IMGTYPE_BASIC && dst->type != IMGTYPE_BINARY) {
+            fprintf(stderr, "scaleImage(): binary to image type %d not supported\n", dst->type);
+            break;
+        }
+        scaleImage_binary(src, dst);
+        break;
     case IMGTYPE_RGB888:
         scaleImage_rgb888(src, dst);
         break;
@@ -770,6 +892,34 @@ void scaleImage(const image_t* src, image_t* dst)
     }
 }
 
+void downscale(const image_t* src, image_t* dst, const uint8_t factor)
+{
+    if (factor == 0) {
+        fprintf(stderr, "downscale(): factor 0 is invalid\n");
+        return;
+    }
+
+    switch (src->type) {
+    case IMGTYPE_BASIC:
+        if (dst->type != IMGTYPE_BASIC) {
+            fprintf(stderr, "downscale(): basic to image type %d not supported\n", dst->type);
+            break;
+        }
+        downscale_basic(src, dst, factor);
+        break;
+    case IMGTYPE_RGB888:
+        if (dst->type != IMGTYPE_BASIC && dst->type != IMGTYPE_RGB888) {
+            fprintf(stderr, "downscale(): RGB888 to image type %d not supported\n", dst->type);
+            break;
+        }
+        downscale_rgb888(src, dst, factor);
+        break;
+    default:
+        fprintf(stderr, "downscale(): image type %d not supported\n", src->type);
+        break;
+    }
+}
+
 void Corner(const image_t* src, image_t* dst, const uint8_t blockSize, const uint8_t ksize, const double k, const uint8_t method)
 {
     switch (src->type) {
@@ -782,6 +932,27 @@ void Corner(const image_t* src, image_t* dst, const uint8_t blockSize, const uin
     }
 }
 
+uint32_t cornerResponse(const image_t* src, corner_scratch_t* scratch, const eCornerMethod method, const uint8_t ksize, const float k, const uint8_t minDistance, corner_t* corners, const uint32_t maxCorners)
+{
+    if (scratch == NULL || scratch->capacity < src->cols * src->rows || scratch->cols < src->cols) {
+        fprintf(stderr, "cornerResponse(): scratch is too small\n");
+        return 0;
+    }
+    if (ksize != 3 && ksize != 5 && ksize != 7) {
+        fprintf(stderr, "cornerResponse(): ksize %d is invalid\n", ksize);
+        return 0;
+    }
+
+    switch (src->type) {
+    case IMGTYPE_BASIC:
+        return cornerResponse_basic(src, scratch, method, ksize, k, minDistance, corners, maxCorners);
+    default:
+        fprintf(stderr, "cornerResponse(): image type %d not supported\n", src->type);
+        break;
+    }
+    return 0;
+}
+
 void crop(const image_t* img, image_t* dst, int32_t top_left[2])
 {
     switch (img->type) {
@@ -797,18 +968,76 @@ void crop(const image_t* img, image_t* dst, int32_t top_left[2])
     }
 }
 
-void binaryErode(const image_t* src, image_t* dst, uint8_t kernelSize)
+// Checks the scratch of the packed binary morphology, so a missing or too
+// small scratch is reported instead of overrunning it.
+static uint8_t binaryScratchFits(const char* name, const image_t* src, const binary_scratch_t* scratch)
+{
+    if (scratch == NULL || scratch->cols < src->cols || scratch->rows < src->rows) {
+        fprintf(stderr, "%s(): scratch is too small\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+void binaryErode(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
 {
     switch (src->type) {
     case IMGTYPE_BASIC:
         binaryErode_basic(src, dst, kernelSize);
         break;
+    case IMGTYPE_BINARY:
+        if (binaryScratchFits("binaryErode", src, scratch)) {
+            binaryErode_binary(src, dst, kernelSize, scratch);
+        }
+        break;
     default:
         fprintf(stderr, "binaryErode(): image type %d not supported\n", src->type);
         break;
     }
 }
 
+void binaryDilate(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    switch (src->type) {
+    case IMGTYPE_BINARY:
+        if (binaryScratchFits("binaryDilate", src, scratch)) {
+            binaryDilate_binary(src, dst, kernelSize, scratch);
+        }
+        break;
+    default:
+        fprintf(stderr, "binaryDilate(): image type %d not supported\n", src->type);
+        break;
+    }
+}
+
+void binaryOpen(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    switch (src->type) {
+    case IMGTYPE_BINARY:
+        if (binaryScratchFits("binaryOpen", src, scratch)) {
+            binaryOpen_binary(src, dst, kernelSize, scratch);
+        }
+        break;
+    default:
+        fprintf(stderr, "binaryOpen(): image type %d not supported\n", src->type);
+        break;
+    }
+}
+
+void binaryClose(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    switch (src->type) {
+    case IMGTYPE_BINARY:
+        if (binaryScratchFits("binaryClose", src, scratch)) {
+            binaryClose_binary(src, dst, kernelSize, scratch);
+        }
+        break;
+    default:
+        fprintf(stderr, "binaryClose(): image type %d not supported\n", src->type);
+        break;
+    }
+}
+
 void drawRect(image_t* img, const int32_t top_left[2], const int32_t size[2], pixel_t value, eShapeDrawType drawType, uint16_t borderSize)
 {
     switch (img->type) {
@@ -851,6 +1080,8 @@ uint32_t pixelCount(const image_t* img, const pixel_t value)
     case IMGTYPE_BASIC:
         return pixelCount_basic(img, value.basic_pixel);
         break;
+    case IMGTYPE_BINARY:
+        return pixelCount_binary(img, value.basic_pixel);
     default:
         fprintf(stderr, "pixelCount(): image type %d not supported\n", img->type);
         return 0;
@@ -863,6 +1094,9 @@ void clear_center(image_t* src)
     case IMGTYPE_BASIC:
         clear_center_basic(src);
         break;
+    case IMGTYPE_BINARY:
+        clear_center_binary(src);
+        break;
     default:
         fprintf(stderr, "clear_center(): image type %d not supported\n", src->type);
         break;
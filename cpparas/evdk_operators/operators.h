@@ -36,6 +36,9 @@
     Version 2.1 - November 2019
     > Updated by EVD ARAS group, removed RGB565
 
+    Version 2.2
+    > Added YUV420 conversion and warp
+
 ******************************************************************************/
 #ifdef __cplusplus
 extern "C" {
@@ -73,6 +76,7 @@ typedef enum {
     IMGTYPE_RGB888 = 3, // RGB 8-bit per pixel
     IMGTYPE_HSV = 4, // HSV 16-bit H, 8-bit S,V
     IMGTYPE_UINT16 = 5,
+    IMGTYPE_BINARY = 6, // Binary, 1 bit per pixel packed in 64-bit words
 
     IMGTYPE_MAX = 2147483647 // Max 32-bit int value,
     // forces enum to be 4 bytes
@@ -90,6 +94,11 @@ typedef enum {
 
 // Pixel types
 typedef uint8_t basic_pixel_t;
+// Binary images hold rows of 64-bit words, the first pixel of a row in the
+// least significant bit of its first word. Bits past the last col are 0.
+typedef uint64_t binary_word_t;
+#define BINARY_WORD_BITS 64
+#define BINARY_WORDS_PER_ROW(cols) (((cols) + BINARY_WORD_BITS - 1) / BINARY_WORD_BITS)
 typedef int16_t int16_pixel_t;
 typedef float float_pixel_t;
 typedef uint16_t uint16_pixel_t;
@@ -189,6 +198,68 @@ typedef struct blobinfo_t {
 
 } blobinfo_t;
 
+// Corner response methods
+typedef enum {
+    CORNER_HARRIS = 0,
+    CORNER_SHI_TOMASI
+
+} eCornerMethod;
+
+// Sampling of the source pixels by a warp
+typedef enum {
+    NEAREST = 0,
+    BILINEAR
+
+} eInterpolation;
+
+// A corner found by cornerResponse()
+typedef struct corner_t {
+    int32_t col;
+    int32_t row;
+    int64_t response;
+
+} corner_t;
+
+// Scratch memory of cornerResponse(), so repeated calls don't allocate.
+// Holds the smoothed gradient products (xx, yy and xy of every pixel), the
+// products of the row that is being smoothed and the response of every pixel.
+typedef struct corner_scratch_t {
+    int32_t capacity;
+    int32_t cols;
+    int32_t* products;
+    int32_t* line;
+    int64_t* responses;
+
+} corner_scratch_t;
+
+// Scratch memory of the packed binary morphology, so repeated calls don't
+// allocate. Holds the runs of every row, with kernelSize rows of padding
+// above and below, and two padded rows of the row pass.
+typedef struct binary_scratch_t {
+    int32_t cols;
+    int32_t rows;
+    binary_word_t* runs;
+    binary_word_t* line;
+
+} binary_scratch_t;
+
+// The source position of every dst pixel of a warp, made by
+// warpTableFromCorners(), so warping with the same corners again is a single
+// gather pass. offsets holds the index of the left-top pixel of the 2x2
+// source block a dst pixel is interpolated from, or -1 outside the source,
+// chromaOffsets the index of its pixel in the half size chroma planes, and
+// fractions the col and row position within the block in 1/256 pixels.
+typedef struct warp_table_t {
+    int32_t cols;
+    int32_t rows;
+    int32_t srcCols;
+    int32_t srcRows;
+    int32_t* offsets;
+    int32_t* chromaOffsets;
+    uint8_t* fractions;
+
+} warp_table_t;
+
 // ----------------------------------------------------------------------------
 // Function prototypes
 // ----------------------------------------------------------------------------
@@ -208,6 +279,8 @@ extern void setHSVPixel(image_t* img, int32_t c, int32_t r, hsv_pixel_t value);
 extern hsv_pixel_t getHSVPixel(const image_t* img, int32_t c, int32_t r);
 extern void setUInt16Pixel(image_t* img, int32_t c, int32_t r, uint16_pixel_t value);
 extern uint16_pixel_t getUInt16Pixel(const image_t* img, int32_t c, int32_t r);
+extern void setBinaryPixel(image_t* img, int32_t c, int32_t r, basic_pixel_t value);
+extern basic_pixel_t getBinaryPixel(const image_t* img, int32_t c, int32_t r);
 
 // ----------------------------------------------------------------------------
 // Memory (de)allocation
@@ -225,6 +298,7 @@ image_t* newFloatImage(const uint32_t cols, const uint32_t rows);
 image_t* newRGB888Image(const uint32_t cols, const uint32_t rows);
 image_t* newHSVImage(const uint32_t cols, const uint32_t rows);
 image_t* newUInt16Image(const uint32_t cols, const uint32_t rows);
+image_t* newBinaryImage(const uint32_t cols, const uint32_t rows);
 
 // These functions can be used for copying images
 // Memory is allocated within these functions
@@ -238,6 +312,7 @@ image_t* toFloatImage(image_t* src);
 image_t* toRGB888Image(image_t* src);
 image_t* toHSVImage(const image_t* src);
 image_t* toUInt16Image(image_t* src);
+image_t* toBinaryImage(image_t* src);
 
 // Use the function deleteImage() for freeing memory
 // This function will automatically call the appropriate function based on the
@@ -252,6 +327,7 @@ void deleteFloatImage(image_t* img);
 void deleteRGB888Image(image_t* img);
 void deleteHSVImage(image_t* img);
 void deleteUInt16Image(image_t* img);
+void deleteBinaryImage(image_t* img);
 
 // Use the function convertImage() for converting between image types
 //
@@ -271,6 +347,7 @@ void convertToFloatImage(const image_t* src, image_t* dst);
 void convertToRGB888Image(const image_t* src, image_t* dst);
 void convertToHSVImage(const image_t* src, image_t* dst);
 void convertToUInt16Image(const image_t* src, image_t* dst);
+void convertToBinaryImage(const image_t* src, image_t* dst);
 
 // ----------------------------------------------------------------------------
 // Contrast stretching
@@ -317,6 +394,8 @@ void rotate180(const image_t* img);
 // This function is used in all VisionSets. Without it, initially nothing will
 // seem to happen.
 //
+// A basic src can be thresholded into a packed binary dst.
+//
 // Precondition : img is a single channel image
 // Postcondition: dst is a binary image
 void threshold(const image_t* src, image_t* dst, const int32_t low, const int32_t high, const uint8_t output);
@@ -333,6 +412,37 @@ void threshold2Means(const image_t* src, image_t* dst, const eBrightness brightn
 // Postcondition: dst is a binary image
 void thresholdOtsu(const image_t* src, image_t* dst, const eBrightness brightness);
 
+// Thresholds at a level chosen before, e.g. by threshold2MeansLevel() or
+// thresholdOtsuLevel(). The level belongs to the dark pixels.
+//
+// Precondition : img is a single channel image
+// Postcondition: dst is a binary image
+void thresholdLevel(const image_t* src, image_t* dst, const int32_t level, const eBrightness brightness);
+
+// Thresholds every pixel at the mean of the square window around it, so the
+// level follows uneven lighting. DARK sets the pixels more than offset below
+// the mean, BRIGHT the pixels more than offset above it. The window is
+// 2 * radius + 1 pixels wide and is clipped at the borders of the image.
+//
+// Precondition : src is a basic image, dst is a packed binary image of the
+//                same size
+// Postcondition: dst is a binary image
+void thresholdAdaptive(const image_t* src, image_t* dst, const uint8_t radius, const int32_t offset, const eBrightness brightness);
+
+// Returns the level the 2-means method chooses for a histogram made by
+// histogram32(), so the histogram can be used for more than one decision
+//
+// Precondition : hist has 256 bins
+// Postcondition: -
+uint8_t threshold2MeansLevel(const uint32_t* hist);
+
+// Returns the level Otsu's method chooses for a histogram made by
+// histogram32()
+//
+// Precondition : hist has 256 bins
+// Postcondition: -
+uint8_t thresholdOtsuLevel(const uint32_t* hist);
+
 // ----------------------------------------------------------------------------
 // Miscellaneous
 // ----------------------------------------------------------------------------
@@ -370,6 +480,13 @@ uint32_t neighbourCount(const image_t* img, const int32_t c, const int32_t r, co
 // Postcondition: -
 void histogram(const image_t* img, uint16_t* hist);
 
+// Make a histogram of the source image with bins that don't overflow,
+// whatever the size of the image
+//
+// Precondition : img is a single channel image
+// Postcondition: -
+void histogram32(const image_t* img, uint32_t* hist);
+
 // ----------------------------------------------------------------------------
 // Arithmetic
 // ----------------------------------------------------------------------------
@@ -471,27 +588,137 @@ float normalizedCentralMoments(const image_t* img, const uint8_t blobnr, const i
 // ----------------------------------------------------------------------------
 
 // Cuts out a part of the input image and warps it with (approximate) affine correction.
-// The interpolation method is nearest neighbor (no interpolation).
+// The interpolation method is bilinear.
 //
 // Precondition : dst is allocated and has the wanted cols and rows
 //                positions are ordered as follows: left-top, right-top, right-bottom
 // Postcondition: dst is filled with the warped image
 void warp(const image_t* img, image_t* dst, int32_t colpos[3], int32_t rowpos[3]);
 
-// Performs an affine transformation warp.
+// Calculates the affine matrix that warp() uses to map the corners onto dst.
+//
+// Precondition : dst has the wanted cols and rows
+//                positions are ordered as follows: left-top, right-top, right-bottom
+// Postcondition: warpMatrix maps source coordinates to dst coordinates
+void warpMatrixFromCorners(const image_t* dst, int32_t colpos[3], int32_t rowpos[3], float warpMatrix[2][3]);
+
+// Cuts out a part of a YUV420 image and warps it like warp(), converting only the pixels of dst to RGB.
+// The chroma planes have half the cols and rows of the Y plane. Without chroma the result is gray.
 // The interpolation method is nearest neighbor (no interpolation).
 //
+// Precondition : y is basic, u and v are basic or both NULL
+//                dst is an allocated RGB888 image and has the wanted cols and rows
+//                positions are ordered as follows: left-top, right-top, right-bottom
+// Postcondition: dst is filled with the warped image, pixels outside y are black
+void warpYUV420(const image_t* y, const image_t* u, const image_t* v, image_t* dst, int32_t colpos[3], int32_t rowpos[3]);
+
+// Allocates a warp table for a dst of cols x rows pixels. Returns NULL when
+// out of memory.
+//
+// Precondition : -
+// Postcondition: User must free allocated memory by calling
+//                deleteWarpTable() when appropriate
+warp_table_t* newWarpTable(const uint32_t cols, const uint32_t rows);
+void deleteWarpTable(warp_table_t* table);
+
+// Fills the table with the source positions that warp() maps onto the dst,
+// for a source of srcCols x srcRows pixels of at least 2 x 2 pixels.
+//
+// Precondition : table is allocated with the cols and rows of dst
+//                positions are ordered as follows: left-top, right-top, right-bottom
+// Postcondition: table holds the position of every dst pixel in the source
+void warpTableFromCorners(warp_table_t* table, const int32_t srcCols, const int32_t srcRows, int32_t colpos[3], int32_t rowpos[3]);
+
+// Cuts out a part of the input image like warp(), but looks every dst pixel up
+// in a table made before, and interpolates it bilinearly (fixed point).
+// The HSV image is filled in the same pass, like convertToHSVImage() would.
+//
+// Precondition : img is RGB888 with the size the table was made for
+//                dst is RGB888 with the size of the table
+//                hsv is HSV with the size of the table, or NULL
+// Postcondition: dst is filled with the warped image, pixels outside img are black
+void warpWithTable(const image_t* img, image_t* dst, image_t* hsv, const warp_table_t* table);
+
+// Cuts out a part of a YUV420 image like warpYUV420(), but looks every dst
+// pixel up in a table made before. The luma is interpolated bilinearly, the
+// chroma of the nearest block is used. The HSV image is filled in the same
+// pass, like convertToHSVImage() would.
+//
+// Precondition : y is basic with the size the table was made for, u and v are
+//                basic with half its cols and rows, or both NULL
+//                dst is RGB888 with the size of the table
+//                hsv is HSV with the size of the table, or NULL
+// Postcondition: dst is filled with the warped image, pixels outside y are black
+void warpYUV420WithTable(const image_t* y, const image_t* u, const image_t* v, image_t* dst, image_t* hsv, const warp_table_t* table);
+
+// Fills the table with the source positions that warpPerspective() maps
+// onto the dst, for a source of srcCols x srcRows pixels of at least 2 x 2
+// pixels.
+//
+// Precondition : table is allocated with the cols and rows of dst
+//                homography is made by homographyFromCorners() for the dst
+// Postcondition: table holds the position of every dst pixel in the source
+//                and 1 is returned, or 0 when out of memory, in which case
+//                the table is marked as made for no source (srcCols is 0)
+uint8_t warpTableFromHomography(warp_table_t* table, const int32_t srcCols, const int32_t srcRows, float homography[3][3]);
+
+// Converts an RGB888 image to the planes of a YUV420 image (full range BT.601).
+// The chroma of each 2x2 block is averaged. Without u and v only the Y plane is written.
+//
+// Precondition : src is RGB888, y is basic with the cols and rows of src rounded down to even,
+//                u and v are basic with half the cols and rows of y, or both NULL
+// Postcondition: y, u and v are filled
+void convertRGB888ToYUV420(const image_t* src, image_t* y, image_t* u, image_t* v);
+
+// Performs an affine transformation warp. Every dst pixel is looked up in
+// the source through the inverted matrix, and sampled at the nearest source
+// pixel or interpolated bilinearly. The work depends on the dst size only.
+//
 // Precondition : dst is allocated and has the wanted cols and rows
-// Postcondition: dst is filled with the warped image
-void warpAffine(const image_t* img, image_t* dst, float warpMatrix[2][3]);
+//                img has less than 32768 cols and rows
+// Postcondition: dst is filled with the warped image, pixels outside img are black
+void warpAffine(const image_t* img, image_t* dst, float warpMatrix[2][3], const eInterpolation interpolation);
+
+// Calculates the homography that maps every dst pixel onto the quadrangle of
+// four corners, so the dst shows it without perspective. Returns 0 when the
+// corners do not span a quadrangle.
+//
+// Precondition : positions are ordered as follows: left-top, right-top,
+//                right-bottom, left-bottom
+// Postcondition: homography maps dst (col, row, 1) to the source position
+//                in homogeneous coordinates
+uint8_t homographyFromCorners(const image_t* dst, int32_t colpos[4], int32_t rowpos[4], float homography[3][3]);
+
+// Performs a perspective warp. Every dst pixel is looked up in the source
+// through the homography, and sampled at the nearest source pixel or
+// interpolated bilinearly. The source position is only divided out at every
+// 16 dst pixels of a row, in between it steps in fixed point.
+//
+// Precondition : dst is allocated and has the wanted cols and rows
+//                img has less than 32768 cols and rows
+// Postcondition: dst is filled with the warped image, pixels outside img are black
+void warpPerspective(const image_t* img, image_t* dst, float homography[3][3], const eInterpolation interpolation);
 
 // Scales an image.
 // The interpolation method is nearest neighbor (no interpolation).
+// A binary src can be scaled into a basic dst of zeroes and ones.
 //
 // Precondition : dst is allocated and has the wanted cols and rows
 // Postcondition: dst is filled with the scaled image
 void scaleImage(const image_t* src, image_t* dst);
 
+// Scales an image down by an integer factor, averaging every block of
+// factor x factor pixels. A basic dst gets the luma of an RGB888 src (full
+// range BT.601, like convertRGB888ToYUV420), so the conversion and the
+// scaling read the src only once and no full size image is needed.
+// Supported are basic to basic, RGB888 to basic and RGB888 to RGB888.
+//
+// Precondition : dst is allocated with the cols and rows of src divided by
+//                factor (rounded down), factor is at least 1
+// Postcondition: dst is filled, trailing cols and rows of src that don't
+//                fill a block are left out
+void downscale(const image_t* src, image_t* dst, const uint8_t factor);
+
 // Finds corners in an image
 // Blocksize must be 2 or 1 for current method
 // ksize must be 3,5, or 7
@@ -503,6 +730,35 @@ void scaleImage(const image_t* src, image_t* dst);
 // Postcondition:dst is binary output with corner values
 void Corner(const image_t* src, image_t* dst, const uint8_t blockSize, const uint8_t ksize, const double k, const uint8_t method);
 
+// Allocates scratch memory for cornerResponse() on images of up to
+// cols x rows pixels. Returns NULL when out of memory.
+//
+// Precondition : -
+// Postcondition: User must free allocated memory by calling
+//                deleteCornerScratch() when appropriate
+corner_scratch_t* newCornerScratch(const uint32_t cols, const uint32_t rows);
+void deleteCornerScratch(corner_scratch_t* scratch);
+
+// Finds the strongest corners in an image.
+// Integer Sobel gradients are smoothed with a separable integer Gaussian
+// (sigma 1) of ksize taps, after which every pixel gets a Harris response
+// det(M) - k * trace(M)^2 or a Shi-Tomasi response (the smallest eigenvalue
+// of M). Responses only compare within one call; their scale follows the
+// contrast of the image. Pixels closer to the border than the kernels reach
+// are left out, as are responses that are not positive.
+// With a minDistance, only responses that are the maximum of the square of
+// minDistance pixels around them are corners (non-maximum suppression), so
+// corners are more than minDistance cols or rows apart. With 0 every
+// response is a corner.
+// No memory is allocated, so it can run on every frame.
+//
+// Precondition : src is binary or basic, scratch holds at least the pixels and cols of src
+//                ksize is 3, 5 or 7
+//                corners has room for maxCorners corners
+// Postcondition: corners holds the strongest corners, strongest first,
+//                the number of corners is returned
+uint32_t cornerResponse(const image_t* src, corner_scratch_t* scratch, const eCornerMethod method, const uint8_t ksize, const float k, const uint8_t minDistance, corner_t* corners, const uint32_t maxCorners);
+
 // Crops the image using an source upper left corner and destination size.
 //
 // WARNING:
@@ -513,10 +769,37 @@ void Corner(const image_t* src, image_t* dst, const uint8_t blockSize, const uin
 // Postcondition: dst is filled with the cropped image
 void crop(const image_t* img, image_t* dst, int32_t top_left[2]);
 
+// Allocates scratch memory for the morphology of packed binary images of up
+// to cols x rows pixels, for any kernel size. Returns NULL when out of memory.
+//
+// Precondition : -
+// Postcondition: User must free allocated memory by calling
+//                deleteBinaryScratch() when appropriate
+binary_scratch_t* newBinaryScratch(const uint32_t cols, const uint32_t rows);
+void deleteBinaryScratch(binary_scratch_t* scratch);
+
 // Erodes the binary image with a square structuring element of the specified size.
+// Basic images support sizes up to 8 and leave the border as it is, they
+// don't use the scratch, which may be NULL.
+// Packed binary images support any size, 64 pixels at a time. The element
+// covers kernelSize / 2 pixels before a pixel, and pixels outside of the
+// image don't erode. No memory is allocated, so it can run on every frame.
 // Precondition: src is filled with zeroes or ones. dst is allocated with the same size as src.
+//               For binary images scratch holds at least the cols and rows of src.
 // Postcondition: dst is eroded and filled with zeroes or ones.
-void binaryErode(const image_t* src, image_t* dst, uint8_t kernelSize);
+void binaryErode(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+
+// Dilates, opens (erode, then dilate) or closes (dilate, then erode) the
+// packed binary image with a square structuring element of any size.
+// Dilation uses the mirrored element of binaryErode(), so opening never adds
+// pixels and closing never removes them. Pixels outside of the image are 0
+// for dilation. src and dst may be the same image.
+// Precondition: src and dst are binary images of the same size,
+//               scratch holds at least the cols and rows of src
+// Postcondition: dst is filled
+void binaryDilate(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+void binaryOpen(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+void binaryClose(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
 
 // Draws a rectangle shape on the image.
 // Precondition: img is allocated.
@@ -538,14 +821,15 @@ void drawBinaryImage(image_t* img, const image_t* bin_img, const int32_t top_lef
 void drawText(image_t* img, const char* text, const font_t* font, const int32_t top_left[2], uint8_t scale, pixel_t value);
 
 // Counts the number of pixels whose value is equal to the specified value.
+// Binary images are counted a word at a time.
 // Precondition: img is allocated.
 // Postcondition: -
 uint32_t pixelCount(const image_t* img, const pixel_t value);
 
 // Clears center pixels in an image.
 //
-// Precondition : src is basic
-// Postcondition: src center pixels are cleared
+// Precondition : src is basic or binary
+// Postcondition: src center pixels are cleared (set to 1)
 void clear_center(image_t* src);
 
 #endif // _OPERATORS_H_
@@ -38,6 +38,7 @@
 #include "operators_basic.h"
 #include "math.h"
 #include "stdio.h"
+#include "string.h"
 
 #ifdef STM32F746xx
 #include "mem_manager.h"
@@ -172,6 +173,15 @@ void convertToBasicImage(const image_t* src, image_t* dst)
             }
         }
 
+    } break;
+    case IMGTYPE_BINARY: {
+        // Loop all pixels and unpack
+        for (int32_t r = 0; r < src->rows; r++) {
+            for (int32_t c = 0; c < src->cols; c++) {
+                *d++ = getBinaryPixel(src, c, r);
+            }
+        }
+
     } break;
     default:
         break;
@@ -263,53 +273,130 @@ void threshold_basic(const image_t* src, image_t* dst, const basic_pixel_t low,
 // ----------------------------------------------------------------------------
 void threshold2Means_basic(const image_t* src, image_t* dst, const eBrightness brightness)
 {
+    uint32_t hist[256];
 
-    // Not yet implemented
-    // ********************************************
-    // Added to prevent compiler warnings
-    // Remove these when implementation starts
-    (void)src;
-    (void)dst;
-    (void)brightness;
-
-    return;
-    // ********************************************
+    histogram32_basic(src, hist);
+    thresholdLevel_basic(src, dst, threshold2MeansLevel_basic(hist), brightness);
 }
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 void thresholdOtsu_basic(const image_t* src, image_t* dst, const eBrightness brightness)
 {
+    uint32_t hist[256];
 
-    // Not yet implemented
-    // ********************************************
-    // Added to prevent compiler warnings
-    // Remove these when implementation starts
-    (void)src;
-    (void)dst;
-    (void)brightness;
+    histogram32_basic(src, hist);
+    thresholdLevel_basic(src, dst, thresholdOtsuLevel_basic(hist), brightness);
+}
 
-    return;
-    // ********************************************
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void thresholdLevel_basic(const image_t* src, image_t* dst, const basic_pixel_t level, const eBrightness brightness)
+{
+    // The level itself belongs to the dark class
+    if (brightness == DARK) {
+        threshold_basic(src, dst, 0, level, 1);
+    } else if (level < 255) {
+        threshold_basic(src, dst, level + 1, 255, 1);
+    } else {
+        // Nothing is brighter than the level, so every pixel is outside the range
+        threshold_basic(src, dst, 1, 0, 1);
+    }
 }
 
 // ----------------------------------------------------------------------------
-// Miscellaneous
 // ----------------------------------------------------------------------------
+basic_pixel_t threshold2MeansLevel_basic(const uint32_t* hist)
+{
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint32_t level;
+    uint32_t previous;
+    uint32_t i;
+
+    for (i = 0; i < 256; i++) {
+        count += hist[i];
+        sum += (uint64_t)i * hist[i];
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Start at the mean and move the level to halfway between the means of
+    // both classes until it no longer changes
+    level = (uint32_t)(sum / count);
+    do {
+        uint64_t countLow = 0;
+        uint64_t sumLow = 0;
+        uint32_t meanLow;
+        uint32_t meanHigh;
+
+        for (i = 0; i <= level; i++) {
+            countLow += hist[i];
+            sumLow += (uint64_t)i * hist[i];
+        }
+        meanLow = countLow == 0 ? 0 : (uint32_t)(sumLow / countLow);
+        meanHigh = countLow == count ? 255 : (uint32_t)((sum - sumLow) / (count - countLow));
+
+        previous = level;
+        level = (meanLow + meanHigh) / 2;
+    } while (level != previous);
+
+    return (basic_pixel_t)level;
+}
 
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
-void erase_basic(const image_t* img)
+basic_pixel_t thresholdOtsuLevel_basic(const uint32_t* hist)
 {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t countLow = 0;
+    uint64_t sumLow = 0;
+    double best = -1.0;
+    uint32_t level = 0;
+    uint32_t i;
+
+    for (i = 0; i < 256; i++) {
+        count += hist[i];
+        sum += (uint64_t)i * hist[i];
+    }
 
-    // Not yet implemented
-    // ********************************************
-    // Added to prevent compiler warnings
-    // Remove these when implementation starts
-    (void)img;
+    // The level with the largest variance between both classes. Every level
+    // adds one bin to the dark class, so a single pass over the bins will do.
+    for (i = 0; i < 255; i++) {
+        uint64_t countHigh;
+        double meanLow;
+        double meanHigh;
+        double variance;
+
+        countLow += hist[i];
+        sumLow += (uint64_t)i * hist[i];
+        countHigh = count - countLow;
+        if (countLow == 0 || countHigh == 0) {
+            continue;
+        }
+        meanLow = (double)sumLow / countLow;
+        meanHigh = (double)(sum - sumLow) / countHigh;
+        variance = (double)countLow * countHigh * (meanLow - meanHigh) * (meanLow - meanHigh);
+        if (variance > best) {
+            best = variance;
+            level = i;
+        }
+    }
 
-    return;
-    // ********************************************
+    return (basic_pixel_t)level;
+}
+
+// ----------------------------------------------------------------------------
+// Miscellaneous
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void erase_basic(const image_t* img)
+{
+    memset(img->data, 0, img->rows * img->cols * sizeof(basic_pixel_t));
 }
 
 // ----------------------------------------------------------------------------
@@ -373,16 +460,43 @@ uint32_t neighbourCount_basic(const image_t* img,
 // ----------------------------------------------------------------------------
 void histogram_basic(const image_t* img, uint16_t* hist)
 {
+    uint32_t wide[256];
+    uint32_t i;
 
-    // Not yet implemented
-    // ********************************************
-    // Added to prevent compiler warnings
-    // Remove these when implementation starts
-    (void)img;
-    (void)hist;
+    histogram32_basic(img, wide);
 
-    return;
-    // ********************************************
+    // Bins saturate instead of wrapping around
+    for (i = 0; i < 256; i++) {
+        hist[i] = wide[i] > 0xFFFF ? 0xFFFF : (uint16_t)wide[i];
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void histogram32_basic(const image_t* img, uint32_t* hist)
+{
+    // Four partial histograms, so consecutive equal pixels don't wait for
+    // each other's increment of the same bin
+    uint32_t partial[4][256] = { { 0 } };
+    register long int i = img->rows * img->cols;
+    register basic_pixel_t* s = (basic_pixel_t*)img->data;
+    uint32_t bin;
+
+    while (i >= 4) {
+        partial[0][s[0]]++;
+        partial[1][s[1]]++;
+        partial[2][s[2]]++;
+        partial[3][s[3]]++;
+        s += 4;
+        i -= 4;
+    }
+    while (i-- > 0) {
+        partial[0][*s++]++;
+    }
+
+    for (bin = 0; bin < 256; bin++) {
+        hist[bin] = partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -632,6 +746,29 @@ void scaleImage_basic(const image_t* src, image_t* dst)
     return;
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void downscale_basic(const image_t* src, image_t* dst, const uint8_t factor)
+{
+    const uint32_t area = (uint32_t)factor * factor;
+    basic_pixel_t* d = (basic_pixel_t*)dst->data;
+
+    for (int32_t row = 0; row < dst->rows; row++) {
+        const basic_pixel_t* block = (const basic_pixel_t*)src->data + row * factor * src->cols;
+        for (int32_t col = 0; col < dst->cols; col++) {
+            uint32_t sum = 0;
+            for (int32_t blockRow = 0; blockRow < factor; blockRow++) {
+                const basic_pixel_t* s = block + blockRow * src->cols;
+                for (int32_t blockCol = 0; blockCol < factor; blockCol++) {
+                    sum += s[blockCol];
+                }
+            }
+            *d++ = (basic_pixel_t)((sum + area / 2) / area);
+            block += factor;
+        }
+    }
+}
+
 void clear_center_basic(image_t* src)
 {
     uint16_t c;
@@ -779,6 +916,277 @@ void Corner_basic(const image_t* src, image_t* dst, const uint8_t blockSize, con
     return;
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+corner_scratch_t* newCornerScratch(const uint32_t cols, const uint32_t rows)
+{
+    corner_scratch_t* scratch = (corner_scratch_t*)malloc(sizeof(corner_scratch_t));
+    if (scratch == NULL) {
+        return NULL;
+    }
+
+    scratch->capacity = (int32_t)(cols * rows);
+    scratch->cols = (int32_t)cols;
+    scratch->products = (int32_t*)malloc(3 * cols * rows * sizeof(int32_t));
+    // Only the three products of the row that is being smoothed
+    scratch->line = (int32_t*)malloc(3 * cols * sizeof(int32_t));
+    scratch->responses = (int64_t*)malloc(cols * rows * sizeof(int64_t));
+    if (scratch->products == NULL || scratch->line == NULL || scratch->responses == NULL) {
+        deleteCornerScratch(scratch);
+        return NULL;
+    }
+    return scratch;
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void deleteCornerScratch(corner_scratch_t* scratch)
+{
+    if (scratch == NULL) {
+        return;
+    }
+    free(scratch->products);
+    free(scratch->line);
+    free(scratch->responses);
+    free(scratch);
+}
+
+// Gaussian kernels with sigma 1 for 3, 5 and 7 taps in 8-bit fixed point, from the center out
+static const int32_t cornerKernel3[] = { 114, 71 };
+static const int32_t cornerKernel5[] = { 100, 62, 16 };
+static const int32_t cornerKernel7[] = { 100, 62, 15, 1 };
+
+// Applies a symmetric kernel around center, with samples step apart.
+// The taps are written out, so there is no loop per sample.
+static inline int32_t cornerTaps(const int32_t* center, const int32_t step, const int32_t* kernel, const int32_t radius)
+{
+    int32_t sum = kernel[0] * center[0];
+    switch (radius) {
+    case 3:
+        sum += kernel[3] * (center[-3 * step] + center[3 * step]);
+        /* fall through */
+    case 2:
+        sum += kernel[2] * (center[-2 * step] + center[2 * step]);
+        /* fall through */
+    default:
+        sum += kernel[1] * (center[-step] + center[step]);
+        break;
+    }
+    return sum;
+}
+
+static uint64_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Keeps the strongest corners in a min-heap, so the weakest kept corner is
+// always on top and the selection costs log(maxCorners) per candidate
+static void cornerHeapDown(corner_t* heap, uint32_t count, uint32_t i)
+{
+    for (;;) {
+        uint32_t smallest = i;
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        if (left < count && heap[left].response < heap[smallest].response) {
+            smallest = left;
+        }
+        if (right < count && heap[right].response < heap[smallest].response) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        corner_t swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+static void cornerHeapUp(corner_t* heap, uint32_t i)
+{
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (heap[parent].response <= heap[i].response) {
+            return;
+        }
+        corner_t swap = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = swap;
+        i = parent;
+    }
+}
+
+// Whether the response at index is the strongest within distance pixels in
+// first..last rows and cols. Of equal responses the first in raster order wins.
+static int cornerIsMaximum(const int64_t* responses, int32_t cols, int32_t c, int32_t r, int32_t distance, int32_t first, int32_t lastCol, int32_t lastRow)
+{
+    const int64_t response = responses[r * cols + c];
+    const int32_t top = r - distance < first ? first : r - distance;
+    const int32_t bottom = r + distance > lastRow ? lastRow : r + distance;
+    const int32_t left = c - distance < first ? first : c - distance;
+    const int32_t right = c + distance > lastCol ? lastCol : c + distance;
+
+    for (int32_t row = top; row <= bottom; row++) {
+        const int64_t* line = responses + row * cols;
+        for (int32_t col = left; col <= right; col++) {
+            int before = row < r || (row == r && col < c);
+            if (line[col] > response || (before && line[col] == response)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+uint32_t cornerResponse_basic(const image_t* src, corner_scratch_t* scratch, const eCornerMethod method, const uint8_t ksize, const float k, const uint8_t minDistance, corner_t* corners, const uint32_t maxCorners)
+{
+    const int32_t cols = src->cols;
+    const int32_t rows = src->rows;
+    const int32_t radius = ksize / 2;
+    const int32_t* kernel = ksize == 3 ? cornerKernel3 : (ksize == 5 ? cornerKernel5 : cornerKernel7);
+    const int32_t stride = 3 * cols;
+    const int64_t k16 = (int64_t)(k * 65536.0f);
+    const basic_pixel_t* s = (const basic_pixel_t*)src->data;
+    int32_t* products = scratch->products;
+    int64_t* responses = scratch->responses;
+    int32_t* lxx = scratch->line;
+    int32_t* lyy = lxx + cols;
+    int32_t* lxy = lyy + cols;
+    basic_pixel_t low = 255;
+    basic_pixel_t high = 0;
+    int32_t maxGradient;
+    int32_t shift;
+    uint32_t count = 0;
+
+    // The kernels need the rows around every row, and the line holds three products per pixel of a row
+    if (cols < 2 * radius + 3 || rows < 2 * radius + 3 || maxCorners == 0) {
+        return 0;
+    }
+
+    // Sobel gradients reach four times the contrast of the image. Two passes
+    // of a kernel that sums to 256 multiply by 65536, so the products of
+    // strong gradients are scaled down once to keep the response within
+    // 64 bits. Weak gradients, e.g. of a binary image, keep all of their
+    // precision.
+    for (int32_t i = 0; i < cols * rows; i++) {
+        low = s[i] < low ? s[i] : low;
+        high = s[i] > high ? s[i] : high;
+    }
+    maxGradient = 4 * (high - low);
+    shift = maxGradient * maxGradient < 8192 ? 0 : 8;
+
+    // 1. Products of the Sobel gradients of a row into the line
+    // 2. Horizontal Gaussian of the line into the products. The three
+    //    products of a pixel lie next to each other, so the vertical Gaussian
+    //    reads one stream per row of the kernel. The first and last rows and
+    //    the cols the kernel can't reach are never read.
+    for (int32_t r = 1; r < rows - 1; r++) {
+        const basic_pixel_t* up = s + (r - 1) * cols;
+        const basic_pixel_t* mid = up + cols;
+        const basic_pixel_t* down = mid + cols;
+        int32_t* d = products + r * stride;
+        lxx[0] = lyy[0] = lxy[0] = 0;
+        lxx[cols - 1] = lyy[cols - 1] = lxy[cols - 1] = 0;
+        for (int32_t c = 1; c < cols - 1; c++) {
+            int32_t dx = (up[c + 1] + 2 * mid[c + 1] + down[c + 1]) - (up[c - 1] + 2 * mid[c - 1] + down[c - 1]);
+            int32_t dy = (down[c - 1] + 2 * down[c] + down[c + 1]) - (up[c - 1] + 2 * up[c] + up[c + 1]);
+            lxx[c] = dx * dx;
+            lyy[c] = dy * dy;
+            lxy[c] = dx * dy;
+        }
+        for (int32_t c = radius; c < cols - radius; c++) {
+            int32_t sxx = cornerTaps(lxx + c, 1, kernel, radius);
+            int32_t syy = cornerTaps(lyy + c, 1, kernel, radius);
+            int32_t sxy = cornerTaps(lxy + c, 1, kernel, radius);
+            d[3 * c] = sxx >> shift;
+            d[3 * c + 1] = syy >> shift;
+            d[3 * c + 2] = sxy >> shift;
+        }
+    }
+
+    // 3. Vertical Gaussian and the response, skipping what the kernels can't reach.
+    //    Flat pixels and edges get 0.
+    for (int32_t r = radius + 1; r < rows - radius - 1; r++) {
+        for (int32_t c = radius + 1; c < cols - radius - 1; c++) {
+            const int32_t* p = products + r * stride + 3 * c;
+            int32_t sxx = cornerTaps(p, stride, kernel, radius);
+            int32_t syy = cornerTaps(p + 1, stride, kernel, radius);
+            int32_t sxy = cornerTaps(p + 2, stride, kernel, radius);
+            int64_t response;
+            if (sxx == 0 && syy == 0) {
+                // Flat
+                responses[r * cols + c] = 0;
+                continue;
+            }
+
+            if (method == CORNER_HARRIS) {
+                int64_t trace = (int64_t)sxx + syy;
+                response = (int64_t)sxx * syy - (int64_t)sxy * sxy - ((trace * k16) >> 16) * trace;
+            } else {
+                // Smallest eigenvalue (trace - sqrt((xx - yy)^2 + 4 xy^2)) / 2
+                int64_t diff = (int64_t)sxx - syy;
+                uint64_t root = isqrt64((uint64_t)(diff * diff) + 4 * (uint64_t)((int64_t)sxy * sxy));
+                response = ((int64_t)sxx + syy - (int64_t)root) / 2;
+            }
+            responses[r * cols + c] = response > 0 ? response : 0;
+        }
+    }
+
+    // 4. Keep the strongest corners that are the maximum of their surroundings
+    for (int32_t r = radius + 1; r < rows - radius - 1; r++) {
+        for (int32_t c = radius + 1; c < cols - radius - 1; c++) {
+            int64_t response = responses[r * cols + c];
+            if (response == 0 || (count == maxCorners && response <= corners[0].response)) {
+                continue;
+            }
+            if (minDistance > 0 && !cornerIsMaximum(responses, cols, c, r, minDistance, radius + 1, cols - radius - 2, rows - radius - 2)) {
+                continue;
+            }
+
+            if (count < maxCorners) {
+                corners[count].col = c;
+                corners[count].row = r;
+                corners[count].response = response;
+                cornerHeapUp(corners, count);
+                count++;
+            } else if (response > corners[0].response) {
+                corners[0].col = c;
+                corners[0].row = r;
+                corners[0].response = response;
+                cornerHeapDown(corners, count, 0);
+            }
+        }
+    }
+
+    // Strongest first: move the weakest to the back one by one
+    for (uint32_t n = count; n > 1; n--) {
+        corner_t swap = corners[0];
+        corners[0] = corners[n - 1];
+        corners[n - 1] = swap;
+        cornerHeapDown(corners, n - 1, 0);
+    }
+    return count;
+}
+
 uint8_t max_basic(const image_t* src)
 {
     uint16_t c;
@@ -63,6 +63,12 @@ void threshold2Means_basic(const image_t* src, image_t* dst, const eBrightness b
 
 void thresholdOtsu_basic(const image_t* src, image_t* dst, const eBrightness brightness);
 
+void thresholdLevel_basic(const image_t* src, image_t* dst, const basic_pixel_t level, const eBrightness brightness);
+
+basic_pixel_t threshold2MeansLevel_basic(const uint32_t* hist);
+
+basic_pixel_t thresholdOtsuLevel_basic(const uint32_t* hist);
+
 // ----------------------------------------------------------------------------
 // Miscellaneous
 // ----------------------------------------------------------------------------
@@ -77,6 +83,8 @@ uint32_t neighbourCount_basic(const image_t* img, const int32_t c, const int32_t
 
 void histogram_basic(const image_t* img, uint16_t* hist);
 
+void histogram32_basic(const image_t* img, uint32_t* hist);
+
 // ----------------------------------------------------------------------------
 // Arithmetic
 // ----------------------------------------------------------------------------
@@ -123,10 +131,18 @@ float normalizedCentralMoments_basic(const image_t* img, const uint8_t blobnr, c
 
 void scaleImage_basic(const image_t* src, image_t* dst);
 
+void downscale_basic(const image_t* src, image_t* dst, const uint8_t factor);
+
 void clear_center_basic(image_t *src);
 
 void Corner_basic(const image_t* src, image_t* dst, const uint8_t blockSize, const uint8_t ksize, const float k, const uint8_t method);
 
+corner_scratch_t* newCornerScratch(const uint32_t cols, const uint32_t rows);
+
+void deleteCornerScratch(corner_scratch_t* scratch);
+
+uint32_t cornerResponse_basic(const image_t* src, corner_scratch_t* scratch, const eCornerMethod method, const uint8_t ksize, const float k, const uint8_t minDistance, corner_t* corners, const uint32_t maxCorners);
+
 uint8_t max_basic(const image_t* src);
 
 void add_basic_value( const image_t *src, uint8_t value);
@@ -0,0 +1,522 @@
+/******************************************************************************
+ * Project    : Embedded Vision Design
+ * Copyright  : 2019 HAN Electrical and Electronic Engineering
+ *
+ * Description: Implementation file for packed binary image operators
+ *
+ * Copyright (C) 2019 HAN University of Applied Sciences. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+******************************************************************************/
+#include "operators_binary.h"
+#include <string.h>
+
+#ifdef STM32F746xx
+#include "mem_manager.h"
+#endif
+
+// ----------------------------------------------------------------------------
+// Function implementations
+// ----------------------------------------------------------------------------
+
+static const binary_word_t BINARY_ONES = ~(binary_word_t)0;
+
+// Valid bits of the last word of a row
+static inline binary_word_t lastWordMask(int32_t cols)
+{
+    int32_t bits = cols % BINARY_WORD_BITS;
+    return bits == 0 ? BINARY_ONES : (((binary_word_t)1 << bits) - 1);
+}
+
+static inline binary_word_t* binaryRow(const image_t* img, int32_t row)
+{
+    return (binary_word_t*)img->data + row * BINARY_WORDS_PER_ROW(img->cols);
+}
+
+static inline uint32_t popcount64(binary_word_t word)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (uint32_t)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+image_t* newBinaryImage(const uint32_t cols, const uint32_t rows)
+{
+    image_t* img = (image_t*)malloc(sizeof(image_t));
+    if (img == NULL) {
+        // Unable to allocate memory for new image
+        return NULL;
+    }
+
+#ifdef STM32F746xx
+    img->data = mem_manager_alloc();
+#else
+    img->data = (uint8_t*)malloc(rows * BINARY_WORDS_PER_ROW(cols) * sizeof(binary_word_t));
+#endif
+
+    if (img->data == NULL) {
+        // Unable to allocate memory for data
+        free(img);
+        return NULL;
+    }
+
+    img->cols = cols;
+    img->rows = rows;
+    img->view = IMGVIEW_BINARY;
+    img->type = IMGTYPE_BINARY;
+    erase_binary(img);
+    return (img);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+image_t* toBinaryImage(image_t* src)
+{
+    image_t* dst = newBinaryImage(src->cols, src->rows);
+    if (dst == NULL)
+        return NULL;
+
+    convertToBinaryImage(src, dst);
+
+    return dst;
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void deleteBinaryImage(image_t* img)
+{
+#ifdef STM32F746xx
+    mem_manager_free(img->data);
+#else
+    free(img->data);
+#endif
+
+    free(img);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void convertToBinaryImage(const image_t* src, image_t* dst)
+{
+    dst->cols = src->cols;
+    dst->rows = src->rows;
+
+    switch (src->type) {
+    case IMGTYPE_BASIC:
+        // Every pixel that is not 0 is set
+        threshold_binary(src, dst, 0, 0, 1);
+        break;
+    case IMGTYPE_BINARY:
+        copy_binary(src, dst);
+        break;
+    default:
+        dbg_printf("convertToBinaryImage: image type %d not supported\n", src->type);
+        break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Thresholding
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void threshold_binary(const image_t* src, image_t* dst, const basic_pixel_t low, const basic_pixel_t high, const uint8_t output)
+{
+    if (dst->type != IMGTYPE_BINARY) {
+        dbg_printf("threshold_binary: dst is not of type binary but of type %d\n", dst->type);
+        return;
+    }
+
+    // Same as threshold_basic(): pixels between low and high become 0, the others output
+    const binary_word_t set = output ? BINARY_ONES : 0;
+    const int32_t words = BINARY_WORDS_PER_ROW(src->cols);
+    const basic_pixel_t* s = (const basic_pixel_t*)src->data;
+
+    for (int32_t row = 0; row < src->rows; row++) {
+        binary_word_t* d = binaryRow(dst, row);
+        for (int32_t word = 0; word < words; word++) {
+            int32_t bits = src->cols - word * BINARY_WORD_BITS;
+            if (bits > BINARY_WORD_BITS) {
+                bits = BINARY_WORD_BITS;
+            }
+            binary_word_t value = 0;
+            for (int32_t bit = 0; bit < bits; bit++) {
+                binary_word_t outside = (s[bit] < low) | (s[bit] > high);
+                value |= outside << bit;
+            }
+            d[word] = value & set;
+            s += bits;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void thresholdAdaptive_binary(const image_t* src, image_t* dst, const uint8_t radius, const int32_t offset, const eBrightness brightness)
+{
+    if (dst->type != IMGTYPE_BINARY) {
+        dbg_printf("thresholdAdaptive_binary: dst is not of type binary but of type %d\n", dst->type);
+        return;
+    }
+
+    const int32_t cols = src->cols;
+    const int32_t rows = src->rows;
+    const int32_t words = BINARY_WORDS_PER_ROW(cols);
+    const basic_pixel_t* s = (const basic_pixel_t*)src->data;
+
+    // Sums of every column over the rows of the window, which moves down one row at a time
+    uint32_t* columns = (uint32_t*)calloc(cols, sizeof(uint32_t));
+    if (columns == NULL) {
+        return;
+    }
+    int32_t windowTop = 0;
+    int32_t windowBottom = 0;
+
+    for (int32_t row = 0; row < rows; row++) {
+        const int32_t top = row - radius > 0 ? row - radius : 0;
+        const int32_t bottom = row + radius + 1 < rows ? row + radius + 1 : rows;
+        for (; windowBottom < bottom; windowBottom++) {
+            for (int32_t col = 0; col < cols; col++) {
+                columns[col] += s[windowBottom * cols + col];
+            }
+        }
+        for (; windowTop < top; windowTop++) {
+            for (int32_t col = 0; col < cols; col++) {
+                columns[col] -= s[windowTop * cols + col];
+            }
+        }
+        const int64_t height = bottom - top;
+
+        // The window moves right one column at a time
+        uint32_t sum = 0;
+        for (int32_t col = 0; col <= radius && col < cols; col++) {
+            sum += columns[col];
+        }
+        const basic_pixel_t* p = s + row * cols;
+        binary_word_t* d = binaryRow(dst, row);
+        for (int32_t word = 0; word < words; word++) {
+            binary_word_t value = 0;
+            for (int32_t bit = 0; bit < BINARY_WORD_BITS; bit++) {
+                const int32_t col = word * BINARY_WORD_BITS + bit;
+                if (col >= cols) {
+                    break;
+                }
+                if (col > 0) {
+                    if (col + radius < cols) {
+                        sum += columns[col + radius];
+                    }
+                    if (col - radius - 1 >= 0) {
+                        sum -= columns[col - radius - 1];
+                    }
+                }
+                const int32_t left = col - radius > 0 ? col - radius : 0;
+                const int32_t right = col + radius < cols - 1 ? col + radius : cols - 1;
+                // Compared to the mean of the window without dividing
+                const int64_t area = (right - left + 1) * height;
+                const binary_word_t set = brightness == DARK ? (p[col] + offset) * area < (int64_t)sum
+                                                             : (p[col] - offset) * area > (int64_t)sum;
+                value |= set << bit;
+            }
+            d[word] = value;
+        }
+    }
+    free(columns);
+}
+
+// ----------------------------------------------------------------------------
+// Miscellaneous
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void erase_binary(const image_t* img)
+{
+    memset(img->data, 0, img->rows * BINARY_WORDS_PER_ROW(img->cols) * sizeof(binary_word_t));
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void copy_binary(const image_t* src, image_t* dst)
+{
+    dst->rows = src->rows;
+    dst->cols = src->cols;
+    dst->type = src->type;
+    dst->view = src->view;
+
+    if (src != dst) {
+        memcpy(dst->data, src->data, src->rows * BINARY_WORDS_PER_ROW(src->cols) * sizeof(binary_word_t));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+uint32_t pixelCount_binary(const image_t* img, const basic_pixel_t value)
+{
+    const int32_t words = img->rows * BINARY_WORDS_PER_ROW(img->cols);
+    const binary_word_t* s = (const binary_word_t*)img->data;
+    uint32_t count = 0;
+
+    for (int32_t i = 0; i < words; i++) {
+        count += popcount64(s[i]);
+    }
+    if (value == 0) {
+        return (uint32_t)(img->rows * img->cols) - count;
+    }
+    return value == 1 ? count : 0;
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void scaleImage_binary(const image_t* src, image_t* dst)
+{
+    float scaleFactorX = (float)src->cols / (float)dst->cols;
+    float scaleFactorY = (float)src->rows / (float)dst->rows;
+
+    for (int row = 0; row < dst->rows; row++) {
+        int srcRow = (int)((float)row * scaleFactorY);
+        for (int col = 0; col < dst->cols; col++) {
+            int srcCol = (int)((float)col * scaleFactorX);
+            if (dst->type == IMGTYPE_BINARY) {
+                setBinaryPixel(dst, col, row, getBinaryPixel(src, srcCol, srcRow));
+            } else {
+                setBasicPixel(dst, col, row, getBinaryPixel(src, srcCol, srcRow));
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void clear_center_binary(image_t* img)
+{
+    // The same pixels as clear_center_basic()
+    const int32_t first = img->cols / 3;
+    const int32_t last = img->cols / 3 * 2;
+
+    for (int32_t row = img->rows / 3; row < img->rows / 3 * 2; row++) {
+        binary_word_t* d = binaryRow(img, row);
+        for (int32_t col = first; col < last;) {
+            int32_t word = col / BINARY_WORD_BITS;
+            int32_t end = (word + 1) * BINARY_WORD_BITS < last ? (word + 1) * BINARY_WORD_BITS : last;
+            binary_word_t bits = end - col == BINARY_WORD_BITS ? BINARY_ONES : (((binary_word_t)1 << (end - col)) - 1);
+            d[word] |= bits << (col % BINARY_WORD_BITS);
+            col = end;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Arithmetic
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void invert_binary(const image_t* src, image_t* dst)
+{
+    const int32_t words = BINARY_WORDS_PER_ROW(src->cols);
+    const binary_word_t mask = lastWordMask(src->cols);
+
+    for (int32_t row = 0; row < src->rows; row++) {
+        const binary_word_t* s = binaryRow(src, row);
+        binary_word_t* d = binaryRow(dst, row);
+        for (int32_t word = 0; word < words; word++) {
+            d[word] = ~s[word];
+        }
+        d[words - 1] &= mask;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Morphology
+// ----------------------------------------------------------------------------
+
+// Word i of the row moved by shift pixels: bit b is pixel i * 64 + b + shift.
+// Pixels outside of the row are 1.
+static inline binary_word_t shiftedWord(const binary_word_t* line, int32_t words, int32_t i, int32_t shift)
+{
+    int32_t quotient = shift >= 0 ? shift / BINARY_WORD_BITS : -((-shift + BINARY_WORD_BITS - 1) / BINARY_WORD_BITS);
+    int32_t remainder = shift - quotient * BINARY_WORD_BITS;
+    int32_t first = i + quotient;
+    binary_word_t low = (first >= 0 && first < words) ? line[first] : BINARY_ONES;
+    if (remainder == 0) {
+        return low;
+    }
+    binary_word_t high = (first + 1 >= 0 && first + 1 < words) ? line[first + 1] : BINARY_ONES;
+    return (low >> remainder) | (high << (BINARY_WORD_BITS - remainder));
+}
+
+// The largest kernelSize, the padding the scratch has room for
+#define BINARY_MAX_KERNEL 255
+#define BINARY_MAX_PAD_WORDS (BINARY_MAX_KERNEL / BINARY_WORD_BITS + 1)
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+binary_scratch_t* newBinaryScratch(const uint32_t cols, const uint32_t rows)
+{
+    binary_scratch_t* scratch = (binary_scratch_t*)malloc(sizeof(binary_scratch_t));
+    if (scratch == NULL) {
+        return NULL;
+    }
+
+    const uint32_t words = BINARY_WORDS_PER_ROW(cols);
+    scratch->cols = (int32_t)cols;
+    scratch->rows = (int32_t)rows;
+    scratch->runs = (binary_word_t*)malloc((rows + 2 * BINARY_MAX_KERNEL) * words * sizeof(binary_word_t));
+    scratch->line = (binary_word_t*)malloc(2 * (words + 2 * BINARY_MAX_PAD_WORDS) * sizeof(binary_word_t));
+    if (scratch->runs == NULL || scratch->line == NULL) {
+        deleteBinaryScratch(scratch);
+        return NULL;
+    }
+    return scratch;
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void deleteBinaryScratch(binary_scratch_t* scratch)
+{
+    if (scratch == NULL) {
+        return;
+    }
+    free(scratch->runs);
+    free(scratch->line);
+    free(scratch);
+}
+
+// Erodes with the pixels [first, first + size> of every row and col around a pixel.
+// Runs of 1, 2, 4, ... pixels are ANDed together, so a row or col pass takes
+// log2(size) steps over the words, after which two overlapping runs cover the
+// element. The rows and cols are padded with 1 on both sides, so runs that
+// start outside of the image still cover the pixels inside of it.
+static void erodeRange(const image_t* src, image_t* dst, int32_t size, int32_t first, binary_scratch_t* scratch)
+{
+    const int32_t words = BINARY_WORDS_PER_ROW(src->cols);
+    const int32_t rows = src->rows;
+    const int32_t padWords = size / BINARY_WORD_BITS + 1;
+    const int32_t lineWords = words + 2 * padWords;
+    const binary_word_t mask = lastWordMask(src->cols);
+    binary_word_t* runs = scratch->runs;
+    binary_word_t* line = scratch->line;
+    binary_word_t* next = line + lineWords;
+
+    int32_t span = 1;
+    while (span * 2 <= size) {
+        span *= 2;
+    }
+
+    // Along the rows. Bits past the last col are 1 while eroding.
+    for (int32_t word = 0; word < lineWords; word++) {
+        line[word] = BINARY_ONES;
+    }
+    for (int32_t row = 0; row < rows; row++) {
+        memcpy(line + padWords, binaryRow(src, row), words * sizeof(binary_word_t));
+        line[padWords + words - 1] |= ~mask;
+        for (int32_t run = 1; run < span; run *= 2) {
+            for (int32_t word = 0; word < lineWords; word++) {
+                next[word] = line[word] & shiftedWord(line, lineWords, word, run);
+            }
+            memcpy(line, next, lineWords * sizeof(binary_word_t));
+        }
+        binary_word_t* r = runs + (size + row) * words;
+        for (int32_t word = 0; word < words; word++) {
+            r[word] = shiftedWord(line, lineWords, padWords + word, first) & shiftedWord(line, lineWords, padWords + word, first + size - span);
+        }
+        // Runs of 1 in the padding are 1 again
+        for (int32_t word = 0; word < padWords; word++) {
+            line[word] = BINARY_ONES;
+            line[padWords + words + word] = BINARY_ONES;
+        }
+    }
+
+    // Along the cols, a whole row of words at a time
+    for (int32_t word = 0; word < size * words; word++) {
+        runs[word] = BINARY_ONES;
+        runs[(size + rows) * words + word] = BINARY_ONES;
+    }
+    for (int32_t run = 1; run < span; run *= 2) {
+        for (int32_t row = 0; row + run < rows + 2 * size; row++) {
+            binary_word_t* r = runs + row * words;
+            const binary_word_t* below = r + run * words;
+            for (int32_t word = 0; word < words; word++) {
+                r[word] &= below[word];
+            }
+        }
+    }
+    for (int32_t row = 0; row < rows; row++) {
+        const binary_word_t* top = runs + (size + row + first) * words;
+        const binary_word_t* bottom = runs + (size + row + first + size - span) * words;
+        binary_word_t* d = binaryRow(dst, row);
+        for (int32_t word = 0; word < words; word++) {
+            d[word] = top[word] & bottom[word];
+        }
+        d[words - 1] &= mask;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void binaryErode_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    if (kernelSize == 0) {
+        copy_binary(src, dst);
+        return;
+    }
+    erodeRange(src, dst, kernelSize, -(kernelSize / 2), scratch);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void binaryDilate_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    if (kernelSize == 0) {
+        copy_binary(src, dst);
+        return;
+    }
+    // The dilation is the inverted erosion of the inverted image with the mirrored element
+    invert_binary(src, dst);
+    erodeRange(dst, dst, kernelSize, -(kernelSize - 1 - kernelSize / 2), scratch);
+    invert_binary(dst, dst);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void binaryOpen_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    binaryErode_binary(src, dst, kernelSize, scratch);
+    binaryDilate_binary(dst, dst, kernelSize, scratch);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void binaryClose_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch)
+{
+    binaryDilate_binary(src, dst, kernelSize, scratch);
+    binaryErode_binary(dst, dst, kernelSize, scratch);
+}
+
+// ----------------------------------------------------------------------------
+// EOF
+// ----------------------------------------------------------------------------
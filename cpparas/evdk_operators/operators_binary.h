@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Project    : Embedded Vision Design
+ * Copyright  : 2019 HAN Electrical and Electronic Engineering
+ *
+ * Description: Header file for packed binary image operators
+ *
+ * Copyright (C) 2019 HAN University of Applied Sciences. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+******************************************************************************/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _OPERATORS_BINARY_H_
+#define _OPERATORS_BINARY_H_
+
+#include "operators.h"
+
+// ----------------------------------------------------------------------------
+// Function prototypes
+// ----------------------------------------------------------------------------
+
+// NOTE: src must be a basic image
+void threshold_binary(const image_t* src, image_t* dst, const basic_pixel_t low, const basic_pixel_t high, const uint8_t output);
+
+// NOTE: src must be a basic image
+void thresholdAdaptive_binary(const image_t* src, image_t* dst, const uint8_t radius, const int32_t offset, const eBrightness brightness);
+
+void erase_binary(const image_t* img);
+
+void copy_binary(const image_t* src, image_t* dst);
+
+void invert_binary(const image_t* src, image_t* dst);
+
+binary_scratch_t* newBinaryScratch(const uint32_t cols, const uint32_t rows);
+
+void deleteBinaryScratch(binary_scratch_t* scratch);
+
+void binaryErode_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+
+void binaryDilate_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+
+void binaryOpen_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+
+void binaryClose_binary(const image_t* src, image_t* dst, uint8_t kernelSize, binary_scratch_t* scratch);
+
+uint32_t pixelCount_binary(const image_t* img, const basic_pixel_t value);
+
+// NOTE: dst must be a basic or binary image
+void scaleImage_binary(const image_t* src, image_t* dst);
+
+void clear_center_binary(image_t* img);
+
+#endif // _OPERATORS_BINARY_H_
+#ifdef __cplusplus
+}
+#endif
+// ----------------------------------------------------------------------------
+// EOF
+// ----------------------------------------------------------------------------
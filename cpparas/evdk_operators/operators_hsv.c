@@ -101,6 +101,54 @@ void deleteHSVImage(image_t* img)
     free(img);
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+hsv_pixel_t rgb888ToHSV(const rgb888_pixel_t pixel)
+{
+    hsv_pixel_t d;
+    float min, max, delta;
+
+    //Formulas taken from https://www.rapidtables.com/convert/color/rgb-to-hsv.html
+    //Change R,G,B ranges from 0-255 to 0-1
+    float r_ = (float)pixel.r / 255.0f;
+    float g_ = (float)pixel.g / 255.0f;
+    float b_ = (float)pixel.b / 255.0f;
+
+    //find max and min values between R,G,B
+    max = ((r_ > g_ ? r_ : g_) > b_ ? (r_ > g_ ? r_ : g_) : b_);
+    min = ((r_ < g_ ? r_ : g_) < b_ ? (r_ < g_ ? r_ : g_) : b_);
+    delta = max - min;
+
+    //Calculate Hue, gray has none
+    double h;
+    if (delta == 0.0f) {
+        h = 0.0;
+    } else if (max == r_) {
+        h = (fmod(((g_ - b_) / delta), 6.0f)) * 60.0f;
+    } else if (max == g_) {
+        h = (((b_ - r_) / delta) + 2.0f) * 60.0f;
+    } else {
+        h = (((r_ - g_) / delta) + 4.0f) * 60.0f;
+    }
+    int32_t hue = (int32_t)h;
+    if (hue < 0) {
+        hue += 360;
+    }
+    d.h = hue;
+
+    //Calculate Saturation
+    if (max == 0.0f) {
+        d.s = 0;
+    } else {
+        d.s = ((delta / max) * 100.0f);
+    }
+
+    //Calculate Value
+    d.v = (max * 100.0f);
+
+    return d;
+}
+
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 void convertToHSVImage(const image_t* src, image_t* dst)
@@ -128,52 +176,10 @@ void convertToHSVImage(const image_t* src, image_t* dst)
 
     } break;
     case IMGTYPE_RGB888: {
-        // TODO
         rgb888_pixel_t* s = (rgb888_pixel_t*)src->data;
         // Loop all pixels, convert and copy
-        //Formulas taken from https://www.rapidtables.com/convert/color/rgb-to-hsv.html
         while (i-- > 0) {
-            unsigned char r = s->r;
-            unsigned char g = s->g;
-            unsigned char b = s->b;
-
-            float min, max, delta;
-
-            //Change R,G,B ranges from 0-255 to 0-1
-            float r_ = (float)r / 255.0f;
-            float g_ = (float)g / 255.0f;
-            float b_ = (float)b / 255.0f;
-
-            //find max and min values between R,G,B
-            max = ((r_ > g_ ? r_ : g_) > b_ ? (r_ > g_ ? r_ : g_) : b_);
-            min = ((r_ < g_ ? r_ : g_) < b_ ? (r_ < g_ ? r_ : g_) : b_);
-            delta = max - min;
-
-            //Calculate Hue
-            if (max == r_) {
-                d->h = (fmod(((g_ - b_) / delta), 6.0f)) * 60.0f;
-            } else if (max == g_) {
-                d->h = (((b_ - r_) / delta) + 2.0f) * 60.0f;
-            } else {
-                d->h = (((r_ - g_) / delta) + 4.0f) * 60.0f;
-            }
-
-            if (d->h > 360) {
-                d->h = 360 - (0 - d->h);
-            }
-
-            //Calculate Saturation
-            if (max == 0.0f) {
-                d->s = 0;
-            } else {
-                d->s = ((delta / max) * 100.0f);
-            }
-
-            //Calculate Value
-            d->v = (max * 100.0f);
-
-            d++;
-            s++;
+            *d++ = rgb888ToHSV(*s++);
         }
 
     } break;
@@ -206,8 +212,8 @@ void threshold_hsv(const image_t* src,
     const hsv_pixel_t low,
     const hsv_pixel_t high)
 {
-    if (dst->type != IMGTYPE_BASIC) {
-        dbg_printf("threshold_hsv: dst is not of type basic but of type %d\n", dst->type);
+    if (dst->type != IMGTYPE_BASIC && dst->type != IMGTYPE_BINARY) {
+        dbg_printf("threshold_hsv: dst is not of type basic or binary but of type %d\n", dst->type);
         return;
     }
 
@@ -215,6 +221,24 @@ void threshold_hsv(const image_t* src,
     register hsv_pixel_t* s = (hsv_pixel_t*)src->data;
     register basic_pixel_t* d = (basic_pixel_t*)dst->data;
 
+    if (dst->type == IMGTYPE_BINARY) {
+        // Packed 64 pixels to a word
+        binary_word_t* w = (binary_word_t*)dst->data;
+        for (int32_t row = 0; row < src->rows; row++) {
+            for (int32_t col = 0; col < src->cols; col += BINARY_WORD_BITS) {
+                binary_word_t word = 0;
+                for (int32_t bit = 0; bit < BINARY_WORD_BITS && col + bit < src->cols; bit++) {
+                    hsv_pixel_t value = *s++;
+                    binary_word_t inside = value.h >= low.h && value.s >= low.s && value.v >= low.v
+                        && value.h <= high.h && value.s <= high.s && value.v <= high.v;
+                    word |= inside << bit;
+                }
+                *w++ = word;
+            }
+        }
+        return;
+    }
+
     while (i-- != 0) {
         hsv_pixel_t value = *s++;
         if (value.h >= low.h && value.s >= low.s && value.v >= low.v
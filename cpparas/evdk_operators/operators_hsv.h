@@ -46,9 +46,12 @@ extern "C" {
 // ----------------------------------------------------------------------------
 // Function prototypes
 // ----------------------------------------------------------------------------
-// NOTE: dst must be a basic image
+// NOTE: dst must be a basic or binary image
 void threshold_hsv(const image_t* src, image_t* dst, const hsv_pixel_t low, const hsv_pixel_t high);
 
+// Converts one RGB888 pixel like convertToHSVImage(), e.g. while an image is sampled
+hsv_pixel_t rgb888ToHSV(const rgb888_pixel_t pixel);
+
 void erase_hsv(const image_t* img);
 
 void copy_hsv(const image_t* src, image_t* dst);
@@ -35,6 +35,7 @@
 
 ******************************************************************************/
 #include "operators_rgb888.h"
+#include "operators_hsv.h"
 #include "math.h"
 
 #ifdef STM32F746xx
@@ -240,17 +241,61 @@ static inline float affineTransformY(float x, float y, float warpMatrix[2][3])
     return warpMatrix[1][0] * x + warpMatrix[1][1] * y + warpMatrix[1][2];
 }
 
+// Inverts the matrix of warpMatrixFromCorners(), so every destination pixel can be looked up in the source exactly once.
+// The source col of dst pixel (col, row) is a * col + b * row + tx, the source row c * col + d * row + ty.
+static uint8_t invertWarpMatrix(float warpMatrix[2][3], float inverse[2][3])
+{
+    float det = warpMatrix[0][0] * warpMatrix[1][1] - warpMatrix[0][1] * warpMatrix[1][0];
+    if (det == 0.0f) {
+        return 0;
+    }
+    inverse[0][0] = warpMatrix[1][1] / det;
+    inverse[0][1] = -warpMatrix[0][1] / det;
+    inverse[1][0] = -warpMatrix[1][0] / det;
+    inverse[1][1] = warpMatrix[0][0] / det;
+    inverse[0][2] = -(inverse[0][0] * warpMatrix[0][2] + inverse[0][1] * warpMatrix[1][2]);
+    inverse[1][2] = -(inverse[1][0] * warpMatrix[0][2] + inverse[1][1] * warpMatrix[1][2]);
+    return 1;
+}
+
+// Converts a source position to 16.16 fixed point, far away positions are clamped and fall outside any source.
+static inline int32_t toFixed(float position)
+{
+    if (position < -32768.0f) {
+        return INT32_MIN;
+    }
+    if (position >= 32767.0f) {
+        return INT32_MAX;
+    }
+    return (int32_t)(position * 65536.0f);
+}
+
+// Bilinear interpolation of a 2x2 block in fixed point, with the position in 1/256 pixels
+static inline uint8_t interpolate(int32_t leftTop, int32_t rightTop, int32_t leftBottom, int32_t rightBottom, uint32_t fracCol, uint32_t fracRow)
+{
+    uint32_t top = leftTop * (256 - fracCol) + rightTop * fracCol;
+    uint32_t bottom = leftBottom * (256 - fracCol) + rightBottom * fracCol;
+    return (uint8_t)((top * (256 - fracRow) + bottom * fracRow + 32768) >> 16);
+}
+
 // ----------------------------------------------------------------------------
 // Custom operators
 // ----------------------------------------------------------------------------
-void warp_rgb888(const image_t* img, image_t* dst, int32_t colpos[3], int32_t rowpos[3])
+static void warpMatrixFromSize(const int32_t cols, const int32_t rows, int32_t colpos[3], int32_t rowpos[3], float warpMatrix[2][3]);
+
+void warpMatrixFromCorners(const image_t* dst, int32_t colpos[3], int32_t rowpos[3], float warpMatrix[2][3])
+{
+    warpMatrixFromSize(dst->cols, dst->rows, colpos, rowpos, warpMatrix);
+}
+
+static void warpMatrixFromSize(const int32_t cols, const int32_t rows, int32_t colpos[3], int32_t rowpos[3], float warpMatrix[2][3])
 {
     // Stage one - rotate, scale and translate based on the first two corners.
     float angleSrc = atan2(rowpos[1] - rowpos[0], colpos[1] - colpos[0]);
     int32_t xdiff = colpos[1] - colpos[0];
     int32_t ydiff = rowpos[1] - rowpos[0];
     float lengthSrc = sqrt(xdiff * xdiff + ydiff * ydiff);
-    float lengthDst = dst->cols;
+    float lengthDst = cols;
 
     float angle = -angleSrc;
     float scale = lengthDst / lengthSrc;
@@ -264,47 +309,227 @@ void warp_rgb888(const image_t* img, image_t* dst, int32_t colpos[3], int32_t ro
     warpMatrixStageOne[1][2] = offsetY;
 
     // Stage two - adjust X and Y scale based on third corner.
-    float newScaleX = scale * ((float)dst->cols / affineTransformX(colpos[2], rowpos[2], warpMatrixStageOne));
-    float newScaleY = scale * ((float)dst->rows / affineTransformY(colpos[2], rowpos[2], warpMatrixStageOne));
+    float newScaleX = scale * ((float)cols / affineTransformX(colpos[2], rowpos[2], warpMatrixStageOne));
+    float newScaleY = scale * ((float)rows / affineTransformY(colpos[2], rowpos[2], warpMatrixStageOne));
     float newOffsetX = offsetX * (newScaleX / scale);
     float newOffsetY = offsetY * (newScaleY / scale);
-    float warpMatrixStageTwo[2][3] = {
-        { cos(angle) * newScaleX, -sin(angle) * newScaleX, newOffsetX },
-        { sin(angle) * newScaleY, cos(angle) * newScaleY, newOffsetY }
-    };
+    warpMatrix[0][0] = cos(angle) * newScaleX;
+    warpMatrix[0][1] = -sin(angle) * newScaleX;
+    warpMatrix[0][2] = newOffsetX;
+    warpMatrix[1][0] = sin(angle) * newScaleY;
+    warpMatrix[1][1] = cos(angle) * newScaleY;
+    warpMatrix[1][2] = newOffsetY;
+}
 
-    warpAffine_rgb888(img, dst, warpMatrixStageTwo);
-}
-
-void warpAffine_rgb888(const image_t* img, image_t* dst, float warpMatrix[2][3])
-{
-    float maxFactor = warpMatrix[0][0];
-    if (warpMatrix[0][1] > maxFactor)
-        maxFactor = warpMatrix[0][1];
-    if (warpMatrix[1][0] > maxFactor)
-        maxFactor = warpMatrix[1][0];
-    if (warpMatrix[1][1] > maxFactor)
-        maxFactor = warpMatrix[1][1];
-    int32_t maxPxSize = (int32_t)ceil(maxFactor * 2.0f);
-
-    for (int32_t row = 0; row < img->rows; row++) {
-        for (int32_t col = 0; col < img->cols; col++) {
-            int32_t newCol = affineTransformX(col, row, warpMatrix);
-            int32_t newRow = affineTransformY(col, row, warpMatrix);
-            for (int32_t wRow = newRow; wRow < newRow + maxPxSize; wRow++) {
-                for (int32_t wCol = newCol; wCol < newCol + maxPxSize; wCol++) {
-                    if (wRow < 0 || wRow >= dst->rows
-                        || wCol < 0 || wCol >= dst->cols) {
-                        continue;
-                    } else {
-                        setRGB888PixelI(dst, wCol, wRow, getRGB888PixelI((image_t*)img, col, row));
-                    }
-                }
+void warp_rgb888(const image_t* img, image_t* dst, int32_t colpos[3], int32_t rowpos[3])
+{
+    float warpMatrix[2][3];
+    warpMatrixFromCorners(dst, colpos, rowpos, warpMatrix);
+    warpAffine_rgb888(img, dst, warpMatrix, BILINEAR);
+}
+
+static inline int64_t floorDiv(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Narrows the dst cols [first, last) to the ones where start + col * step lies in [0, limit).
+static void clipSpan(int64_t start, int64_t step, int64_t limit, int32_t* first, int32_t* last)
+{
+    int64_t low;
+    int64_t high;
+    if (step > 0) {
+        low = -floorDiv(start, step);
+        high = floorDiv(limit - 1 - start, step) + 1;
+    } else if (step < 0) {
+        low = -floorDiv(limit - 1 - start, -step);
+        high = floorDiv(start, -step) + 1;
+    } else if (start >= 0 && start < limit) {
+        return;
+    } else {
+        low = high = 0;
+    }
+    if (low > *first) {
+        *first = low > *last ? *last : (int32_t)low;
+    }
+    if (high < *last) {
+        *last = high < *first ? *first : (int32_t)high;
+    }
+}
+
+void warpAffine_rgb888(const image_t* img, image_t* dst, float warpMatrix[2][3], const eInterpolation interpolation)
+{
+    const rgb888_pixel_t* s = (const rgb888_pixel_t*)img->data;
+    const rgb888_pixel_t black = { 0, 0, 0 };
+    float inverse[2][3];
+    if (!invertWarpMatrix(warpMatrix, inverse)) {
+        return;
+    }
+
+    // The source position steps by a constant amount along a dst row, in 16.16 fixed point.
+    // Bilinear sampling needs the pixel right and below as well, so the outer half pixel is left black.
+    const int32_t stepCol = (int32_t)lroundf(inverse[0][0] * 65536.0f);
+    const int32_t stepRow = (int32_t)lroundf(inverse[1][0] * 65536.0f);
+    const int32_t margin = interpolation == BILINEAR ? 1 : 0;
+    const int64_t limitCol = (int64_t)(img->cols - margin) << 16;
+    const int64_t limitRow = (int64_t)(img->rows - margin) << 16;
+
+    for (int32_t row = 0; row < dst->rows; row++) {
+        rgb888_pixel_t* d = (rgb888_pixel_t*)dst->data + row * dst->cols;
+        const int32_t startCol = (int32_t)lroundf((inverse[0][1] * row + inverse[0][2]) * 65536.0f);
+        const int32_t startRow = (int32_t)lroundf((inverse[1][1] * row + inverse[1][2]) * 65536.0f);
+
+        // Only the span of the row that lies within the source is sampled, without bounds checks.
+        int32_t first = 0;
+        int32_t last = dst->cols;
+        clipSpan(startCol, stepCol, limitCol, &first, &last);
+        clipSpan(startRow, stepRow, limitRow, &first, &last);
+
+        for (int32_t col = 0; col < first; col++) {
+            d[col] = black;
+        }
+        if (interpolation == BILINEAR) {
+            for (int32_t col = first; col < last; col++) {
+                const int32_t srcCol = startCol + col * stepCol;
+                const int32_t srcRow = startRow + col * stepRow;
+                const rgb888_pixel_t* p = s + (srcRow >> 16) * img->cols + (srcCol >> 16);
+                const rgb888_pixel_t* q = p + img->cols;
+                const uint32_t fracCol = (srcCol >> 8) & 255;
+                const uint32_t fracRow = (srcRow >> 8) & 255;
+                d[col].r = interpolate(p[0].r, p[1].r, q[0].r, q[1].r, fracCol, fracRow);
+                d[col].g = interpolate(p[0].g, p[1].g, q[0].g, q[1].g, fracCol, fracRow);
+                d[col].b = interpolate(p[0].b, p[1].b, q[0].b, q[1].b, fracCol, fracRow);
             }
+        } else {
+            for (int32_t col = first; col < last; col++) {
+                const int32_t srcCol = startCol + col * stepCol;
+                const int32_t srcRow = startRow + col * stepRow;
+                d[col] = s[(srcRow >> 16) * img->cols + (srcCol >> 16)];
+            }
+        }
+        for (int32_t col = last; col < dst->cols; col++) {
+            d[col] = black;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+uint8_t homographyFromCorners(const image_t* dst, int32_t colpos[4], int32_t rowpos[4], float homography[3][3])
+{
+    // Maps the unit square onto the corners (Heckbert), the dst is the unit square scaled to its cols and rows.
+    const float sumCol = colpos[0] - colpos[1] + colpos[2] - colpos[3];
+    const float sumRow = rowpos[0] - rowpos[1] + rowpos[2] - rowpos[3];
+    const float dCol1 = colpos[1] - colpos[2];
+    const float dCol2 = colpos[3] - colpos[2];
+    const float dRow1 = rowpos[1] - rowpos[2];
+    const float dRow2 = rowpos[3] - rowpos[2];
+    const float det = dCol1 * dRow2 - dCol2 * dRow1;
+    if (det == 0.0f) {
+        return 0;
+    }
+    const float g = (sumCol * dRow2 - dCol2 * sumRow) / det;
+    const float h = (dCol1 * sumRow - sumCol * dRow1) / det;
+
+    homography[0][0] = (colpos[1] - colpos[0] + g * colpos[1]) / dst->cols;
+    homography[0][1] = (colpos[3] - colpos[0] + h * colpos[3]) / dst->rows;
+    homography[0][2] = colpos[0];
+    homography[1][0] = (rowpos[1] - rowpos[0] + g * rowpos[1]) / dst->cols;
+    homography[1][1] = (rowpos[3] - rowpos[0] + h * rowpos[3]) / dst->rows;
+    homography[1][2] = rowpos[0];
+    homography[2][0] = g / dst->cols;
+    homography[2][1] = h / dst->rows;
+    homography[2][2] = 1.0f;
+    return 1;
+}
+
+// The exact source position is only calculated at every this many dst pixels of a row, the ones in between are interpolated.
+#define PERSPECTIVE_SPAN (16)
+
+// Calculates the source positions of a dst row in 16.16 fixed point.
+// The numerators and the denominator change linearly along the row, so only the ends of every span are divided,
+// which is well below a pixel off for the slight perspective of a camera above the baseplate.
+static void projectRow(float homography[3][3], const int32_t row, const int32_t cols, int32_t* srcCols, int32_t* srcRows)
+{
+    const float x = homography[0][1] * row + homography[0][2];
+    const float y = homography[1][1] * row + homography[1][2];
+    const float w = homography[2][1] * row + homography[2][2];
+
+    for (int32_t first = 0; first < cols; first += PERSPECTIVE_SPAN) {
+        const int32_t last = first + PERSPECTIVE_SPAN < cols ? first + PERSPECTIVE_SPAN : cols;
+        const float wFirst = w + homography[2][0] * first;
+        const float wLast = w + homography[2][0] * last;
+        if (wFirst <= 0.0f || wLast <= 0.0f) {
+            // Beyond the horizon of the plane
+            for (int32_t col = first; col < last; col++) {
+                float wCol = w + homography[2][0] * col;
+                srcCols[col] = wCol <= 0.0f ? INT32_MIN : toFixed((x + homography[0][0] * col) / wCol);
+                srcRows[col] = wCol <= 0.0f ? INT32_MIN : toFixed((y + homography[1][0] * col) / wCol);
+            }
+            continue;
+        }
+        const int32_t colFirst = toFixed((x + homography[0][0] * first) / wFirst);
+        const int32_t rowFirst = toFixed((y + homography[1][0] * first) / wFirst);
+        const int32_t colLast = toFixed((x + homography[0][0] * last) / wLast);
+        const int32_t rowLast = toFixed((y + homography[1][0] * last) / wLast);
+        if (colFirst == INT32_MIN || colFirst == INT32_MAX || rowFirst == INT32_MIN || rowFirst == INT32_MAX
+            || colLast == INT32_MIN || colLast == INT32_MAX || rowLast == INT32_MIN || rowLast == INT32_MAX) {
+            // Far outside any source, interpolating could overflow
+            for (int32_t col = first; col < last; col++) {
+                srcCols[col] = INT32_MIN;
+                srcRows[col] = INT32_MIN;
+            }
+            continue;
+        }
+        const int32_t stepCol = (colLast - colFirst) / (last - first);
+        const int32_t stepRow = (rowLast - rowFirst) / (last - first);
+        for (int32_t col = first; col < last; col++) {
+            srcCols[col] = colFirst + (col - first) * stepCol;
+            srcRows[col] = rowFirst + (col - first) * stepRow;
         }
     }
 }
 
+void warpPerspective_rgb888(const image_t* img, image_t* dst, float homography[3][3], const eInterpolation interpolation)
+{
+    const rgb888_pixel_t* s = (const rgb888_pixel_t*)img->data;
+    const rgb888_pixel_t black = { 0, 0, 0 };
+    int32_t* positions = (int32_t*)malloc(2 * dst->cols * sizeof(int32_t));
+    if (positions == NULL) {
+        return;
+    }
+    const int32_t* srcCols = positions;
+    const int32_t* srcRows = positions + dst->cols;
+    // Bilinear sampling needs the pixel right and below as well, so the outer half pixel is left black.
+    const uint32_t margin = interpolation == BILINEAR ? 1 : 0;
+    const uint32_t limitCol = img->cols - margin;
+    const uint32_t limitRow = img->rows - margin;
+
+    for (int32_t row = 0; row < dst->rows; row++) {
+        rgb888_pixel_t* d = (rgb888_pixel_t*)dst->data + row * dst->cols;
+        projectRow(homography, row, dst->cols, positions, positions + dst->cols);
+        for (int32_t col = 0; col < dst->cols; col++) {
+            // Negative positions wrap around to large unsigned ones
+            const uint32_t sc = (uint32_t)(srcCols[col] >> 16);
+            const uint32_t sr = (uint32_t)(srcRows[col] >> 16);
+            if (sc >= limitCol || sr >= limitRow) {
+                d[col] = black;
+            } else if (interpolation == BILINEAR) {
+                const rgb888_pixel_t* p = s + sr * img->cols + sc;
+                const rgb888_pixel_t* q = p + img->cols;
+                const uint32_t fracCol = (srcCols[col] >> 8) & 255;
+                const uint32_t fracRow = (srcRows[col] >> 8) & 255;
+                d[col].r = interpolate(p[0].r, p[1].r, q[0].r, q[1].r, fracCol, fracRow);
+                d[col].g = interpolate(p[0].g, p[1].g, q[0].g, q[1].g, fracCol, fracRow);
+                d[col].b = interpolate(p[0].b, p[1].b, q[0].b, q[1].b, fracCol, fracRow);
+            } else {
+                d[col] = s[sr * img->cols + sc];
+            }
+        }
+    }
+    free(positions);
+}
+
 // ----------------------------------------------------------------------------
 // ----------------------------------------------------------------------------
 void scaleImage_rgb888(const image_t* src, image_t* dst)
@@ -321,6 +546,52 @@ void scaleImage_rgb888(const image_t* src, image_t* dst)
     }
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+void downscale_rgb888(const image_t* src, image_t* dst, const uint8_t factor)
+{
+    const uint32_t area = (uint32_t)factor * factor;
+
+    for (int32_t row = 0; row < dst->rows; row++) {
+        const rgb888_pixel_t* block = (const rgb888_pixel_t*)src->data + row * factor * src->cols;
+        if (dst->type == IMGTYPE_BASIC) {
+            basic_pixel_t* d = (basic_pixel_t*)dst->data + row * dst->cols;
+            for (int32_t col = 0; col < dst->cols; col++) {
+                // Luma in 8-bit fixed point, summed over the block
+                uint32_t sum = 0;
+                for (int32_t blockRow = 0; blockRow < factor; blockRow++) {
+                    const rgb888_pixel_t* s = block + blockRow * src->cols;
+                    for (int32_t blockCol = 0; blockCol < factor; blockCol++) {
+                        sum += 77 * s[blockCol].r + 150 * s[blockCol].g + 29 * s[blockCol].b;
+                    }
+                }
+                *d++ = (basic_pixel_t)((sum + area * 128) / (area * 256));
+                block += factor;
+            }
+        } else {
+            rgb888_pixel_t* d = (rgb888_pixel_t*)dst->data + row * dst->cols;
+            for (int32_t col = 0; col < dst->cols; col++) {
+                uint32_t r = 0;
+                uint32_t g = 0;
+                uint32_t b = 0;
+                for (int32_t blockRow = 0; blockRow < factor; blockRow++) {
+                    const rgb888_pixel_t* s = block + blockRow * src->cols;
+                    for (int32_t blockCol = 0; blockCol < factor; blockCol++) {
+                        r += s[blockCol].r;
+                        g += s[blockCol].g;
+                        b += s[blockCol].b;
+                    }
+                }
+                d->r = (uint8_t)((r + area / 2) / area);
+                d->g = (uint8_t)((g + area / 2) / area);
+                d->b = (uint8_t)((b + area / 2) / area);
+                d++;
+                block += factor;
+            }
+        }
+    }
+}
+
 void crop_rgb888(const image_t* img, image_t* dst, int32_t top_left[2])
 {
     if (top_left[0] >= img->cols || top_left[1] >= img->rows
@@ -399,6 +670,274 @@ void drawText_rgb888(image_t* img, const char* text, const font_t* font, const i
     } while (*(++current));
 }
 
+// ----------------------------------------------------------------------------
+// YUV420 conversion
+// ----------------------------------------------------------------------------
+// Full range BT.601 (JFIF) coefficients in 8-bit fixed point.
+static inline uint8_t clampToByte(int32_t value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+static inline rgb888_pixel_t yuvToRGB888(int32_t y, int32_t u, int32_t v)
+{
+    rgb888_pixel_t pixel;
+    u -= 128;
+    v -= 128;
+    pixel.r = clampToByte(y + ((359 * v) >> 8));
+    pixel.g = clampToByte(y - ((88 * u + 183 * v) >> 8));
+    pixel.b = clampToByte(y + ((454 * u) >> 8));
+    return pixel;
+}
+
+void convertRGB888ToYUV420(const image_t* src, image_t* y, image_t* u, image_t* v)
+{
+    basic_pixel_t* d = (basic_pixel_t*)y->data;
+
+    // A trailing odd row and col of src are left out when y is smaller.
+    for (int32_t row = 0; row < y->rows; row++) {
+        const rgb888_pixel_t* s = (const rgb888_pixel_t*)src->data + row * src->cols;
+        for (int32_t col = 0; col < y->cols; col++) {
+            *d++ = (basic_pixel_t)((77 * s->r + 150 * s->g + 29 * s->b + 128) >> 8);
+            s++;
+        }
+    }
+
+    if (u == NULL || v == NULL) {
+        return;
+    }
+
+    // Chroma of the average of each 2x2 block
+    for (int32_t row = 0; row < u->rows; row++) {
+        const rgb888_pixel_t* s0 = (const rgb888_pixel_t*)src->data + (2 * row) * src->cols;
+        const rgb888_pixel_t* s1 = s0 + src->cols;
+        basic_pixel_t* du = (basic_pixel_t*)u->data + row * u->cols;
+        basic_pixel_t* dv = (basic_pixel_t*)v->data + row * v->cols;
+        for (int32_t col = 0; col < u->cols; col++) {
+            int32_t r = s0[0].r + s0[1].r + s1[0].r + s1[1].r;
+            int32_t g = s0[0].g + s0[1].g + s1[0].g + s1[1].g;
+            int32_t b = s0[0].b + s0[1].b + s1[0].b + s1[1].b;
+            *du++ = clampToByte(((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128);
+            *dv++ = clampToByte(((128 * r - 107 * g - 21 * b + 512) >> 10) + 128);
+            s0 += 2;
+            s1 += 2;
+        }
+    }
+}
+
+void warpYUV420(const image_t* y, const image_t* u, const image_t* v, image_t* dst, int32_t colpos[3], int32_t rowpos[3])
+{
+    float warpMatrix[2][3];
+    float inverse[2][3];
+    warpMatrixFromCorners(dst, colpos, rowpos, warpMatrix);
+    if (!invertWarpMatrix(warpMatrix, inverse)) {
+        return;
+    }
+    float a = inverse[0][0];
+    float b = inverse[0][1];
+    float c = inverse[1][0];
+    float d = inverse[1][1];
+    float tx = inverse[0][2];
+    float ty = inverse[1][2];
+
+    const basic_pixel_t* yData = (const basic_pixel_t*)y->data;
+    const basic_pixel_t* uData = u == NULL ? NULL : (const basic_pixel_t*)u->data;
+    const basic_pixel_t* vData = v == NULL ? NULL : (const basic_pixel_t*)v->data;
+    const int32_t chromaCols = u == NULL ? 0 : u->cols;
+    rgb888_pixel_t* d888 = (rgb888_pixel_t*)dst->data;
+    const rgb888_pixel_t black = { 0, 0, 0 };
+
+    for (int32_t row = 0; row < dst->rows; row++) {
+        float srcCol = b * row + tx;
+        float srcRow = d * row + ty;
+        for (int32_t col = 0; col < dst->cols; col++) {
+            int32_t sc = (int32_t)srcCol;
+            int32_t sr = (int32_t)srcRow;
+            if (srcCol < 0.0f || srcRow < 0.0f || sc >= y->cols || sr >= y->rows) {
+                *d888++ = black;
+            } else if (uData == NULL || vData == NULL) {
+                basic_pixel_t luma = yData[sr * y->cols + sc];
+                rgb888_pixel_t gray = { luma, luma, luma };
+                *d888++ = gray;
+            } else {
+                int32_t chroma = (sr >> 1) * chromaCols + (sc >> 1);
+                *d888++ = yuvToRGB888(yData[sr * y->cols + sc], uData[chroma], vData[chroma]);
+            }
+            srcCol += a;
+            srcRow += c;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+warp_table_t* newWarpTable(const uint32_t cols, const uint32_t rows)
+{
+    warp_table_t* table = (warp_table_t*)malloc(sizeof(warp_table_t));
+    if (table == NULL) {
+        return NULL;
+    }
+
+    table->cols = (int32_t)cols;
+    table->rows = (int32_t)rows;
+    table->srcCols = 0;
+    table->srcRows = 0;
+    table->offsets = (int32_t*)malloc(cols * rows * sizeof(int32_t));
+    table->chromaOffsets = (int32_t*)malloc(cols * rows * sizeof(int32_t));
+    table->fractions = (uint8_t*)malloc(2 * cols * rows * sizeof(uint8_t));
+    if (table->offsets == NULL || table->chromaOffsets == NULL || table->fractions == NULL) {
+        deleteWarpTable(table);
+        return NULL;
+    }
+    return table;
+}
+
+void deleteWarpTable(warp_table_t* table)
+{
+    if (table == NULL) {
+        return;
+    }
+    free(table->offsets);
+    free(table->chromaOffsets);
+    free(table->fractions);
+    free(table);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+// Stores the source position of dst pixel i, in 16.16 fixed point.
+static void setTableEntry(warp_table_t* table, const int32_t i, int32_t fixedCol, int32_t fixedRow)
+{
+    const int32_t srcCols = table->srcCols;
+    const int32_t srcRows = table->srcRows;
+    if (fixedCol < 0 || fixedRow < 0 || fixedCol >= (srcCols << 16) || fixedRow >= (srcRows << 16)) {
+        table->offsets[i] = -1;
+        table->chromaOffsets[i] = -1;
+        table->fractions[2 * i] = 0;
+        table->fractions[2 * i + 1] = 0;
+        return;
+    }
+    int32_t sc = fixedCol >> 16;
+    int32_t sr = fixedRow >> 16;
+    table->chromaOffsets[i] = (sr >> 1) * (srcCols / 2) + (sc >> 1);
+    // The last col and row are interpolated from the block before them.
+    if (sc >= srcCols - 1) {
+        sc = srcCols - 2;
+        fixedCol = (sc << 16) + 0xFFFF;
+    }
+    if (sr >= srcRows - 1) {
+        sr = srcRows - 2;
+        fixedRow = (sr << 16) + 0xFFFF;
+    }
+    table->offsets[i] = sr * srcCols + sc;
+    table->fractions[2 * i] = (uint8_t)((fixedCol >> 8) & 255);
+    table->fractions[2 * i + 1] = (uint8_t)((fixedRow >> 8) & 255);
+}
+
+void warpTableFromCorners(warp_table_t* table, const int32_t srcCols, const int32_t srcRows, int32_t colpos[3], int32_t rowpos[3])
+{
+    float warpMatrix[2][3];
+    float inverse[2][3];
+    warpMatrixFromSize(table->cols, table->rows, colpos, rowpos, warpMatrix);
+    table->srcCols = srcCols;
+    table->srcRows = srcRows;
+    const uint8_t invertible = invertWarpMatrix(warpMatrix, inverse);
+
+    for (int32_t row = 0; row < table->rows; row++) {
+        for (int32_t col = 0; col < table->cols; col++) {
+            // The same positions as warpYUV420()
+            float srcCol = inverse[0][0] * col + inverse[0][1] * row + inverse[0][2];
+            float srcRow = inverse[1][0] * col + inverse[1][1] * row + inverse[1][2];
+            if (!invertible) {
+                srcCol = srcRow = -1.0f;
+            }
+            setTableEntry(table, row * table->cols + col, toFixed(srcCol), toFixed(srcRow));
+        }
+    }
+}
+
+uint8_t warpTableFromHomography(warp_table_t* table, const int32_t srcCols, const int32_t srcRows, float homography[3][3])
+{
+    int32_t* positions = (int32_t*)malloc(2 * table->cols * sizeof(int32_t));
+    if (positions == NULL) {
+        table->srcCols = 0;
+        table->srcRows = 0;
+        return 0;
+    }
+    table->srcCols = srcCols;
+    table->srcRows = srcRows;
+
+    for (int32_t row = 0; row < table->rows; row++) {
+        projectRow(homography, row, table->cols, positions, positions + table->cols);
+        for (int32_t col = 0; col < table->cols; col++) {
+            setTableEntry(table, row * table->cols + col, positions[col], positions[table->cols + col]);
+        }
+    }
+    free(positions);
+    return 1;
+}
+
+void warpWithTable(const image_t* img, image_t* dst, image_t* hsv, const warp_table_t* table)
+{
+    const rgb888_pixel_t* s = (const rgb888_pixel_t*)img->data;
+    const int32_t* offset = table->offsets;
+    const uint8_t* fraction = table->fractions;
+    rgb888_pixel_t* d = (rgb888_pixel_t*)dst->data;
+    hsv_pixel_t* h = hsv == NULL ? NULL : (hsv_pixel_t*)hsv->data;
+    const rgb888_pixel_t black = { 0, 0, 0 };
+    const int32_t count = table->cols * table->rows;
+
+    for (int32_t i = 0; i < count; i++) {
+        rgb888_pixel_t pixel = black;
+        if (offset[i] >= 0) {
+            const rgb888_pixel_t* p = s + offset[i];
+            const rgb888_pixel_t* q = p + img->cols;
+            const uint32_t fracCol = fraction[2 * i];
+            const uint32_t fracRow = fraction[2 * i + 1];
+            pixel.r = interpolate(p[0].r, p[1].r, q[0].r, q[1].r, fracCol, fracRow);
+            pixel.g = interpolate(p[0].g, p[1].g, q[0].g, q[1].g, fracCol, fracRow);
+            pixel.b = interpolate(p[0].b, p[1].b, q[0].b, q[1].b, fracCol, fracRow);
+        }
+        d[i] = pixel;
+        // Converted while the pixel is at hand, instead of reading the region again
+        if (h != NULL) {
+            h[i] = rgb888ToHSV(pixel);
+        }
+    }
+}
+
+void warpYUV420WithTable(const image_t* y, const image_t* u, const image_t* v, image_t* dst, image_t* hsv, const warp_table_t* table)
+{
+    const basic_pixel_t* yData = (const basic_pixel_t*)y->data;
+    const basic_pixel_t* uData = u == NULL ? NULL : (const basic_pixel_t*)u->data;
+    const basic_pixel_t* vData = v == NULL ? NULL : (const basic_pixel_t*)v->data;
+    const int32_t* offset = table->offsets;
+    const int32_t* chromaOffset = table->chromaOffsets;
+    const uint8_t* fraction = table->fractions;
+    rgb888_pixel_t* d = (rgb888_pixel_t*)dst->data;
+    hsv_pixel_t* h = hsv == NULL ? NULL : (hsv_pixel_t*)hsv->data;
+    const rgb888_pixel_t black = { 0, 0, 0 };
+    const int32_t count = table->cols * table->rows;
+
+    for (int32_t i = 0; i < count; i++) {
+        rgb888_pixel_t pixel = black;
+        if (offset[i] >= 0) {
+            const basic_pixel_t* p = yData + offset[i];
+            const basic_pixel_t* q = p + y->cols;
+            const uint8_t luma = interpolate(p[0], p[1], q[0], q[1], fraction[2 * i], fraction[2 * i + 1]);
+            if (uData == NULL || vData == NULL) {
+                pixel.r = pixel.g = pixel.b = luma;
+            } else {
+                pixel = yuvToRGB888(luma, uData[chromaOffset[i]], vData[chromaOffset[i]]);
+            }
+        }
+        d[i] = pixel;
+        if (h != NULL) {
+            h[i] = rgb888ToHSV(pixel);
+        }
+    }
+}
+
 // ----------------------------------------------------------------------------
 // EOF
 // ----------------------------------------------------------------------------
@@ -53,10 +53,13 @@ void copy_rgb888(const image_t* src, image_t* dst);
 
 void warp_rgb888(const image_t* img, image_t* dst, int32_t colpos[3], int32_t rowpos[3]);
 
-void warpAffine_rgb888(const image_t* img, image_t* dst, float warpMatrix[2][3]);
+void warpAffine_rgb888(const image_t* img, image_t* dst, float warpMatrix[2][3], const eInterpolation interpolation);
+void warpPerspective_rgb888(const image_t* img, image_t* dst, float homography[3][3], const eInterpolation interpolation);
 
 void scaleImage_rgb888(const image_t* src, image_t* dst);
 
+void downscale_rgb888(const image_t* src, image_t* dst, const uint8_t factor);
+
 void crop_rgb888(const image_t* img, image_t* dst, int32_t top_left[2]);
 
 void drawRect_rgb888(image_t* img, const int32_t top_left[2], const int32_t size[2], rgb888_pixel_t value, eShapeDrawType drawType, uint16_t borderSize);
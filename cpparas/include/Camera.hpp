@@ -1,53 +1,83 @@
 #ifndef CAMERA_HPP
 #define CAMERA_HPP
 
+#include "FrameSource.hpp"
 #include "operators.h"
+#include "util/PipeFrameReader.hpp"
 #include <atomic>
-#include <condition_variable>
-#include <iostream>
-#include <mutex>
+#include <memory>
+#include <stdio.h>
 #include <string>
-#include <thread>
+#include <vector>
 
 namespace cpparas {
 
-class Camera {
+/** Highest frame rate `raspivid` supports in sensor mode 2. Also used for FRAME_RATE_UNLIMITED. */
+const double CAMERA_MAX_FRAME_RATE = 15.0;
+
+/**
+ * @brief Frame source that reads raw frames from `raspivid` through a pipe.
+ *        YUV420 halves the pipe bandwidth compared to RGB888 and hands the Y plane
+ *        to the marker detector without conversion.
+ *        Always delivers the newest frame in the pipe, and restarts `raspivid` when it quits or stalls.
+ *        A region of interest is cut out by `raspivid` so only its pixels go through the pipe.
+ *        Preview frames are scaled down from the same stream, because starting `raspivid` again
+ *        would cost its start-up time and the warm-up frames on every switch of the stream mode.
+ */
+class Camera : public FrameSource {
 public:
     /**
      * @brief Creates a camera device.
      * @input w Frame buffer width. Needs to be supported by `raspivid`.
      * @input h Frame buffer height.
+     * @input frameRate Frame rate passed to `raspivid`.
+     * @input format Raw format requested from `raspivid`.
      */
-    Camera(uint32_t w, uint32_t h);
-    ~Camera();
-    /**
-     * @brief Starts the camera thread which will capture frames.
-     * @note This function does no checking on whether a camera thread has already been started.
-     */
-    void Camera_thread_worker_start();
+    Camera(uint32_t w, uint32_t h, double frameRate = CAMERA_MAX_FRAME_RATE, FrameFormat format = FrameFormat::YUV420);
+    ~Camera() override;
+
     /**
-     * @brief Stops the camera thread.
+     * @brief Returns the number of frames that were skipped because a newer frame was already in the pipe.
      */
-    void Camera_thread_worker_stop();
+    uint64_t getDroppedFrames() const;
     /**
-     * @brief Waits for a camera frame to be available.
-     * @return valid pointer = frame has been received successfully. nullptr = camera thread has failed.
+     * @brief Returns how often `raspivid` was restarted after it quit or stalled.
      */
-    image_t* Camera_get_frame();
+    uint32_t getRestarts() const;
+
+protected:
+    bool open() override;
+    bool readFrame(image_t* dst) override;
+    void close() override;
+    bool pacedByDevice() const override;
+    uint32_t warmupFrames() const override;
+    FrameFormat nativeFormat() const override;
+    uint64_t droppedByDevice() const override;
+    bool configureStream(StreamMode mode, const Rect<int32_t>& region, uint32_t cols, uint32_t rows, Rect<int32_t>& nativeRegion) override;
 
 private:
-    void Camera_thread_worker();
+    void composeCommand(const Rect<int32_t>& region);
+    bool startRaspivid();
+    bool restartRaspivid();
+    std::size_t pipeFrameSize() const;
+    bool framePadded() const;
+    void copyPlane(const uint8_t*& src, uint8_t*& dst, uint32_t cols, uint32_t rows, uint32_t stride, uint32_t paddedRows);
+
     //camera stuff
-    std::string raspi_parameters;
     uint32_t width, height;
-    //buffer
-    image_t* captured_frame;
-    //threads
-    std::atomic<bool> threadRunning;
-    std::atomic<bool> is_ready;
-    std::thread camera_thread;
-    std::mutex mtx;
-    std::condition_variable cond_var;
+    // The part of the sensor raspivid currently delivers, at full resolution
+    Rect<int32_t> captureRegion;
+    uint32_t captureCols, captureRows;
+    std::string command;
+    FILE* fpipe;
+    std::unique_ptr<PipeFrameReader> reader;
+    // raspivid pads the planes of YUV420 and gray frames, padded frames are read here first
+    std::vector<uint8_t> pipeFrame;
+    uint32_t failedRestarts;
+    // Frames dropped by readers of earlier raspivid instances
+    uint64_t droppedBefore;
+    std::atomic<uint64_t> droppedFrames;
+    std::atomic<uint32_t> restarts;
 };
 
 } // namespace cpparas
@@ -1,14 +1,18 @@
 #ifndef COLORCLASSIFIER_HPP
 #define COLORCLASSIFIER_HPP
 
-#include "CoordinateMatrix.hpp"
+#include "StudGrid.hpp"
 #include "operators.h"
 #include "types/Color.hpp"
 
 namespace cpparas {
 
 namespace ColorClassifier {
-    std::vector<hsv_pixel_t> setColors(const image_t* image, const CoordinateMatrix& coordinateMatrix, Color expectedColor, image_t* debugImage = nullptr);
+    /**
+     * @brief Returns the minimum and maximum HSV values of the reference studs of the color, on the bottom layer of the stud frame.
+     * @param debugImage A copy of the stud frame image the reference studs are marked on, or nullptr.
+     */
+    std::vector<hsv_pixel_t> setColors(const StudFrame& studFrame, Color expectedColor, image_t* debugImage = nullptr);
 }
 
 } // namespace cpparas
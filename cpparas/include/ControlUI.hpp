@@ -27,6 +27,7 @@ private:
     void on_select_image_button_clicked();
     void on_use_last_image_button_clicked();
     void on_use_camera_button_clicked();
+    void on_select_frame_folder_button_clicked();
     void on_select_sequence_file_button_clicked();
     void on_use_last_sequence_file_button_clicked();
     void on_open_projector_ui_button_clicked();
@@ -43,6 +44,7 @@ private:
     Gtk::Button selectImageButton;
     Gtk::Button useLastImageButton;
     Gtk::Button useCameraButton;
+    Gtk::Button selectFrameFolderButton;
     Gtk::Separator separator1;
     Gtk::Button selectSequenceFileButton;
     Gtk::Button useLastSequenceFileButton;
@@ -0,0 +1,46 @@
+#ifndef DIRECTORYSOURCE_HPP
+#define DIRECTORYSOURCE_HPP
+
+#include "FrameSource.hpp"
+#include "operators.h"
+#include <string>
+#include <vector>
+
+namespace cpparas {
+
+/**
+ * @brief Frame source that replays the PNG and JPEG images in a directory in file name order.
+ *        Every frame gets the size of the first image; other sizes are scaled.
+ */
+class DirectorySource : public FrameSource {
+public:
+    /**
+     * @param directoryPath The directory holding the frames.
+     * @param loop Whether to start over after the last frame. Otherwise the source stops.
+     * @param preload Whether to decode all frames up front, so decoding doesn't limit the frame rate.
+     */
+    DirectorySource(const std::string& directoryPath, double frameRate, bool loop = true, bool preload = false);
+    ~DirectorySource() override;
+
+    /**
+     * @brief Returns the sorted paths of the frame images in a directory.
+     */
+    static std::vector<std::string> listFrames(const std::string& directoryPath);
+
+protected:
+    bool open() override;
+    bool readFrame(image_t* dst) override;
+    void close() override;
+
+private:
+    std::string directoryPath;
+    bool loop;
+    bool preload;
+    std::vector<std::string> framePaths;
+    std::vector<image_t*> preloadedFrames;
+    std::size_t nextFrame;
+};
+
+} // namespace cpparas
+
+#endif /* DIRECTORYSOURCE_HPP */
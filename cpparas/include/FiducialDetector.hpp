@@ -0,0 +1,67 @@
+#ifndef FIDUCIALDETECTOR_HPP
+#define FIDUCIALDETECTOR_HPP
+
+#include "operators.h"
+#include "types/Point.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace cpparas {
+
+/**
+ * @brief Finds square coded markers, like the ArUco markers of the Python prototype, in a single pass.
+ *        A marker is a black square of 6 x 6 cells: a border of black cells around 4 x 4 bits,
+ *        where a white cell is a 1. It needs a white margin of at least one cell around it.
+ */
+namespace FiducialDetector {
+    /** Markers in the dictionary, one for each corner that MarkerDetector::detectMarkers returns. */
+    const uint32_t FIDUCIAL_MARKER_COUNT = 3;
+    /**
+     * The code of every marker, in rows from top to bottom with the left-top bit as the most significant bit.
+     * Every code differs in at least 8 bits from the other codes and from the rotations of all codes.
+     * Marker i is printed upright at corner i, left-top, right-top and right-bottom, so its own corner i is the corner of the baseplate.
+     */
+    const uint16_t FIDUCIAL_CODES[FIDUCIAL_MARKER_COUNT] = { 0x31AB, 0x1964, 0xAB79 };
+
+    /**
+     * @brief A marker found in the frame.
+     */
+    struct Marker {
+        /** The index of the code in FIDUCIAL_CODES */
+        uint32_t id;
+        /** The corners of the marker clockwise from the left-top corner of the upright code, in frame pixels */
+        Point<double> corners[4];
+        /** Bits that differed from the code */
+        uint32_t bitErrors;
+    };
+
+    /**
+     * @brief The outcome of a detection.
+     */
+    struct Detection {
+        /** Every marker that was found, at most one for each id */
+        std::vector<Marker> markers;
+        /** The corners of the baseplate in the order of MarkerDetector::detectMarkers, empty when a marker was not found */
+        std::vector<Point<int32_t>> points;
+    };
+
+    /**
+     * @brief Finds the coded markers with one adaptive threshold, so no thresholds are tried one by one.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     */
+    Detection detect(const image_t* img);
+    /**
+     * @brief Returns the corners of the baseplate like MarkerDetector::detectMarkers, but found by their codes.
+     */
+    std::vector<Point<int32_t>> detectMarkers(const image_t* img);
+    /**
+     * @brief Draws the upright marker with the given id, e.g. to print it or to render a test frame.
+     * @param img An RGB888 image.
+     * @param size The size of the marker in pixels, a multiple of 6 gives cells of equal size.
+     */
+    void drawMarker(image_t* img, uint32_t id, const Point<int32_t>& topLeft, int32_t size);
+}
+
+} // namespace cpparas
+
+#endif /* FIDUCIALDETECTOR_HPP */
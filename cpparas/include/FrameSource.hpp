@@ -0,0 +1,232 @@
+#ifndef FRAMESOURCE_HPP
+#define FRAMESOURCE_HPP
+
+#include "operators.h"
+#include "util/CaptureStatistics.hpp"
+#include "util/FrameRing.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace cpparas {
+
+/** Frame rate value that makes a source deliver frames as fast as it can produce them. */
+const double FRAME_RATE_UNLIMITED = 0.0;
+/** Preview frames have the full resolution divided by this factor. */
+const uint32_t PREVIEW_DOWNSCALE = 3;
+
+/**
+ * @brief The resolution a source delivers its frames in.
+ */
+enum class StreamMode {
+    /** Low resolution at a high frame rate, for hand detection and other coarse tasks. */
+    PREVIEW,
+    /** Full resolution, for marker detection and checking studs. */
+    FULL,
+};
+
+/**
+ * @brief A source of frames for the Locator.
+ *        The source captures on its own thread into a FrameRing, so the newest
+ *        frame can always be taken without waiting or copying.
+ *        Backends only need to implement opening, reading one frame and closing.
+ * @note Backends need to call stop() in their destructor, because the capture
+ *       thread calls back into the backend.
+ */
+class FrameSource {
+public:
+    /**
+     * @param frameRate Frames per second, or FRAME_RATE_UNLIMITED.
+     * @param format The layout of the delivered frames.
+     */
+    FrameSource(double frameRate, FrameFormat format = FrameFormat::RGB888);
+    virtual ~FrameSource();
+    FrameSource(const FrameSource&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+
+    /**
+     * @brief Starts the capture thread and waits until the first frame is available or the source failed.
+     *        Does nothing if the source is already running.
+     */
+    void start();
+    /**
+     * @brief Stops the capture thread.
+     */
+    void stop();
+    /**
+     * @brief Returns whether the capture thread is running.
+     *        This turns false when the source fails or a non-looping source runs out of frames.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Returns the newest complete frame. Does not copy and does not wait for a new frame.
+     *        The returned frame stays valid and untouched until the next call.
+     *        This is an RGB888 image for RGB888 sources and the basic Y plane for YUV420 and GRAY sources.
+     *        It only shows the field of view in the frame info, see setRegionOfInterest.
+     * @return nullptr if the source is not running.
+     */
+    image_t* getFrame();
+    /**
+     * @brief Returns the chroma planes of the frame returned by the last getFrame call,
+     *        with half the cols and rows of the Y plane.
+     * @return nullptr unless the source delivers YUV420 frames.
+     */
+    const image_t* getChromaU() const;
+    const image_t* getChromaV() const;
+    /**
+     * @brief Returns the sequence number, capture time and field of view of the frame returned by the last getFrame call.
+     */
+    const RingFrame& getFrameInfo() const;
+    /**
+     * @brief Waits until a frame newer than the given sequence number is available,
+     *        the source stopped, wakeReader was called or the timeout passed.
+     * @return Whether a newer frame is available.
+     */
+    bool waitForFrame(uint64_t sequence, std::chrono::milliseconds timeout);
+    /**
+     * @brief Wakes up a waitForFrame call, e.g. when the reader has other work to do.
+     */
+    void wakeReader();
+    /**
+     * @brief Returns whether every frame shows the same picture, so only frames with another
+     *        stream mode or region of interest are worth looking at again.
+     */
+    virtual bool deliversStillFrames() const;
+
+    /**
+     * @brief Sets the frame rate in frames per second, or FRAME_RATE_UNLIMITED.
+     *        Sources that are paced by a device apply this the next time they are started.
+     */
+    void setFrameRate(double frameRate);
+    double getFrameRate() const;
+
+    /**
+     * @brief Sets the layout of the delivered frames. Takes effect the next time the source is started.
+     */
+    void setFormat(FrameFormat format);
+    FrameFormat getFormat() const;
+
+    /**
+     * @brief Switches between preview and full resolution frames. Does not wait.
+     *        Frames in the previous mode keep coming until the first frame in the new mode is available.
+     *        Compare the field of view of the frame info with the frame size to see which mode a frame is in.
+     */
+    void setStreamMode(StreamMode mode);
+    StreamMode getStreamMode() const;
+
+    /**
+     * @brief Only captures the given part of the frame, in full resolution pixels. Does not wait.
+     *        The region is clamped to the frame, and aligned to even pixels for YUV420 frames.
+     *        A region without width or height captures the whole frame again.
+     *        The field of view of the frame info tells which region a frame shows.
+     */
+    void setRegionOfInterest(const Rect<int32_t>& region);
+    Rect<int32_t> getRegionOfInterest() const;
+
+    /**
+     * @brief Returns the size of full resolution frames that show the whole field of view.
+     *        Known once the source has been started.
+     */
+    uint32_t getFullCols() const;
+    uint32_t getFullRows() const;
+
+    /**
+     * @brief Returns a copy of the counters and histograms of the capture path.
+     *        They keep counting over restarts of the source.
+     */
+    CaptureStatistics getStatistics() const;
+    void resetStatistics();
+
+protected:
+    /**
+     * @brief Prepares the backend for full resolution frames. Called on the capture thread.
+     *        Needs to set the frame size with setFrameSize.
+     * @return Whether the backend is ready to deliver frames.
+     */
+    virtual bool open() = 0;
+    /**
+     * @brief Reads the next frame into dst, which has the layout of nativeFormat() and the size
+     *        set by open, or the size of the native region set by configureStream.
+     *        Called on the capture thread.
+     * @return false when the backend failed or ran out of frames.
+     */
+    virtual bool readFrame(image_t* dst) = 0;
+    /**
+     * @brief Releases the resources taken by open. Called on the capture thread.
+     */
+    virtual void close() = 0;
+    /**
+     * @brief Returns whether the backend blocks in readFrame until the next frame is due,
+     *        in which case the capture thread does not pace the frames itself.
+     */
+    virtual bool pacedByDevice() const;
+    /**
+     * @brief Returns the number of frames to drop after opening, e.g. while a camera adjusts its exposure.
+     */
+    virtual uint32_t warmupFrames() const;
+    /**
+     * @brief Returns the layout the backend reads its frames in.
+     *        RGB888 frames are converted when the source delivers another format.
+     */
+    virtual FrameFormat nativeFormat() const;
+    /**
+     * @brief Returns the number of frames the device dropped before they were read.
+     */
+    virtual uint64_t droppedByDevice() const;
+    /**
+     * @brief Lets the backend capture another region itself. Called on the capture thread.
+     *        The frames the backend reads are cropped to the region and scaled down for the preview.
+     * @param region The part of the full resolution frame to capture, already clamped and aligned.
+     * @param cols, rows The size of the frames in this stream.
+     * @param[in,out] nativeRegion The part of the full resolution frame the backend reads at full resolution.
+     *        Stays the whole frame by default. Changing it counts as a restart of the backend.
+     * @return false when the backend failed.
+     */
+    virtual bool configureStream(StreamMode mode, const Rect<int32_t>& region, uint32_t cols, uint32_t rows, Rect<int32_t>& nativeRegion);
+
+    void setFrameSize(uint32_t cols, uint32_t rows);
+
+private:
+    void captureThread();
+    void releaseFrame();
+    FrameRing* ringForMode(StreamMode mode, FrameFormat ringFormat);
+    Rect<int32_t> alignRegion(Rect<int32_t> region, FrameFormat ringFormat) const;
+
+    std::atomic<double> frameRate;
+    std::atomic<FrameFormat> format;
+    std::atomic<StreamMode> requestedMode;
+    Rect<int32_t> requestedRegion;
+    mutable std::mutex regionMtx;
+    std::atomic<bool> running;
+    std::atomic<bool> firstFrameReady;
+    // The sequence number of the newest frame the reader can take, guarded by mtx
+    uint64_t latestSequence;
+    bool readerWoken;
+    uint32_t frameCols;
+    uint32_t frameRows;
+    // One ring per stream mode, so the reader can hold on to a frame while the mode changes.
+    std::unique_ptr<FrameRing> frames[2];
+    // The ring with the newest frame
+    std::atomic<int32_t> activeRing;
+    int32_t currentRing;
+    RingFrame currentFrame;
+    image_t frameView;
+    image_t lumaView;
+    image_t chromaUView;
+    image_t chromaVView;
+    CaptureStatistics statistics;
+    // The last frame that was counted as taken by the reader
+    uint64_t consumedSequence;
+    mutable std::mutex statisticsMtx;
+    std::thread captureWorker;
+    std::mutex mtx;
+    std::condition_variable condVar;
+};
+
+} // namespace cpparas
+
+#endif /* FRAMESOURCE_HPP */
@@ -15,7 +15,10 @@ const hsv_pixel_t HAND_THRESHOLD_HIGH = {
     50, // S
     90 // V
 };
+/** Area of the hand in full resolution pixels */
 const uint32_t HAND_THRESHOLD_AREA = 10000;
+/** Skin colored specks narrower than this many pixels are noise, they are opened away before the hand area is counted */
+const uint8_t HAND_NOISE_SIZE = 5;
 
 class HandDetection {
 public:
@@ -23,10 +26,14 @@ public:
      * @brief Creates a hand detection checker.
      */
     HandDetection();
+    ~HandDetection();
+    HandDetection(const HandDetection&) = delete;
+    HandDetection& operator=(const HandDetection&) = delete;
     /**
-     * @brief Runs the hand detection on the given image.
+     * @brief Runs the hand detection on the HSV image of a cut frame, see Frame::getHSVImage.
+     *        The Locator makes it while the frame is cut, so it isn't converted again here.
      */
-    void update(const image_t* image);
+    void update(const image_t* hsvImage);
     /**
      * @brief Sets whether a simulated hand is present.
      */
@@ -38,6 +45,9 @@ public:
     bool containsHand() const;
 
 private:
+    // Kept for the next frame of the same size
+    image_t* thresholdedImage;
+    binary_scratch_t* scratch;
     bool handDetected;
     bool simulatedHandDetected;
 };
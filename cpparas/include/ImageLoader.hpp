@@ -2,6 +2,7 @@
 #define IMAGELOADER_HPP
 
 #include "operators.h"
+#include "util/FrameRing.hpp"
 #include "util/ImageUtils.hpp"
 #include <string>
 
@@ -10,6 +11,9 @@ namespace cpparas {
 enum class SourceType {
     CAMERA,
     IMAGE,
+    DIRECTORY,
+    RAW_STREAM,
+    SYNTHETIC,
     UNKNOWN,
 };
 
@@ -17,7 +21,7 @@ class ImageLoader {
 public:
     /**
      * @brief Creates a new image loader that holds the currently
-     *        selected source type and the image seen in the UI.
+     *        selected source type and its settings.
      */
     ImageLoader();
     ~ImageLoader();
@@ -35,21 +39,31 @@ public:
     image_t* Get_source_image();
 
     /**
-     * @brief Sets the frame to be displayed by the UI.
+     * @brief Sets the directory of frames or the raw stream file to replay, see RawStreamSource::formatOfFile.
      */
-    void Set_UI_frame(image_t* frame);
-    image_t* Get_UI_frame();
+    void Set_source_path(std::string path);
+    std::string Get_source_path();
 
     /**
-     * @brief Returns whether a new UI frame is available.
+     * @brief Sets the frame rate of the source, or FRAME_RATE_UNLIMITED.
+     *        The camera can't go faster than CAMERA_MAX_FRAME_RATE.
      */
-    bool Get_new_UI_frame_available() const;
+    void Set_frame_rate(double frameRate);
+    double Get_frame_rate();
+
+    /**
+     * @brief Sets the format frames are captured in. Defaults to YUV420.
+     *        Raw RGB888 streams are converted to it, other raw streams are replayed in the format they were recorded in.
+     */
+    void Set_frame_format(FrameFormat format);
+    FrameFormat Get_frame_format();
 
 private:
     SourceType selected_source;
     image_t* user_image;
-    image_t* ui_image;
-    bool new_UI_frame_available;
+    std::string source_path;
+    double frame_rate;
+    FrameFormat frame_format;
 };
 
 } // namespace cpparas
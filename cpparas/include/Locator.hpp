@@ -1,11 +1,16 @@
 #ifndef LOCATOR_HPP
 #define LOCATOR_HPP
 
-#include "Camera.hpp"
+#include "FrameSource.hpp"
 #include "ImageLoader.hpp"
+#include "MotionDetector.hpp"
 #include "RegionExtractor.hpp"
+#include "StudGrid.hpp"
 #include "operators.h"
+#include "util/CaptureStatistics.hpp"
+#include "util/FrameChannel.hpp"
 #include <atomic>
+#include <memory>
 #include <thread>
 
 namespace cpparas {
@@ -23,13 +28,31 @@ public:
      */
     void Stop_Locator_thread();
     /**
-     * @brief Returns the latest available cropped frame. Does not wait.
+     * @brief Subscribes to the cropped frames. Every subscriber takes frames at its own pace,
+     *        so e.g. a slow preview doesn't hold up hand detection.
+     *        A taken frame is never written to again, and its info tells which captured frame it was cut from.
+     *        The subscription is closed while the locator thread is not running.
      */
-    image_t* Get_new_frame();
+    std::shared_ptr<FrameSubscriber> Subscribe(DropPolicy policy);
     /**
-     * @brief Sends a frame to the ImageLoader that is used by the ControlUI.
+     * @brief Subscribes to the stud frames, which the full resolution frames are gathered into together with the cut frames.
+     *        They hold the studs of the bottom layer and of the requested layer, read them with a StudFrame.
+     *        The subscription is closed while the locator thread is not running.
      */
-    void Send_frame_to_ui(image_t* frame);
+    std::shared_ptr<FrameSubscriber> Subscribe_studs(DropPolicy policy);
+    /**
+     * @brief Sets the layer the stud frames hold besides the bottom layer. Does not wait.
+     *        The current frame is gathered again when the layer changes.
+     */
+    void Request_stud_layer(uint32_t layer);
+    /**
+     * @brief Returns the statistics of the capture path.
+     */
+    CaptureStatistics Get_capture_statistics();
+    /**
+     * @brief Returns how often the markers were tracked and how often the whole frame was searched.
+     */
+    TrackingStatistics Get_tracking_statistics();
     /**
      * @brief Returns whether the first frame has been received.
      *        When using the camera, this will return false for a few seconds
@@ -38,29 +61,81 @@ public:
     bool First_frame_received();
     /**
      * @brief Returns whether the baseplate is shifted and needs to be adjusted by the user.
+     *        This is only looked at again when the frame changed around the markers.
      */
     bool Location_checker();
+    /**
+     * @brief Returns how often the baseplate changed since the locator started, e.g. a hand or brick moved.
+     *        Cut frames carry the count they were cut at, so frames with the same count show the same scene.
+     */
+    uint64_t Scene_changes();
         /**
      * @brief Can disable or enable active corner detection for when instant frames are needed
      */
     void Active_corner_detection(bool state);
+    /**
+     * @brief Limits how often the locator looks at a new frame, in frames per second, or FRAME_RATE_UNLIMITED.
+     *        The locator only runs when a new frame comes in or work is requested, so this caps the work per second.
+     */
+    void Set_max_rate(double frames_per_second);
+    /**
+     * @brief Uses the given frame source instead of the one selected in the ImageLoader,
+     *        e.g. to run the locator without a camera in tests and benchmarks.
+     *        Takes effect the next time the locator thread is started.
+     */
+    void Set_frame_source(std::shared_ptr<FrameSource> source);
+    /**
+     * @brief Switches the frame source between preview and full resolution frames. Does not wait.
+     *        Preview frames are cut with the last known corners, because they are too coarse to find the markers.
+     */
+    void Request_stream_mode(StreamMode mode);
+    /**
+     * @brief Returns whether the latest cut frame was cut from a full resolution frame.
+     */
+    bool Full_frame_available();
 
 private:
     void Locator_thread();
+    std::shared_ptr<FrameSource> Create_frame_source();
+    void Update_capture_region(const std::vector<Point<int32_t>>& corners);
+    void Publish_cut_frame(const std::vector<Point<int32_t>>& frame_points, bool full_resolution);
+    void Wake_locator_thread();
+    bool Markers_changed();
 
     std::atomic<bool> locator_running;
     std::atomic<bool> first_frame;
     std::atomic<bool> moved_interupt;
     std::atomic<bool> active_corner_detection;
+    std::atomic<StreamMode> stream_mode;
+    std::atomic<bool> full_frame_cut;
+    std::atomic<uint32_t> stud_layer;
+    // Set to look at the current frame again, even when it didn't change
+    std::atomic<bool> work_requested;
+    std::atomic<double> max_rate;
+    std::atomic<uint64_t> scene_changes;
     std::thread locator_thread;
-    image_t* new_cut_frame;
     image_t* new_full_frame;
-    SourceType source_type;
     std::shared_ptr<ImageLoader> imageLoader;
-    Camera PiCamera;
+    std::shared_ptr<FrameSource> frame_source;
+    std::shared_ptr<FrameSource> user_frame_source;
     RegionExtractor RegExtractor;
+    std::shared_ptr<FrameChannel> cut_frames;
+    // Only used by the locator thread
+    StudGrid stud_grid;
+    std::shared_ptr<FrameChannel> stud_frames;
     int32_t MAX_DIVIATION = 50;
     std::vector<Point<int32_t>> corner_points_old;
+    // The part of the frame that is captured, in full resolution pixels. Empty while the whole frame is captured.
+    Rect<int32_t> capture_region;
+    uint32_t missed_detections;
+    // Markers and baseplate are only looked at again when their part of the frame changed
+    MotionDetector motion;
+    std::size_t motion_markers;
+    std::size_t motion_baseplate;
+    // Whether the last search found the markers
+    bool markers_found;
+    // The corners the last cut frame was cut at
+    std::vector<Point<int32_t>> cut_points;
     Point<int32_t> Central_camera_point;
     Point<int32_t> Central_board_point;
 };
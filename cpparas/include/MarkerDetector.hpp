@@ -3,20 +3,83 @@
 
 #include "operators.h"
 #include "types/Point.hpp"
+#include <cstdint>
 #include <vector>
 
 namespace cpparas {
 
 namespace MarkerDetector {
+    /** Threads a full search uses to try thresholds, one per core of the Pi. */
+    const uint32_t MARKER_DETECTION_WORKERS = 4;
+    /** Direction from the sharp corner into the marker, for each corner in the order of detectMarkers. */
+    const int32_t MARKER_DIRECTIONS[3][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 } };
     /**
-     * @brief Detects markers in the given image. Up to three markers can be detected.
+     * Distance between the left-top and the right-top marker corner, as a fraction of the shorter side of the full frame.
+     * The detector derives its scales from it, so the same spacing works at every resolution of the frame.
+     */
+    const double MARKER_SPACING = 0.55;
+
+    /**
+     * @brief Returns the expected distance between the markers in a full frame of the given size, in its pixels.
+     *        Regions of the frame are searched with the spacing of the full frame, see detect.
+     */
+    double markerSpacing(int32_t cols, int32_t rows);
+
+    /**
+     * @brief How the threshold that separates the markers from the rest of the frame is chosen.
+     */
+    enum class ThresholdSelection {
+        /** Fixed thresholds are tried one by one */
+        SWEEP,
+        /** Thresholds are picked from the histogram of the frame, the fixed thresholds are only tried when those fail */
+        HISTOGRAM
+    };
+
+    /**
+     * @brief The outcome of a detection.
+     */
+    struct Detection {
+        /** The corners, as returned by detectMarkers */
+        std::vector<Point<int32_t>> points;
+        /** The same corners refined to subpixels, points are these rounded */
+        std::vector<Point<double>> corners;
+        /** The threshold the markers were found at, or the last one tried when they were not found */
+        uint8_t threshold = 0;
+        /** How many thresholds come before the result in list order, including it, as if they were tried one by one */
+        uint32_t attempts = 0;
+        /** How many thresholds were actually tried, which can be more than attempts when they are tried concurrently */
+        uint32_t evaluated = 0;
+    };
+
+    /**
+     * @brief Detects markers like detectMarkers does, and tells how the markers were found.
+     * @param workers With more than one worker, thresholds are tried concurrently on the same gray image.
+     *        Thresholds after one that found the markers are not started anymore, and the result is the
+     *        one of the first threshold in list order that found them, so it does not depend on the workers.
+     *        The worker threads are started once and reused by every detection.
+     * @param spacing The expected distance between the markers in pixels of img, see markerSpacing.
+     *        0 when img is the whole frame, so the spacing follows from its size.
+     */
+    Detection detect(const image_t* img, ThresholdSelection selection = ThresholdSelection::HISTOGRAM, uint32_t workers = 1, double spacing = 0.0);
+    /**
+     * @brief Detects markers in the given RGB888 or grayscale basic image. Up to three markers can be detected.
      * @return The coordinate of the sharp corner for each marker.
      *         The order is clockwise with the last and first corner having the
      *         greatest difference in angle from the centroid.
      *         In other words: left-top, right-top, right-bottom.
      */
     std::vector<Point<int32_t>> detectMarkers(const image_t* img);
-    std::vector<Point<int32_t>> detectPoints(const image_t* img, const uint8_t thresh_val);
+    std::vector<Point<int32_t>> detectPoints(const image_t* img, const uint8_t thresh_val, double spacing = 0.0);
+    /**
+     * @brief Moves every corner to where the edges of its marker meet, with subpixel precision.
+     *        Corners detected in a downscaled frame can be scaled up and refined in the full resolution frame.
+     * @param img An RGB888 or grayscale basic image.
+     * @param corners The corners in the order of detectMarkers, each within a few pixels of its marker corner.
+     * @param spacing The expected distance between the markers in pixels of img, which sets the size of the window around each corner.
+     *        0 when img is the whole frame.
+     * @return The refined corners. A corner without two edges around it is returned as it was.
+     */
+    std::vector<Point<double>> refineCorners(const image_t* img, const std::vector<Point<double>>& corners, double spacing = 0.0);
 }
 
 } // namespace cpparas
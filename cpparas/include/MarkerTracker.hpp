@@ -0,0 +1,100 @@
+#ifndef MARKERTRACKER_HPP
+#define MARKERTRACKER_HPP
+
+#include "operators.h"
+#include "types/Point.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cpparas {
+
+/** Half the size of the window that is searched around each previous corner, in full resolution pixels. */
+const int32_t MARKER_TRACKING_WINDOW_RADIUS = 64;
+/** Tracking is lost below this confidence, and the next frame is searched as a whole. */
+const double MARKER_TRACKING_MIN_CONFIDENCE = 0.6;
+
+/**
+ * @brief How often the markers were tracked and how often the whole frame had to be searched.
+ */
+struct TrackingStatistics {
+    /** Frames in which the markers were found in the windows around the previous corners */
+    uint64_t trackedFrames = 0;
+    /** Frames in which the whole frame was searched */
+    uint64_t fullSearches = 0;
+    /** Full searches that found the markers */
+    uint64_t foundSearches = 0;
+    /** Thresholds the detector tried in all full searches */
+    uint64_t detectionAttempts = 0;
+    /** Times tracking was lost, after which the whole frame was searched */
+    uint64_t lostTracks = 0;
+    /** Confidence of the last tracked frame, between 0 and 1 */
+    double confidence = 0.0;
+
+    /**
+     * @brief Returns the statistics as a line of text for the debug window.
+     */
+    std::string summary() const;
+};
+
+/**
+ * @brief Finds the three markers the way MarkerDetector does, but once found, only searches small windows
+ *        around the previous corners. The whole frame is searched again when tracking is lost.
+ *        Corners are the sharp marker corners, in the order of MarkerDetector::detectMarkers.
+ */
+class MarkerTracker {
+public:
+    MarkerTracker(int32_t windowRadius = MARKER_TRACKING_WINDOW_RADIUS, double minConfidence = MARKER_TRACKING_MIN_CONFIDENCE);
+
+    /**
+     * @brief Finds the markers in the given frame.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     * @param origin Where the frame starts in full resolution pixels, when it only shows a region.
+     * @param spacing The expected distance between the markers in full resolution pixels, see MarkerDetector::markerSpacing.
+     *        0 when img is the whole frame, a region needs the spacing of the full frame to be searched.
+     * @return The three corners in full resolution pixels, or fewer when the markers were not found.
+     */
+    std::vector<Point<int32_t>> update(const image_t* img, const Point<int32_t>& origin = { 0, 0 }, double spacing = 0.0);
+    /**
+     * @brief Forgets the tracked corners, so the next frame is searched as a whole.
+     */
+    void reset();
+
+    bool isTracking() const;
+    /**
+     * @brief Returns how sure the tracker is of the last tracked corners, between 0 and 1.
+     */
+    double getConfidence() const;
+    TrackingStatistics getStatistics() const;
+    void resetStatistics();
+
+private:
+    // The marker corner found in one window
+    struct Window {
+        Point<int32_t> corner;
+        // The fraction of the square next to the corner that lies within the marker
+        double fill;
+        bool clipped;
+    };
+
+    // Finds the sharp corner of a marker in the window around the given corner, in frame pixels.
+    bool findCorner(const image_t* img, const Point<int32_t>& around, std::size_t index, Window& window) const;
+    // Finds all three corners around the given corners, in full resolution pixels.
+    bool findCorners(const image_t* img, const Point<int32_t>& origin, const std::vector<Point<int32_t>>& around, std::vector<Window>& windows) const;
+    double confidenceOf(const std::vector<Window>& windows) const;
+    std::vector<Point<int32_t>> search(const image_t* img, const Point<int32_t>& origin, double spacing);
+
+    int32_t windowRadius;
+    double minConfidence;
+    bool tracking;
+    std::vector<Point<int32_t>> corners;
+    // Distances between the markers when they were found by a full search
+    std::vector<double> referenceSides;
+    TrackingStatistics statistics;
+    mutable std::mutex statisticsMtx;
+};
+
+} // namespace cpparas
+
+#endif /* MARKERTRACKER_HPP */
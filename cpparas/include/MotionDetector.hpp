@@ -0,0 +1,86 @@
+#ifndef MOTIONDETECTOR_HPP
+#define MOTIONDETECTOR_HPP
+
+#include "operators.h"
+#include "types/Rect.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpparas {
+
+/** Size of the gray image frames are compared on. */
+const uint32_t MOTION_GRID_COLS = 64;
+const uint32_t MOTION_GRID_ROWS = 64;
+/** Tiles are squares of this many gray image pixels. */
+const uint32_t MOTION_TILE_SIZE = 8;
+/** A tile changed when its pixels differ by more than this on average. */
+const double MOTION_THRESHOLD = 8.0;
+
+/**
+ * @brief Tells which parts of a frame changed, by comparing a heavily downscaled gray frame in tiles.
+ *        Every user of the change signal keeps its own reference frame, which it replaces with the
+ *        current frame once it has looked at it, so slow changes add up until they are noticed.
+ */
+class MotionDetector {
+public:
+    MotionDetector(uint32_t cols = MOTION_GRID_COLS, uint32_t rows = MOTION_GRID_ROWS, uint32_t tileSize = MOTION_TILE_SIZE, double threshold = MOTION_THRESHOLD);
+
+    /**
+     * @brief Adds a reference frame. Everything counts as changed until the reference is accepted.
+     * @return The index of the reference.
+     */
+    std::size_t addReference();
+
+    /**
+     * @brief Downscales the current frame.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     * @param fieldOfView The part of the full resolution frame the image shows.
+     *        Frames are only compared with references that show the same field of view,
+     *        so frames at another resolution can be compared, but frames of another region can't.
+     */
+    void update(const image_t* img, const Rect<int32_t>& fieldOfView);
+    /**
+     * @brief Returns whether a tile that overlaps the region changed since the reference was accepted.
+     * @param region In full resolution pixels. A region without width or height stands for the whole frame.
+     */
+    bool changed(std::size_t reference, const Rect<int32_t>& region) const;
+    /**
+     * @brief Returns the highest tile score in the region, in gray levels,
+     *        or a score above any threshold when the reference can't be compared.
+     */
+    double score(std::size_t reference, const Rect<int32_t>& region) const;
+    /**
+     * @brief Makes the current frame the reference.
+     */
+    void accept(std::size_t reference);
+    /**
+     * @brief Returns the score of every tile, row by row.
+     */
+    std::vector<double> tileScores(std::size_t reference) const;
+
+    uint32_t getTileCols() const;
+    uint32_t getTileRows() const;
+
+private:
+    struct Reference {
+        std::vector<uint8_t> pixels;
+        Rect<int32_t> fieldOfView;
+        bool valid;
+    };
+
+    double tileScore(const Reference& reference, uint32_t tileCol, uint32_t tileRow) const;
+    bool comparable(const Reference& reference) const;
+
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t tileSize;
+    double threshold;
+    std::vector<uint8_t> current;
+    Rect<int32_t> fieldOfView;
+    std::vector<Reference> references;
+};
+
+} // namespace cpparas
+
+#endif /* MOTIONDETECTOR_HPP */
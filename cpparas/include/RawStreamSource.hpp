@@ -0,0 +1,52 @@
+#ifndef RAWSTREAMSOURCE_HPP
+#define RAWSTREAMSOURCE_HPP
+
+#include "FrameSource.hpp"
+#include "operators.h"
+#include <stdio.h>
+#include <string>
+
+namespace cpparas {
+
+/**
+ * @brief Frame source that replays a raw stream file,
+ *        which holds the same bytes `raspivid --raw-format rgb`, `yuv` or `gray` writes to its pipe.
+ * @note The frames need to be stored without padding, which is what `raspivid` writes
+ *       when the width is a multiple of 32 and the height a multiple of 16.
+ */
+class RawStreamSource : public FrameSource {
+public:
+    /**
+     * @param filePath The stream file.
+     * @param cols The frame width the stream was recorded with.
+     * @param rows The frame height the stream was recorded with.
+     * @param loop Whether to start over at the end of the file. Otherwise the source stops.
+     * @param format The format the stream was recorded in.
+     */
+    RawStreamSource(const std::string& filePath, uint32_t cols, uint32_t rows, double frameRate, bool loop = true, FrameFormat format = FrameFormat::RGB888);
+    ~RawStreamSource() override;
+
+    /**
+     * @brief Tells the format of a stream file from its extension: .rgb, .yuv or .gray, like the `--raw-format` it was recorded with.
+     * @return Whether the file is a raw stream.
+     */
+    static bool formatOfFile(const std::string& filePath, FrameFormat& format);
+
+protected:
+    bool open() override;
+    bool readFrame(image_t* dst) override;
+    void close() override;
+    FrameFormat nativeFormat() const override;
+
+private:
+    std::string filePath;
+    uint32_t cols;
+    uint32_t rows;
+    bool loop;
+    FrameFormat streamFormat;
+    FILE* file;
+};
+
+} // namespace cpparas
+
+#endif /* RAWSTREAMSOURCE_HPP */
@@ -2,6 +2,7 @@
 #define REGIONEXTRACTOR_HPP
 
 #include "MarkerDetector.hpp"
+#include "MarkerTracker.hpp"
 #include "operators.h"
 
 namespace cpparas {
@@ -20,14 +21,86 @@ public:
      * @brief Returns the region image.
      */
     image_t* getRegionImage();
+    /**
+     * @brief Finds the markers, only around the previous corners while they can be tracked.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     * @param origin Where the image starts in full resolution pixels, when it only shows a region.
+     * @param spacing The expected distance between the markers in full resolution pixels, 0 when img is the whole frame.
+     * @return The marker coordinates in full resolution pixels.
+     */
+    std::vector<Point<int32_t>> locateMarkers(const image_t* img, const Point<int32_t>& origin = { 0, 0 }, double spacing = 0.0);
+    /**
+     * @brief Searches the whole next frame for the markers.
+     */
+    void resetTracking();
+    TrackingStatistics getTrackingStatistics() const;
+    /**
+     * @brief Tells the geometry of the camera, so the fourth corner of the baseplate follows from the perspective of the other three.
+     * @param focalLength The focal length in full resolution pixels, 0 when unknown.
+     * @param principalPoint Where the optical axis meets the frame, in full resolution pixels.
+     */
+    void setCamera(double focalLength, const Point<double>& principalPoint);
+    /**
+     * @brief Adds the left-bottom corner to the marker corners, where the square baseplate puts it with the perspective of the camera.
+     *        Without the camera geometry, or when the perspective can't be solved, the corners are completed to a parallelogram.
+     * @param corners The left-top, right-top and right-bottom corner in full resolution pixels.
+     */
+    std::vector<Point<int32_t>> completeCorners(const std::vector<Point<int32_t>>& corners) const;
+    /**
+     * @brief Tells the size of the baseplate, so the corners of the region image are the centers of the corner studs
+     *        instead of the marker corners, which lie on the corners of the baseplate.
+     * @param studCols The width of the baseplate in studs, 0 when the region spans the marker corners.
+     * @param studRows The length of the baseplate in studs.
+     */
+    void setBaseplate(uint32_t studCols, uint32_t studRows);
+    /**
+     * @brief Moves the corners of the baseplate half a stud inwards along its sides, onto the centers of the corner studs.
+     *        Without the size of the baseplate the corners are returned as they are.
+     * @param corners The three marker corners, or four corners from completeCorners.
+     */
+    std::vector<Point<int32_t>> studCorners(const std::vector<Point<int32_t>>& corners) const;
     /**
      * @brief Runs the marker detection and crops the input image to the region image.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     * @param chromaU The U plane when img is the Y plane of a YUV420 frame.
+     * @param chromaV The V plane when img is the Y plane of a YUV420 frame.
      * @return The detected marker coordinates.
      */
-    std::vector<Point<int32_t>> updateImage(const image_t* img);
+    std::vector<Point<int32_t>> updateImage(const image_t* img, const image_t* chromaU = nullptr, const image_t* chromaV = nullptr);
+    /**
+     * @brief Crops the input image to the region image using known marker coordinates.
+     *        Only the pixels of the region are converted to RGB for YUV420 and grayscale input.
+     * @param corners The three marker corners for an affine warp, or four corners from completeCorners
+     *                to take the perspective out of the region. They are moved onto the corner studs by studCorners.
+     */
+    void extractRegion(const image_t* img, const image_t* chromaU, const image_t* chromaV, const std::vector<Point<int32_t>>& corners);
+    /**
+     * @brief Crops the input image to dst instead of the region image, e.g. a slot of a FrameChannel.
+     * @param dst An RGB888 image.
+     * @param hsvDst An HSV image of the size of dst that is filled in the same pass, or nullptr.
+     */
+    void extractRegion(const image_t* img, const image_t* chromaU, const image_t* chromaV, const std::vector<Point<int32_t>>& corners, image_t* dst, image_t* hsvDst = nullptr);
+    /**
+     * @brief Returns how often the warp table was made, it is only made again when the corners or the image sizes change.
+     */
+    uint32_t getWarpTableBuilds() const;
 
 private:
+    /**
+     * @brief Makes the warp table again when the corners or the sizes differ from the ones it was made for.
+     * @return Whether the table holds the warp of the corners, it doesn't when there was no memory for it.
+     */
+    bool updateWarpTable(const image_t* img, const std::vector<Point<int32_t>>& corners, const image_t* dst);
+
     image_t* regionImage;
+    MarkerTracker tracker;
+    warp_table_t* warpTable;
+    std::vector<Point<int32_t>> warpCorners;
+    uint32_t warpTableBuilds;
+    double focalLength;
+    Point<double> principalPoint;
+    uint32_t studCols;
+    uint32_t studRows;
 };
 
 } // namespace cpparas
@@ -1,7 +1,6 @@
 #ifndef STATEMACHINE_HPP
 #define STATEMACHINE_HPP
 
-#include "CoordinateMatrix.hpp"
 #include "HandDetection.hpp"
 #include "ImageLoader.hpp"
 #include "LSFParser.hpp"
@@ -9,6 +8,7 @@
 #include "Projection.hpp"
 #include "RegionExtractor.hpp"
 #include "StudChecker.hpp"
+#include "StudGrid.hpp"
 #include "util/GenericStateMachine.hpp"
 #include "util/StateStep.hpp"
 #include <chrono>
@@ -17,6 +17,8 @@
 namespace cpparas {
 
 const float PROJECT_OFF_DELAY = 1.0f; // Seconds
+/** How often the locator looks at new frames in states that don't wait for a frame, in frames per second. */
+const double LOCATOR_IDLE_RATE = 10.0;
 
 enum class State {
     NOT_STARTED,
@@ -45,6 +47,12 @@ public:
 
     StateStep getStateStep() const;
     std::shared_ptr<Projection> getProjection() const;
+    /**
+     * @brief Returns which captured frame the state machine looked at last.
+     */
+    FrameInfo getFrameInfo() const;
+    CaptureStatistics getCaptureStatistics() const;
+    std::shared_ptr<Locator> getLocator() const;
 
     /**
      * @brief Sets the sequence data to be used in the program.
@@ -52,6 +60,12 @@ public:
      */
     void setLSFData(const LSFParser::LSFData& data);
 
+    /**
+     * @brief Limits how often the locator looks at new frames while in the given state.
+     * @param frameRate Frames per second, or FRAME_RATE_UNLIMITED.
+     */
+    void setLocatorRate(State state, double frameRate);
+
     void simulateBaseplateShifted(bool baseplateShifted);
     void simulateHand(bool handPresent);
 
@@ -65,6 +79,15 @@ private:
     std::pair<bool, StateStep> nextStateStep(StateStep fromStep) const;
 
     void doHook();
+    /**
+     * @brief Takes a new cut frame of the locator and remembers which captured frame it came from.
+     * @return nullptr if there is no new frame yet.
+     */
+    std::shared_ptr<const Frame> takeFrame(FrameSubscriber& frames);
+    /**
+     * @brief Runs the hand detection on a new cut frame, unless the scene didn't change since the last one.
+     */
+    void updateHandDetection();
 
     void INIT_entry();
     void INIT_do();
@@ -109,11 +132,19 @@ private:
     bool simulatedBaseplateShifted;
     std::chrono::time_point<std::chrono::system_clock> projectOffStartTime;
     StateStep stateStep;
+    FrameInfo frameInfo;
+    // Locator rates of the states that don't run at LOCATOR_IDLE_RATE
+    std::map<State, double> locatorRates;
     LSFParser::LSFData lsfData;
-    CoordinateMatrix coordinateMatrix;
     HandDetection handDetection;
+    bool handChecked;
+    uint64_t handSceneChanges;
     std::shared_ptr<Projection> projection;
     std::shared_ptr<Locator> locator;
+    // Stud verification and hand detection take frames independently
+    std::shared_ptr<FrameSubscriber> studFrames;
+    std::shared_ptr<FrameSubscriber> handFrames;
+    Histogram frameAge;
 };
 
 } // namespace cpparas
@@ -0,0 +1,34 @@
+#ifndef STILLIMAGESOURCE_HPP
+#define STILLIMAGESOURCE_HPP
+
+#include "FrameSource.hpp"
+#include "operators.h"
+
+namespace cpparas {
+
+/**
+ * @brief Frame source that delivers a still image.
+ *        The image is only published again when another stream mode or region of interest is asked for.
+ */
+class StillImageSource : public FrameSource {
+public:
+    /**
+     * @param image The image to deliver. It is copied, so the caller keeps ownership.
+     */
+    StillImageSource(const image_t* image, double frameRate = 20.0);
+    ~StillImageSource() override;
+
+    bool deliversStillFrames() const override;
+
+protected:
+    bool open() override;
+    bool readFrame(image_t* dst) override;
+    void close() override;
+
+private:
+    image_t* stillImage;
+};
+
+} // namespace cpparas
+
+#endif /* STILLIMAGESOURCE_HPP */
@@ -0,0 +1,127 @@
+#ifndef STUDGRID_HPP
+#define STUDGRID_HPP
+
+#include "operators.h"
+#include "types/Calibration.hpp"
+#include "types/Point.hpp"
+#include "util/Frame.hpp"
+#include <memory>
+#include <vector>
+
+namespace cpparas {
+
+/** Pixels along each side of a stud in a stud frame, a multiple of 4 */
+const uint32_t STUD_GRID_PIXELS = 8;
+/** Layers in a stud frame: the bottom layer, which holds the reference colors, above the layer that is checked */
+const uint32_t STUD_FRAME_LAYERS = 2;
+
+/**
+ * @brief Samples the studs of a layer straight from the camera frame onto the stud lattice: every stud gets
+ *        a block of studPixels x studPixels pixels, so a stud is found by indexing its block.
+ *        Each layer has a warp table of its own, made from the corners of the baseplate with the parallax of
+ *        the layer, and only made again when the corners, the frame size or the layer change.
+ */
+class StudGrid {
+public:
+    /**
+     * @brief Creates a stud grid without corners.
+     * @param studPixels Pixels along each side of a stud, a multiple of 4.
+     */
+    StudGrid(Calibration calibration, uint32_t studPixels = STUD_GRID_PIXELS);
+    ~StudGrid();
+    StudGrid(const StudGrid&) = delete;
+    StudGrid& operator=(const StudGrid&) = delete;
+
+    /**
+     * @brief Returns the pixels along each side of a stud.
+     */
+    uint32_t getStudPixels() const;
+    /**
+     * @brief Returns the size of a stud frame: baseplateCols blocks wide and baseplateRows blocks of every layer high.
+     */
+    uint32_t getCols() const;
+    uint32_t getRows() const;
+
+    /**
+     * @brief Sets the corners of the baseplate in the frames that are sampled.
+     * @param corners The four outer corners of the baseplate, like RegionExtractor::completeCorners makes.
+     */
+    void setCorners(const std::vector<Point<int32_t>>& corners);
+    /**
+     * @brief Sets the layer that is sampled below the bottom layer.
+     */
+    void setLayer(uint32_t layer);
+    uint32_t getLayer() const;
+
+    /**
+     * @brief Gathers the studs of the bottom layer and of the checked layer from the frame, and makes their HSV image in the same pass.
+     * @param img An RGB888 image, or the basic Y plane of a YUV420 or grayscale frame.
+     * @param dst An RGB888 image of getCols() x getRows().
+     * @param hsvDst An HSV image of the same size, or nullptr.
+     * @return Whether dst was filled, it isn't without corners or without memory for the warp tables.
+     */
+    bool sample(const image_t* img, const image_t* chromaU, const image_t* chromaV, image_t* dst, image_t* hsvDst);
+    /**
+     * @brief Returns how often the warp table of a layer was made.
+     */
+    uint32_t getTableBuilds() const;
+
+private:
+    // Fills the rows of the table that hold the block of the layer
+    bool updateBlock(uint32_t block, uint32_t layer, const image_t* img, const image_t* dst);
+    // How much further from the center the studs of the layer appear than those of the bottom layer
+    double layerScale(uint32_t layer) const;
+
+    Calibration calibration;
+    uint32_t studPixels;
+    uint32_t layer;
+    std::vector<Point<int32_t>> corners;
+    warp_table_t* table;
+    // The layer each block of the table was made for, or -1 when it has to be made again
+    int32_t tableLayers[STUD_FRAME_LAYERS];
+    uint32_t tableBuilds;
+};
+
+/**
+ * @brief Reads the studs of a frame that StudGrid::sample filled.
+ */
+class StudFrame {
+public:
+    /**
+     * @param frame A stud frame of the Locator, its info tells which layer it holds below the bottom layer.
+     * @param studPixels Pixels along each side of a stud, as the StudGrid that sampled the frame.
+     */
+    StudFrame(std::shared_ptr<const Frame> frame, uint32_t studPixels = STUD_GRID_PIXELS);
+
+    /**
+     * @brief Returns whether the frame holds the studs of the layer.
+     */
+    bool hasLayer(uint32_t layer) const;
+    /**
+     * @brief Returns the RGB888 image of the frame.
+     */
+    const image_t* getImage() const;
+    /**
+     * @brief Returns the HSV image of the frame, which was made while sampling.
+     */
+    const image_t* getHSVImage() const;
+    uint32_t getStudPixels() const;
+
+    /**
+     * @brief Returns the left-top pixel of the block of the stud.
+     * @throws std::invalid_argument When the frame doesn't hold the layer.
+     */
+    Point<int32_t> blockPosition(uint32_t layer, const Point<uint32_t>& stud) const;
+    /**
+     * @brief Returns the average HSV color of the central half of the stud block.
+     */
+    hsv_pixel_t studColor(uint32_t layer, const Point<uint32_t>& stud) const;
+
+private:
+    std::shared_ptr<const Frame> frame;
+    uint32_t studPixels;
+};
+
+} // namespace cpparas
+
+#endif /* STUDGRID_HPP */
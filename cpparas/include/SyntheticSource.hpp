@@ -0,0 +1,56 @@
+#ifndef SYNTHETICSOURCE_HPP
+#define SYNTHETICSOURCE_HPP
+
+#include "FrameSource.hpp"
+#include "operators.h"
+#include "types/Point.hpp"
+#include <atomic>
+#include <vector>
+
+namespace cpparas {
+
+/**
+ * @brief Frame source that renders a baseplate with three corner markers on a table,
+ *        optionally with a hand over the baseplate. Useful to run the whole pipeline without a camera.
+ */
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource(uint32_t cols, uint32_t rows, double frameRate);
+    ~SyntheticSource() override;
+
+    /**
+     * @brief Sets whether a hand is rendered over the baseplate.
+     */
+    void setHandPresent(bool handPresent);
+    /**
+     * @brief Moves the baseplate away from its centered position.
+     */
+    void setBaseplateOffset(int32_t cols, int32_t rows);
+    /**
+     * @brief Returns the outer corners of the markers in the same order as MarkerDetector::detectMarkers:
+     *        left-top, right-top, right-bottom.
+     */
+    std::vector<Point<int32_t>> getMarkerCorners() const;
+
+protected:
+    bool open() override;
+    bool readFrame(image_t* dst) override;
+    void close() override;
+
+private:
+    void renderScene(image_t* dst) const;
+    void renderHand(image_t* dst) const;
+
+    uint32_t cols;
+    uint32_t rows;
+    std::atomic<bool> handPresent;
+    std::atomic<int32_t> offsetCols;
+    std::atomic<int32_t> offsetRows;
+    image_t* scene;
+    int32_t sceneOffsetCols;
+    int32_t sceneOffsetRows;
+};
+
+} // namespace cpparas
+
+#endif /* SYNTHETICSOURCE_HPP */
@@ -24,6 +24,7 @@ private:
     Gtk::ScrolledWindow logViewport;
     Gtk::TextView logTextView;
     Gtk::Label stateNameLabel;
+    Gtk::Label captureLabel;
     Gtk::ScrolledWindow imageViewport;
     Gtk::Grid imageContainer;
     ImageArea imageArea;
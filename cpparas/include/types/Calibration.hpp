@@ -21,9 +21,10 @@ struct Calibration {
     float cameraHeight;
 
     /* Camera capture resolution */
-    /* TODO: Use this in Camera */
     uint32_t captureResolutionCols;
     uint32_t captureResolutionRows;
+    /** Where the center of the baseplate lies under the projector, from the center of the capture in pixels */
+    Point<int32_t> projectorCenterOffset;
 
     /** Projection width in meters */
     float projectionWidth;
@@ -82,6 +83,8 @@ const Calibration DEFAULT_CALIBRATION = constructS(Calibration,
 
     _.captureResolutionCols = 1440,
     _.captureResolutionRows = 1440,
+    // The camera is not perfectly centered to the projector
+    _.projectorCenterOffset = { 0, -50 },
 
     _.projectionWidth = 0.60f,
     _.projectionHeight = 0.40f,
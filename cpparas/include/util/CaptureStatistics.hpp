@@ -0,0 +1,98 @@
+#ifndef CAPTURESTATISTICS_HPP
+#define CAPTURESTATISTICS_HPP
+
+#include "types/Rect.hpp"
+#include "util/FrameRing.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cpparas {
+
+/**
+ * @brief Which frame a processed image was made from.
+ */
+struct FrameInfo {
+    /** 0 means no frame has been processed yet. */
+    uint64_t sequence = 0;
+    CaptureClock::time_point timestamp;
+    Rect<int32_t> fieldOfView = { { 0, 0 }, 0, 0 };
+    /** How often the scene changed before this frame was cut, see Locator::Scene_changes. */
+    uint64_t sceneChanges = 0;
+    /** The layer a stud frame holds below the bottom layer, see StudGrid. */
+    uint32_t studLayer = 0;
+};
+
+/**
+ * @brief Counts values in buckets of a fixed width, e.g. durations in milliseconds.
+ *        Values past the last bucket are counted in the last bucket, but min, max and mean stay exact.
+ */
+class Histogram {
+public:
+    Histogram(double bucketWidth = 1.0, std::size_t bucketCount = 200);
+
+    void add(double value);
+    void reset();
+
+    uint64_t getCount() const;
+    double getMin() const;
+    double getMax() const;
+    double getMean() const;
+    /**
+     * @brief Returns the upper edge of the bucket that holds the given fraction of the values.
+     * @param fraction Between 0 and 1, e.g. 0.99 for the 99th percentile.
+     */
+    double getPercentile(double fraction) const;
+    double getBucketWidth() const;
+    const std::vector<uint64_t>& getBuckets() const;
+
+    /**
+     * @brief Returns e.g. "n=120 mean=33.4 p50=34 p99=41 max=52.1".
+     */
+    std::string summary() const;
+
+private:
+    double bucketWidth;
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+};
+
+/**
+ * @brief Counters and histograms of the capture path, from the device to the reader of a FrameSource.
+ *        Durations are in milliseconds.
+ */
+struct CaptureStatistics {
+    /** Frames published to the frame ring */
+    uint64_t capturedFrames = 0;
+    /** Frames dropped after (re)starting the device while it adjusts */
+    uint64_t warmupFrames = 0;
+    /** Frames the device or pipe dropped before they were read, because a newer frame was available */
+    uint64_t droppedFrames = 0;
+    /** Frames that were read but not published, because the reader held every free slot */
+    uint64_t discardedFrames = 0;
+    /** Published frames the reader never took, because a newer frame was already available */
+    uint64_t skippedFrames = 0;
+    /** Frames the reader took */
+    uint64_t consumedFrames = 0;
+
+    /** Time between two published frames */
+    Histogram frameInterval;
+    /** Time the backend took to read one frame, including waiting for the device */
+    Histogram readDuration;
+    /** Age of a frame when the reader took it */
+    Histogram readerLag;
+    /** Age of the frame behind a cut frame when the state machine took it, filled in by the state machine */
+    Histogram frameAge;
+
+    /**
+     * @brief Returns the statistics as lines of text for the debug window.
+     */
+    std::string summary() const;
+};
+
+} // namespace cpparas
+
+#endif /* CAPTURESTATISTICS_HPP */
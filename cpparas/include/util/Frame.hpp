@@ -0,0 +1,96 @@
+#ifndef FRAME_HPP
+#define FRAME_HPP
+
+#include "operators.h"
+#include "util/CaptureStatistics.hpp"
+#include "util/FrameRing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cpparas {
+
+class FramePool;
+
+/**
+ * @brief An image together with the captured frame it was made from.
+ *        A frame is written through a std::shared_ptr<Frame> and handed out as a std::shared_ptr<const Frame>,
+ *        after which nobody writes to it anymore. The image goes back to its pool when the last reference is dropped.
+ */
+class Frame {
+public:
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+    const image_t* getImage() const;
+    image_t* getImage();
+    /**
+     * @brief Returns the RGB888 image converted to HSV. It is converted once for everyone that reads the frame,
+     *        the first time it is asked for, unless the writer filled it already through provideHSVImage.
+     */
+    const image_t* getHSVImage() const;
+    /**
+     * @brief Returns the HSV image for the writer to fill together with the image, e.g. in the same pass.
+     */
+    image_t* provideHSVImage();
+    const FrameInfo& getInfo() const;
+    void setInfo(const FrameInfo& info);
+
+private:
+    friend class FramePool;
+
+    Frame(image_t* image);
+    ~Frame();
+    // Allocates the HSV image the first time the frame needs one, it is kept when the frame is reused. Needs the lock.
+    image_t* hsvImageLocked() const;
+
+    image_t* image;
+    FrameInfo info;
+    mutable image_t* hsvImage;
+    mutable bool hsvValid;
+    mutable std::mutex hsvMtx;
+};
+
+/**
+ * @brief Hands out frames of one size and layout and reuses their images once they are no longer referenced.
+ *        Frames may outlive the pool, in which case they free their image themselves.
+ */
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+    static std::shared_ptr<FramePool> create(uint32_t cols, uint32_t rows, FrameFormat format);
+    ~FramePool();
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Returns a frame that nobody else references, allocating one if every frame is in use.
+     *        The image content is whatever the previous user left in it.
+     */
+    std::shared_ptr<Frame> acquire();
+
+    /**
+     * @brief Returns the number of frames allocated by the pool, in use or not.
+     */
+    std::size_t getAllocatedFrames() const;
+    /**
+     * @brief Returns the number of frames waiting in the pool to be reused.
+     */
+    std::size_t getFreeFrames() const;
+
+private:
+    FramePool(uint32_t cols, uint32_t rows, FrameFormat format);
+    static void recycle(const std::weak_ptr<FramePool>& pool, Frame* frame);
+
+    uint32_t cols;
+    uint32_t rows;
+    FrameFormat format;
+    std::vector<Frame*> freeFrames;
+    std::size_t allocatedFrames;
+    mutable std::mutex mtx;
+};
+
+} // namespace cpparas
+
+#endif /* FRAME_HPP */
@@ -0,0 +1,142 @@
+#ifndef FRAMECHANNEL_HPP
+#define FRAMECHANNEL_HPP
+
+#include "operators.h"
+#include "util/CaptureStatistics.hpp"
+#include "util/Frame.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace cpparas {
+
+/**
+ * @brief What a subscriber of a FrameChannel gets when it falls behind.
+ */
+enum class DropPolicy {
+    /** Always take the newest frame and skip the ones in between, e.g. for detection and previews. */
+    LATEST,
+    /** Take the frames in order. Frames are only skipped when the subscriber falls behind more than the channel depth. */
+    NEXT,
+};
+
+class FrameSubscriber;
+
+/**
+ * @brief Broadcasts frames from one publisher to any number of subscribers without copying.
+ *        Every subscriber has its own cursor and drop policy, and the publisher never waits for a subscriber:
+ *        a frame that is still referenced is left alone and the publisher writes into another frame of the pool.
+ */
+class FrameChannel : public std::enable_shared_from_this<FrameChannel> {
+public:
+    /**
+     * @brief Creates a channel of frames with the given size and layout.
+     * @param depth The number of published frames kept for NEXT subscribers.
+     */
+    static std::shared_ptr<FrameChannel> create(uint32_t cols, uint32_t rows, FrameFormat format, std::size_t depth = 4);
+    FrameChannel(const FrameChannel&) = delete;
+    FrameChannel& operator=(const FrameChannel&) = delete;
+
+    /**
+     * @brief Returns a frame from the pool of the channel to write the next frame into.
+     *        Dropping it without publishing gives it back to the pool.
+     */
+    std::shared_ptr<Frame> acquire();
+    /**
+     * @brief Publishes a frame and wakes up waiting subscribers.
+     *        The publisher must not write to the frame afterwards.
+     */
+    void publish(std::shared_ptr<Frame> frame);
+
+    /**
+     * @brief Wakes up waiting subscribers and lets them know no frames are coming for now.
+     */
+    void close();
+    /**
+     * @brief Lets the publisher publish again after the channel was closed.
+     */
+    void open();
+    bool isClosed() const;
+
+    /**
+     * @brief Adds a subscriber. The newest frame, if any, is the first frame it can take.
+     */
+    std::shared_ptr<FrameSubscriber> subscribe(DropPolicy policy);
+
+    const FramePool& getPool() const;
+
+private:
+    friend class FrameSubscriber;
+
+    struct Published {
+        // Position in the channel, counted from 1
+        uint64_t index;
+        std::shared_ptr<const Frame> frame;
+    };
+
+    FrameChannel(uint32_t cols, uint32_t rows, FrameFormat format, std::size_t depth);
+    // Returns the frame a subscriber takes next, or nullptr. Needs the lock.
+    const Published* next(uint64_t cursor, DropPolicy policy) const;
+
+    std::shared_ptr<FramePool> pool;
+    std::size_t depth;
+    // Published frames, oldest first
+    std::deque<Published> history;
+    uint64_t publishedFrames;
+    bool closed;
+    mutable std::mutex mtx;
+    std::condition_variable condVar;
+};
+
+/**
+ * @brief A cursor into a FrameChannel.
+ *        A taken frame stays valid and unchanged for as long as the caller keeps a reference to it.
+ * @note A subscriber is meant to be used by one thread.
+ */
+class FrameSubscriber {
+public:
+    FrameSubscriber(const FrameSubscriber&) = delete;
+    FrameSubscriber& operator=(const FrameSubscriber&) = delete;
+
+    /**
+     * @brief Takes a frame that is newer than the last taken frame. Does not wait.
+     * @return nullptr if there is no new frame.
+     */
+    std::shared_ptr<const Frame> tryTake();
+    /**
+     * @brief Takes a frame that is newer than the last taken frame, waiting for it up to the timeout.
+     * @return nullptr on a timeout or when the channel was closed.
+     */
+    std::shared_ptr<const Frame> take(std::chrono::milliseconds timeout);
+    /**
+     * @brief Lets the newest frame be taken again, e.g. when the publisher only publishes frames that changed
+     *        and the subscriber needs a frame to look at now.
+     */
+    void rewind();
+
+    DropPolicy getPolicy() const;
+    /**
+     * @brief Returns the number of published frames this subscriber skipped.
+     */
+    uint64_t getDroppedFrames() const;
+    bool isClosed() const;
+
+private:
+    friend class FrameChannel;
+
+    FrameSubscriber(std::shared_ptr<FrameChannel> channel, DropPolicy policy, uint64_t cursor);
+    // Moves the cursor to the given frame. Needs the lock.
+    std::shared_ptr<const Frame> takePublished(const FrameChannel::Published* published);
+
+    std::shared_ptr<FrameChannel> channel;
+    DropPolicy policy;
+    uint64_t cursor;
+    uint64_t droppedFrames;
+};
+
+} // namespace cpparas
+
+#endif /* FRAMECHANNEL_HPP */
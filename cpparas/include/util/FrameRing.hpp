@@ -0,0 +1,135 @@
+#ifndef FRAMERING_HPP
+#define FRAMERING_HPP
+
+#include "operators.h"
+#include "types/Rect.hpp"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace cpparas {
+
+typedef std::chrono::steady_clock CaptureClock;
+
+/**
+ * @brief Pixel layout of captured frames.
+ */
+enum class FrameFormat {
+    /** Interleaved RGB, stored as an RGB888 image. */
+    RGB888,
+    /** The Y plane followed by the U and V planes at half the cols and rows,
+        stored as a basic image of rows * 3 / 2 rows. */
+    YUV420,
+    /** Only the Y plane, stored as a basic image. */
+    GRAY,
+};
+
+/**
+ * @brief Allocates an image with the layout of the given frame format.
+ */
+image_t* newFrameImage(uint32_t cols, uint32_t rows, FrameFormat format);
+/**
+ * @brief Points the plane images at the Y, U and V planes of a YUV420 frame image. Does not copy.
+ *        For a GRAY frame only luma is set and the chroma planes get no data.
+ */
+void viewFramePlanes(const image_t* frame, FrameFormat format, image_t& luma, image_t& chromaU, image_t& chromaV);
+
+/**
+ * @brief A frame that has been acquired from a FrameRing.
+ *        The image stays untouched by the writer until the frame is released.
+ */
+struct RingFrame {
+    int32_t slot = -1;
+    image_t* image = nullptr;
+    uint64_t sequence = 0;
+    CaptureClock::time_point timestamp;
+    /** The part of the full resolution frame this frame shows, in full resolution pixels. */
+    Rect<int32_t> fieldOfView = { { 0, 0 }, 0, 0 };
+    /** The size of the frame, which is smaller than the image when only a region was captured.
+        The frame is stored at the start of the image data with the frame cols as row length. */
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+};
+
+class FrameRing {
+public:
+    /**
+     * @brief Creates a ring of preallocated frame slots.
+     * @param slotCount The number of slots. With three slots the writer always
+     *        has a free slot while a single reader holds on to a frame.
+     * @param format The layout of the slot images. YUV420 needs even cols and rows.
+     */
+    FrameRing(uint32_t cols, uint32_t rows, std::size_t slotCount = 3, FrameFormat format = FrameFormat::RGB888);
+    ~FrameRing();
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    /**
+     * @brief Reserves the oldest slot that is not in use by a reader and is not the latest frame.
+     * @return The image to write the new frame into, or nullptr if every slot is in use.
+     * @note Only one writer is supported.
+     */
+    image_t* beginWrite();
+    /**
+     * @brief Publishes the reserved slot as the newest complete frame.
+     *        The frame shows the full field of view at the ring resolution.
+     */
+    void commitWrite(CaptureClock::time_point timestamp);
+    /**
+     * @brief Publishes the reserved slot as the newest complete frame.
+     * @param fieldOfView The part of the full resolution frame the frame shows.
+     * @param sequence The sequence number, needs to be higher than the previous one.
+     *        Lets sequence numbers continue over multiple rings.
+     * @param cols, rows The size of the frame written to the slot, at most the size of the ring.
+     */
+    void commitWrite(CaptureClock::time_point timestamp, const Rect<int32_t>& fieldOfView, uint64_t sequence, uint32_t cols, uint32_t rows);
+    /**
+     * @brief Gives the reserved slot back without publishing it, e.g. after a failed read.
+     */
+    void abortWrite();
+
+    /**
+     * @brief Acquires the newest complete frame. Does not copy and does not wait.
+     * @return false if no frame has been published yet.
+     * @note Every acquired frame needs to be given back with .release().
+     */
+    bool acquireLatest(RingFrame& frame);
+    /**
+     * @brief Releases a frame acquired with .acquireLatest() so the writer may reuse its slot.
+     */
+    void release(RingFrame& frame);
+
+    /**
+     * @brief Returns the sequence number of the newest complete frame. 0 means no frame has been published.
+     */
+    uint64_t latestSequence() const;
+
+    uint32_t getCols() const;
+    uint32_t getRows() const;
+    FrameFormat getFormat() const;
+
+private:
+    struct Slot {
+        image_t* image;
+        uint64_t sequence;
+        CaptureClock::time_point timestamp;
+        Rect<int32_t> fieldOfView;
+        uint32_t cols;
+        uint32_t rows;
+        uint32_t readers;
+    };
+
+    uint32_t cols;
+    uint32_t rows;
+    FrameFormat format;
+    std::vector<Slot> slots;
+    int32_t latestSlot;
+    int32_t writeSlot;
+    uint64_t nextSequence;
+    mutable std::mutex mtx;
+};
+
+} // namespace cpparas
+
+#endif /* FRAMERING_HPP */
@@ -2,8 +2,10 @@
 #define IMAGEAREA_HPP
 
 #include "operators.h"
+#include "util/Frame.hpp"
 #include <gdkmm/pixbuf.h>
 #include <gtkmm/drawingarea.h>
+#include <memory>
 
 namespace cpparas {
 
@@ -14,13 +16,22 @@ public:
      */
     ImageArea();
     virtual ~ImageArea();
+    /**
+     * @brief Shows an image. The image is not copied, so it must stay valid until the next image is set.
+     */
     void setImage(const image_t* image);
+    /**
+     * @brief Shows a frame and keeps a reference to it for as long as it is shown.
+     */
+    void setFrame(std::shared_ptr<const Frame> frame);
 
 protected:
     //Override default signal handler:
     bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
 
     Glib::RefPtr<Gdk::Pixbuf> m_image;
+    // The frame behind m_image, if it was set with setFrame
+    std::shared_ptr<const Frame> m_frame;
 };
 
 } // namespace cpparas
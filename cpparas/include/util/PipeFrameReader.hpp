@@ -0,0 +1,65 @@
+#ifndef PIPEFRAMEREADER_HPP
+#define PIPEFRAMEREADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpparas {
+
+/**
+ * @brief Reads fixed size frames from a pipe without blocking on a whole frame.
+ *        Partial reads are collected until a frame is complete. The pipe is read until it is
+ *        empty and only the newest complete frame is kept, so the delivered frame is never
+ *        more than about one frame old. The pipe is enlarged to hold two frames where the system allows it.
+ */
+class PipeFrameReader {
+public:
+    enum class Status {
+        /** A complete frame was copied to the destination. */
+        FRAME,
+        /** No complete frame arrived within the timeout. Bytes read so far are kept. */
+        TIMEOUT,
+        /** The writer closed the pipe. A partial frame is thrown away. */
+        CLOSED,
+        /** Reading failed. */
+        ERROR,
+    };
+
+    /**
+     * @brief Creates a reader for a pipe. The pipe is switched to non-blocking mode.
+     * @param fd The read end of the pipe. It's not closed by the reader.
+     * @param frameSize The size of a frame in bytes.
+     */
+    PipeFrameReader(int fd, std::size_t frameSize);
+
+    /**
+     * @brief Waits up to timeoutMs for the newest complete frame and copies it to dst.
+     */
+    Status readLatest(uint8_t* dst, int timeoutMs);
+    /**
+     * @brief Continues on another pipe, e.g. after the writer was restarted.
+     *        A partial frame from the old pipe is thrown away, so the next frame starts aligned.
+     */
+    void reset(int fd);
+
+    /**
+     * @brief Returns the number of complete frames that were skipped because a newer frame was available.
+     */
+    uint64_t getDroppedFrames() const;
+
+private:
+    Status readSome();
+
+    int fd;
+    std::size_t frameSize;
+    // The frame being read and the newest complete frame
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> latest;
+    std::size_t filled;
+    uint64_t droppedFrames;
+};
+
+} // namespace cpparas
+
+#endif /* PIPEFRAMEREADER_HPP */
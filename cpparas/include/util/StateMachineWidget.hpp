@@ -41,6 +41,8 @@ private:
     Gtk::Label stepLabel;
     Gtk::ScrolledWindow imageViewport;
     ImageArea imageArea;
+    // The newest cut frames, shown in the image area
+    std::shared_ptr<FrameSubscriber> previewFrames;
     bool paused;
 };
 
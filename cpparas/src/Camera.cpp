@@ -1,106 +1,255 @@
 #include "Camera.hpp"
 #include "operators.h"
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 #include <string>
-#include <thread>
-#include <unistd.h>
 
 namespace cpparas {
 
 //MAX SUPPORTED RESOLUTION FOR CONSTRUCTOR IS 1440x1440.
 //IF USING ANYTHING BELOW THAT, MAKE SURE PIXEL ASPECT RATIO IS 1:1
 
-Camera::Camera(uint32_t w, uint32_t h)
-    : threadRunning(false)
-    , is_ready(false)
+// raspivid aligns the rows of YUV420 and gray frames to 32 bytes and the planes to 16 rows
+const uint32_t CAMERA_STRIDE_ALIGNMENT = 32;
+const uint32_t CAMERA_ROWS_ALIGNMENT = 16;
+// How long to wait for data before checking whether the source was stopped
+const int CAMERA_READ_TIMEOUT_MS = 100;
+// raspivid is restarted when no frame arrived for this long
+const int CAMERA_STALL_TIMEOUT_MS = 3000;
+// Give up when raspivid quits this often without delivering a frame in between
+const uint32_t CAMERA_MAX_FAILED_RESTARTS = 3;
+
+static uint32_t alignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+Camera::Camera(uint32_t w, uint32_t h, double frameRate, FrameFormat format)
+    : FrameSource(frameRate, format)
+    , width(w)
+    , height(h)
+    , captureRegion({ { 0, 0 }, (int32_t)w, (int32_t)h })
+    , captureCols(w)
+    , captureRows(h)
+    , fpipe(NULL)
+    , failedRestarts(0)
+    , droppedBefore(0)
+    , droppedFrames(0)
+    , restarts(0)
 {
-    //compose final parameter string for raspivid
-    width = w;
-    height = h;
-    raspi_parameters = " -md 2 --width " + std::to_string(width) + " --height " + std::to_string(height) + " --metering matrix" + " --ISO 100" + " --ev -5" + " --flush" + " --framerate 15" + " --initial pause" + " --timeout 0" + " --nopreview" + " --raw -" + " --raw-format rgb";
 }
 
 Camera::~Camera()
 {
     //kill the thread if object is done with life
-    threadRunning = false;
-    if (camera_thread.joinable()) {
-        camera_thread.join();
+    stop();
+}
+
+uint64_t Camera::getDroppedFrames() const
+{
+    return droppedFrames;
+}
+
+uint32_t Camera::getRestarts() const
+{
+    return restarts;
+}
+
+bool Camera::open()
+{
+    // Every start delivers full resolution frames first.
+    setFrameSize(width, height);
+    composeCommand({ { 0, 0 }, (int32_t)width, (int32_t)height });
+    if (!startRaspivid()) {
+        return false;
+    }
+    reader.reset(new PipeFrameReader(fileno(fpipe), pipeFrameSize()));
+    pipeFrame.resize(framePadded() ? pipeFrameSize() : 0);
+    failedRestarts = 0;
+    // Keep counting over restarts of the source
+    droppedBefore = droppedFrames;
+    return true;
+}
+
+void Camera::composeCommand(const Rect<int32_t>& region)
+{
+    double frameRate = getFrameRate();
+    if (frameRate <= 0.0 || frameRate > CAMERA_MAX_FRAME_RATE) {
+        frameRate = CAMERA_MAX_FRAME_RATE;
+    }
+    // Mode 2 is the full sensor, the region keeps its full resolution.
+    std::string sensorMode = "2";
+    captureRegion = region;
+    captureCols = region.width;
+    captureRows = region.height;
+    // raspivid takes the region as fractions of the sensor and scales it to the frame size
+    std::string roi;
+    if (region.width != (int32_t)width || region.height != (int32_t)height) {
+        roi = " --roi " + std::to_string((double)region.origin.col / width) + "," + std::to_string((double)region.origin.row / height) + "," + std::to_string((double)region.width / width) + "," + std::to_string((double)region.height / height);
     }
+    std::string rawFormat = "rgb";
+    if (getFormat() == FrameFormat::YUV420) {
+        rawFormat = "yuv";
+    } else if (getFormat() == FrameFormat::GRAY) {
+        rawFormat = "gray";
+    }
+    //compose final parameter string for raspivid
+    std::string raspi_parameters = " -md " + sensorMode + " --width " + std::to_string(captureCols) + " --height " + std::to_string(captureRows) + " --metering matrix" + " --ISO 100" + " --ev -5" + " --flush" + " --framerate " + std::to_string((int)frameRate) + " --initial pause" + " --timeout 0" + " --nopreview" + " --raw -" + " --raw-format " + rawFormat + roi;
+    command = "raspivid" + raspi_parameters;
 }
 
-void Camera::Camera_thread_worker()
+bool Camera::startRaspivid()
 {
-    //init new buffer
-    captured_frame = newRGB888Image(width, height);
-    captured_frame->view = IMGVIEW_CLIP;
-    captured_frame->type = IMGTYPE_RGB888;
-    uint32_t bufferSize = width * height * 3;
-    uint32_t init_counter = 0;
     //start raspivid and pipe
-    std::string cmd = "raspivid" + raspi_parameters;
-    FILE* fpipe = popen(cmd.c_str(), "r");
+    fpipe = popen(command.c_str(), "r");
     if (fpipe == NULL) {
         std::cout << "Failed to open camera / pipe / raspivid" << std::endl;
-    } else {
-        while (threadRunning) {
-            // read pipe data into buffer. One whole frame per read
-            // if all bytes are in, convert raw data to image_t
-            size_t readBytes = fread((uint8_t*)captured_frame->data, 1, bufferSize, fpipe);
-            if (readBytes != bufferSize) {
-                threadRunning = false;
-            }
-            if(init_counter > 3){
-                // signal main thread that a new frame is ready, unlock mutex
-                std::unique_lock<std::mutex> locker(mtx);
-                is_ready = true;
-                cond_var.notify_one();
-            } else {
-                init_counter++;
+        return false;
+    }
+    return true;
+}
+
+bool Camera::restartRaspivid()
+{
+    if (failedRestarts >= CAMERA_MAX_FAILED_RESTARTS) {
+        std::cout << "raspivid keeps quitting, giving up" << std::endl;
+        return false;
+    }
+    failedRestarts++;
+    restarts++;
+    std::cout << "Restarting raspivid" << std::endl;
+    pclose(fpipe);
+    if (!startRaspivid()) {
+        return false;
+    }
+    reader->reset(fileno(fpipe));
+    return true;
+}
+
+bool Camera::readFrame(image_t* dst)
+{
+    uint8_t* target = framePadded() ? pipeFrame.data() : (uint8_t*)dst->data;
+    int waitedMs = 0;
+    while (isRunning()) {
+        PipeFrameReader::Status status = reader->readLatest(target, CAMERA_READ_TIMEOUT_MS);
+        droppedFrames = droppedBefore + reader->getDroppedFrames();
+        if (status == PipeFrameReader::Status::FRAME) {
+            failedRestarts = 0;
+            break;
+        }
+        if (status == PipeFrameReader::Status::TIMEOUT) {
+            waitedMs += CAMERA_READ_TIMEOUT_MS;
+            if (waitedMs < CAMERA_STALL_TIMEOUT_MS) {
+                continue;
             }
         }
-        // close pipe, also kill raspivid in the process by starving mmal, sorry raspivid :(
-        pclose(fpipe);
+        // raspivid quit or stalled, a new instance starts at a frame boundary again
+        if (!restartRaspivid()) {
+            return false;
+        }
+        waitedMs = 0;
     }
+    if (!isRunning()) {
+        return false;
+    }
+    if (framePadded()) {
+        uint32_t stride = alignUp(captureCols, CAMERA_STRIDE_ALIGNMENT);
+        uint32_t paddedRows = alignUp(captureRows, CAMERA_ROWS_ALIGNMENT);
+        const uint8_t* src = pipeFrame.data();
+        uint8_t* plane = (uint8_t*)dst->data;
+        copyPlane(src, plane, captureCols, captureRows, stride, paddedRows);
+        if (getFormat() == FrameFormat::YUV420) {
+            copyPlane(src, plane, captureCols / 2, captureRows / 2, stride / 2, paddedRows / 2);
+            copyPlane(src, plane, captureCols / 2, captureRows / 2, stride / 2, paddedRows / 2);
+        }
+    }
+    return true;
 }
 
-void Camera::Camera_thread_worker_start()
+std::size_t Camera::pipeFrameSize() const
 {
-    //start thread and wait till its's completelly up and running
-    threadRunning = true;
-    camera_thread = std::thread(&Camera::Camera_thread_worker, this);
-    std::unique_lock<std::mutex> locker(mtx);
-    while (!is_ready) {
-        cond_var.wait(locker);
+    if (getFormat() == FrameFormat::RGB888) {
+        return (std::size_t)captureCols * captureRows * 3;
     }
+    std::size_t lumaSize = (std::size_t)alignUp(captureCols, CAMERA_STRIDE_ALIGNMENT) * alignUp(captureRows, CAMERA_ROWS_ALIGNMENT);
+    return getFormat() == FrameFormat::YUV420 ? lumaSize * 3 / 2 : lumaSize;
 }
 
-void Camera::Camera_thread_worker_stop()
+bool Camera::framePadded() const
 {
-    threadRunning = false;
-    if (camera_thread.joinable()) {
-        camera_thread.join();
+    if (getFormat() == FrameFormat::RGB888) {
+        return false;
     }
+    return alignUp(captureCols, CAMERA_STRIDE_ALIGNMENT) != captureCols || alignUp(captureRows, CAMERA_ROWS_ALIGNMENT) != captureRows;
 }
 
-image_t* Camera::Camera_get_frame()
+// Copies a padded plane and moves both pointers to the next plane
+void Camera::copyPlane(const uint8_t*& src, uint8_t*& dst, uint32_t cols, uint32_t rows, uint32_t stride, uint32_t paddedRows)
 {
-    //chek if camera is running
-    if (threadRunning) {
-        //wait for new frame to be available
-        is_ready = false;
-        std::unique_lock<std::mutex> locker(mtx);
-        while (!is_ready) {
-            cond_var.wait(locker);
-        }
+    for (uint32_t row = 0; row < rows; row++) {
+        std::copy(src + row * stride, src + row * stride + cols, dst + row * cols);
+    }
+    src += stride * paddedRows;
+    dst += cols * rows;
+}
+
+void Camera::close()
+{
+    // close pipe, also kill raspivid in the process by starving mmal, sorry raspivid :(
+    reader.reset();
+    if (fpipe != NULL) {
+        pclose(fpipe);
+        fpipe = NULL;
+    }
+}
+
+bool Camera::pacedByDevice() const
+{
+    // raspivid delivers frames at the rate it was started with
+    return true;
+}
+
+uint32_t Camera::warmupFrames() const
+{
+    // skip the first frames while the camera is still adjusting
+    return 4;
+}
+
+FrameFormat Camera::nativeFormat() const
+{
+    // raspivid writes the requested format itself
+    return getFormat();
+}
+
+uint64_t Camera::droppedByDevice() const
+{
+    return droppedFrames;
+}
+
+bool Camera::configureStream(StreamMode mode, const Rect<int32_t>& region, uint32_t cols, uint32_t rows, Rect<int32_t>& nativeRegion)
+{
+    (void)mode;
+    (void)cols;
+    (void)rows;
+    // The preview is scaled down from the running stream, only another region needs a new one.
+    if (region.origin.col == captureRegion.origin.col && region.origin.row == captureRegion.origin.row && region.width == captureRegion.width && region.height == captureRegion.height) {
+        nativeRegion = captureRegion;
+        return true;
     }
-    //check camera again, in case camera crashed while getting a new frame
-    if (threadRunning) {
-        return captured_frame;
-    } else {
-        return nullptr;
+    // raspivid can't change its region while running, so it is started again.
+    pclose(fpipe);
+    fpipe = NULL;
+    droppedBefore = droppedFrames;
+    composeCommand(region);
+    if (!startRaspivid()) {
+        return false;
     }
+    reader.reset(new PipeFrameReader(fileno(fpipe), pipeFrameSize()));
+    pipeFrame.resize(framePadded() ? pipeFrameSize() : 0);
+    failedRestarts = 0;
+    nativeRegion = captureRegion;
+    return true;
 }
 
 } // namespace cpparas
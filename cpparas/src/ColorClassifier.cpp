@@ -3,32 +3,35 @@
 namespace cpparas {
 
 namespace ColorClassifier {
-    std::vector<hsv_pixel_t> setColors(const image_t* image, const CoordinateMatrix& coordinateMatrix, Color expectedColor, image_t* debugImage)
+    std::vector<hsv_pixel_t> setColors(const StudFrame& studFrame, Color expectedColor, image_t* debugImage)
     {
         std::vector<hsv_pixel_t> range;
-        int halfDistance = (coordinateMatrix.getMatrix()[0][0][1].col - coordinateMatrix.getMatrix()[0][0][0].col) / 2;
+        const image_t* image = studFrame.getHSVImage();
+        const int32_t studPixels = studFrame.getStudPixels();
         hsv_pixel_t pixelHSV;
         hsv_pixel_t max = { 0, 0, 0 };
         hsv_pixel_t min = { 360, 100, 100 };
         Point<int32_t> CoordinatesTop = COLOR_COORDINATES_TOP.at(expectedColor);
         Point<int32_t> CoordinatesBottom = COLOR_COORDINATES_BOTTOM.at(expectedColor);
-        Point<int32_t> pixelCoordinatesTop = coordinateMatrix.getMatrix()[0][CoordinatesTop.row][CoordinatesTop.col];
-        Point<int32_t> pixelCoordinatesBottom = coordinateMatrix.getMatrix()[0][CoordinatesBottom.row][CoordinatesBottom.col];
+        Point<int32_t> blockTop = studFrame.blockPosition(0, { (uint32_t)CoordinatesTop.col, (uint32_t)CoordinatesTop.row });
+        Point<int32_t> blockBottom = studFrame.blockPosition(0, { (uint32_t)CoordinatesBottom.col, (uint32_t)CoordinatesBottom.row });
 
         if (debugImage) {
-            int32_t rectTopLeft[2] = { pixelCoordinatesTop.col - halfDistance, pixelCoordinatesTop.row - halfDistance };
-            int32_t rectSize[2] = { halfDistance * 2, halfDistance * 2 };
+            int32_t rectTopLeft[2] = { blockTop.col, blockTop.row };
+            int32_t rectSize[2] = { studPixels, studPixels };
             pixel_t rectColor;
             rectColor.rgb888_pixel = COLOR_DISPLAY_VALUES.at(expectedColor);
             drawRect(debugImage, rectTopLeft, rectSize, rectColor, SHAPE_INNER, 0);
-            rectTopLeft[0] = pixelCoordinatesBottom.col - halfDistance;
-            rectTopLeft[1] = pixelCoordinatesBottom.row - halfDistance;
+            rectTopLeft[0] = blockBottom.col;
+            rectTopLeft[1] = blockBottom.row;
             drawRect(debugImage, rectTopLeft, rectSize, rectColor, SHAPE_INNER, 0);
         }
 
-        for (int r = -halfDistance / 2; r < halfDistance * 2; r++) {
-            for (int c = -halfDistance / 2; c < halfDistance * 2; c++) {
-                pixelHSV = getHSVPixel(image, c + pixelCoordinatesTop.col, r + pixelCoordinatesTop.row);
+        // The reference reaches from a quarter stud before the reference stud to halfway the next stud,
+        // which are the pixels from a quarter into its block to halfway the block after it.
+        for (int r = studPixels / 4; r < studPixels * 3 / 2; r++) {
+            for (int c = studPixels / 4; c < studPixels * 3 / 2; c++) {
+                pixelHSV = getHSVPixel(image, c + blockTop.col, r + blockTop.row);
                 max.h = pixelHSV.h > max.h ? pixelHSV.h : max.h;
                 max.s = pixelHSV.s > max.s ? pixelHSV.s : max.s;
                 max.v = pixelHSV.v > max.v ? pixelHSV.v : max.v;
@@ -36,7 +39,7 @@ namespace ColorClassifier {
                 min.s = pixelHSV.s < min.s ? pixelHSV.s : min.s;
                 min.v = pixelHSV.v < min.v ? pixelHSV.v : min.v;
 
-                pixelHSV = getHSVPixel(image, c + pixelCoordinatesBottom.col, r + pixelCoordinatesBottom.row);
+                pixelHSV = getHSVPixel(image, c + blockBottom.col, r + blockBottom.row);
                 max.h = pixelHSV.h > max.h ? pixelHSV.h : max.h;
                 max.s = pixelHSV.s > max.s ? pixelHSV.s : max.s;
                 max.v = pixelHSV.v > max.v ? pixelHSV.v : max.v;
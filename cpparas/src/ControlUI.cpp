@@ -1,4 +1,5 @@
 #include "ControlUI.hpp"
+#include "RawStreamSource.hpp"
 #include "debug/DebugUI.hpp"
 #include "operators.h"
 #include "util/ImageArea.hpp"
@@ -20,6 +21,7 @@ ControlUI::ControlUI()
     , selectImageButton("Select image")
     , useLastImageButton("Use last")
     , useCameraButton("Use camera")
+    , selectFrameFolderButton("Select frame folder")
     , separator1()
     , selectSequenceFileButton("Select sequence file")
     , useLastSequenceFileButton("Use last")
@@ -44,6 +46,8 @@ ControlUI::ControlUI()
         &ControlUI::on_use_last_image_button_clicked));
     useCameraButton.signal_clicked().connect(sigc::mem_fun(*this,
         &ControlUI::on_use_camera_button_clicked));
+    selectFrameFolderButton.signal_clicked().connect(sigc::mem_fun(*this,
+        &ControlUI::on_select_frame_folder_button_clicked));
     selectSequenceFileButton.signal_clicked().connect(sigc::mem_fun(*this,
         &ControlUI::on_select_sequence_file_button_clicked));
     useLastSequenceFileButton.signal_clicked().connect(sigc::mem_fun(*this,
@@ -56,19 +60,21 @@ ControlUI::ControlUI()
     widgetContainer.attach(selectImageButton, 1, 1, 1, 1);
     widgetContainer.attach(useLastImageButton, 2, 1, 1, 1);
     widgetContainer.attach(useCameraButton, 3, 1, 1, 1);
-    widgetContainer.attach(separator1, 4, 1, 1, 1);
-    widgetContainer.attach(selectSequenceFileButton, 5, 1, 1, 1);
-    widgetContainer.attach(useLastSequenceFileButton, 6, 1, 1, 1);
-    widgetContainer.attach(separator2, 7, 1, 1, 1);
-    widgetContainer.attach(openProjectorUIButton, 8, 1, 1, 1);
-    widgetContainer.attach(openDebugUIButton, 9, 1, 1, 1);
-    widgetContainer.attach(separator3, 10, 1, 1, 1);
-    widgetContainer.attach(stateMachineWidget(), 1, 2, 10, 1);
+    widgetContainer.attach(selectFrameFolderButton, 4, 1, 1, 1);
+    widgetContainer.attach(separator1, 5, 1, 1, 1);
+    widgetContainer.attach(selectSequenceFileButton, 6, 1, 1, 1);
+    widgetContainer.attach(useLastSequenceFileButton, 7, 1, 1, 1);
+    widgetContainer.attach(separator2, 8, 1, 1, 1);
+    widgetContainer.attach(openProjectorUIButton, 9, 1, 1, 1);
+    widgetContainer.attach(openDebugUIButton, 10, 1, 1, 1);
+    widgetContainer.attach(separator3, 11, 1, 1, 1);
+    widgetContainer.attach(stateMachineWidget(), 1, 2, 11, 1);
     add(widgetContainer);
 
     selectImageButton.show();
     useLastImageButton.show();
     useCameraButton.show();
+    selectFrameFolderButton.show();
     separator1.show();
     selectSequenceFileButton.show();
     useLastSequenceFileButton.show();
@@ -101,6 +107,12 @@ void ControlUI::on_select_image_button_clicked()
     filter_text->set_name("Image files");
     filter_text->add_pixbuf_formats();
     dialog.add_filter(filter_text);
+    auto filter_raw = Gtk::FileFilter::create();
+    filter_raw->set_name("Raw RGB888, YUV420 or gray stream");
+    filter_raw->add_pattern("*.rgb");
+    filter_raw->add_pattern("*.yuv");
+    filter_raw->add_pattern("*.gray");
+    dialog.add_filter(filter_raw);
 
     //Show the dialog and wait for a user response:
     int result = dialog.run();
@@ -133,6 +145,33 @@ void ControlUI::on_use_camera_button_clicked()
     imageLoader->Set_source_type(SourceType::CAMERA);
 }
 
+void ControlUI::on_select_frame_folder_button_clicked()
+{
+    Gtk::FileChooserDialog dialog("Please choose a folder of frames",
+        Gtk::FILE_CHOOSER_ACTION_SELECT_FOLDER);
+    dialog.set_transient_for(*this);
+
+    //Add response buttons the the dialog:
+    dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+    dialog.add_button("_Select", Gtk::RESPONSE_OK);
+
+    //Show the dialog and wait for a user response:
+    int result = dialog.run();
+
+    //Handle the response:
+    switch (result) {
+    case (Gtk::RESPONSE_OK): {
+        imageLoader->Set_source_type(SourceType::DIRECTORY);
+        imageLoader->Set_source_path(dialog.get_filename());
+        break;
+    }
+    default: {
+        // User cancelled.
+        break;
+    }
+    }
+}
+
 void ControlUI::on_select_sequence_file_button_clicked()
 {
     Gtk::FileChooserDialog dialog("Please choose a file",
@@ -189,8 +228,13 @@ void ControlUI::on_open_debug_ui_button_clicked()
 
 void ControlUI::set_input_image(const std::string& filePath)
 {
+    FrameFormat streamFormat;
     if (filePath == "") {
         imageLoader->Set_source_type(SourceType::CAMERA);
+    } else if (RawStreamSource::formatOfFile(filePath, streamFormat)) {
+        // A stream of raw frames as written by raspivid, in the format of its extension
+        imageLoader->Set_source_type(SourceType::RAW_STREAM);
+        imageLoader->Set_source_path(filePath);
     } else {
         imageLoader->Set_source_type(SourceType::IMAGE);
         imageLoader->Set_source_image(filePath);
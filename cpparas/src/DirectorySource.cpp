@@ -0,0 +1,125 @@
+#include "DirectorySource.hpp"
+#include "debug/Debug.hpp"
+#include "util/ImageUtils.hpp"
+#include <algorithm>
+#include <dirent.h>
+
+namespace cpparas {
+
+static bool hasFrameExtension(const std::string& fileName)
+{
+    std::size_t dot = fileName.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = fileName.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "png" || extension == "jpg" || extension == "jpeg";
+}
+
+static image_t* loadFrame(const std::string& path)
+{
+    try {
+        return ImageUtils::loadImageFromFile(path);
+    } catch (...) {
+        // Gdk reports unreadable files with its own exception types.
+        Debug::println(std::string("Failed to load frame ") + path);
+        return nullptr;
+    }
+}
+
+DirectorySource::DirectorySource(const std::string& directoryPath_, double frameRate, bool loop_, bool preload_)
+    : FrameSource(frameRate)
+    , directoryPath(directoryPath_)
+    , loop(loop_)
+    , preload(preload_)
+    , nextFrame(0)
+{
+}
+
+DirectorySource::~DirectorySource()
+{
+    stop();
+}
+
+std::vector<std::string> DirectorySource::listFrames(const std::string& directoryPath)
+{
+    std::vector<std::string> paths;
+    DIR* dir = opendir(directoryPath.c_str());
+    if (dir == NULL) {
+        return paths;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string fileName(entry->d_name);
+        if (hasFrameExtension(fileName)) {
+            paths.push_back(directoryPath + "/" + fileName);
+        }
+    }
+    closedir(dir);
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool DirectorySource::open()
+{
+    framePaths = listFrames(directoryPath);
+    if (framePaths.empty()) {
+        Debug::println(std::string("No PNG or JPEG frames found in ") + directoryPath);
+        return false;
+    }
+    image_t* firstFrame = loadFrame(framePaths[0]);
+    if (firstFrame == nullptr) {
+        return false;
+    }
+    setFrameSize(firstFrame->cols, firstFrame->rows);
+    if (preload) {
+        preloadedFrames.push_back(firstFrame);
+        for (std::size_t i = 1; i < framePaths.size(); i++) {
+            image_t* frame = loadFrame(framePaths[i]);
+            if (frame == nullptr) {
+                close();
+                return false;
+            }
+            preloadedFrames.push_back(frame);
+        }
+    } else {
+        deleteImage(firstFrame);
+    }
+    nextFrame = 0;
+    return true;
+}
+
+bool DirectorySource::readFrame(image_t* dst)
+{
+    if (nextFrame >= framePaths.size()) {
+        if (!loop) {
+            return false;
+        }
+        nextFrame = 0;
+    }
+    image_t* frame = preload ? preloadedFrames[nextFrame] : loadFrame(framePaths[nextFrame]);
+    if (frame == nullptr) {
+        return false;
+    }
+    if (frame->cols == dst->cols && frame->rows == dst->rows) {
+        copy(frame, dst);
+    } else {
+        scaleImage(frame, dst);
+    }
+    if (!preload) {
+        deleteImage(frame);
+    }
+    nextFrame++;
+    return true;
+}
+
+void DirectorySource::close()
+{
+    for (image_t* frame : preloadedFrames) {
+        deleteImage(frame);
+    }
+    preloadedFrames.clear();
+}
+
+} // namespace cpparas
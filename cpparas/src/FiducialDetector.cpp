@@ -0,0 +1,397 @@
+#include "FiducialDetector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace cpparas {
+
+// Shorter side of the gray image the markers are searched in, the frame is downscaled by whole factors to about this size.
+static const double FIDUCIAL_GRAY_SIZE = 720.0;
+// Half the size of the adaptive threshold window, as a fraction of the shorter side of the gray image
+static const double FIDUCIAL_THRESHOLD_RADIUS = 0.02;
+// A pixel is dark when it lies this far below the mean of its window.
+static const int32_t FIDUCIAL_THRESHOLD_OFFSET = 7;
+// The smallest and largest side of a marker, as a fraction of the shorter side of the frame
+static const double FIDUCIAL_MIN_SIZE = 0.03;
+static const double FIDUCIAL_MAX_SIZE = 0.3;
+// The longest side of a marker may be this many times its shortest side, as seen at an angle.
+static const double FIDUCIAL_MAX_SIDE_RATIO = 2.0;
+// The black border alone covers 20 of the 36 cells.
+static const double FIDUCIAL_MIN_FILL = 0.4;
+// Pixels of the shape may lie this far outside of the quad, as a fraction of its mean side.
+static const double FIDUCIAL_QUAD_TOLERANCE = 0.04;
+// Difference between the brightest and the darkest cell of a marker
+static const int32_t FIDUCIAL_MIN_CONTRAST = 40;
+// A code with more wrong bits is no marker. Half of the distance between the codes, minus a margin.
+static const uint32_t FIDUCIAL_MAX_BIT_ERRORS = 2;
+// Cells along a side of a marker, the border included
+static const int32_t FIDUCIAL_CELLS = 6;
+
+static const rgb888_pixel_t FIDUCIAL_BLACK = { 0, 0, 0 };
+static const rgb888_pixel_t FIDUCIAL_WHITE = { 255, 255, 255 };
+
+// A horizontal run of dark pixels, the shapes are the 8-connected runs.
+struct Run {
+    int32_t row;
+    int32_t first;
+    int32_t last;
+};
+
+// A shape of dark pixels that may be a marker
+struct Shape {
+    int64_t area = 0;
+    int64_t sumCol = 0;
+    int64_t sumRow = 0;
+    int32_t left = 0;
+    int32_t top = 0;
+    int32_t right = -1;
+    int32_t bottom = -1;
+    // The ends of the runs, which hold the outline of the shape
+    std::vector<Point<int32_t>> ends;
+};
+
+static uint32_t findRoot(std::vector<uint32_t>& parents, uint32_t run)
+{
+    while (parents[run] != run) {
+        parents[run] = parents[parents[run]];
+        run = parents[run];
+    }
+    return run;
+}
+
+static int32_t trailingZeros(binary_word_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int32_t zeros = 0;
+    for (; (word & 1) == 0; word >>= 1) {
+        zeros++;
+    }
+    return zeros;
+#endif
+}
+
+// Returns the first column from col on that is set, or cleared when set is false, or cols when there is none.
+static int32_t nextColumn(const binary_word_t* line, int32_t col, int32_t cols, bool set)
+{
+    while (col < cols) {
+        const binary_word_t word = set ? line[col / BINARY_WORD_BITS] : ~line[col / BINARY_WORD_BITS];
+        const binary_word_t rest = word >> (col % BINARY_WORD_BITS);
+        if (rest != 0) {
+            return std::min(col + trailingZeros(rest), cols);
+        }
+        col = (col / BINARY_WORD_BITS + 1) * BINARY_WORD_BITS;
+    }
+    return cols;
+}
+
+// Finds the runs of set pixels in every row of the packed image, and joins the runs that touch into shapes.
+static std::vector<Run> findRuns(const image_t* binary, std::vector<uint32_t>& parents)
+{
+    std::vector<Run> runs;
+    const int32_t words = BINARY_WORDS_PER_ROW(binary->cols);
+    std::size_t previousFirst = 0;
+    for (int32_t row = 0; row < binary->rows; row++) {
+        const binary_word_t* line = (const binary_word_t*)binary->data + row * words;
+        const std::size_t currentFirst = runs.size();
+        for (int32_t col = nextColumn(line, 0, binary->cols, true); col < binary->cols; col = nextColumn(line, col, binary->cols, true)) {
+            Run run = { row, col, nextColumn(line, col, binary->cols, false) - 1 };
+            col = run.last + 1;
+            const uint32_t index = runs.size();
+            runs.push_back(run);
+            parents.push_back(index);
+            // Runs of the previous row that touch this one, diagonally included
+            for (std::size_t above = previousFirst; above < currentFirst; above++) {
+                if (runs[above].last + 1 < run.first) {
+                    previousFirst = above + 1;
+                    continue;
+                }
+                if (runs[above].first > run.last + 1) {
+                    break;
+                }
+                uint32_t a = findRoot(parents, above);
+                uint32_t b = findRoot(parents, index);
+                parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+        previousFirst = currentFirst;
+    }
+    return runs;
+}
+
+// Returns the shapes with about the size of a marker, not touching the border of the image.
+static std::vector<Shape> findShapes(const image_t* binary, int32_t minSize, int32_t maxSize)
+{
+    std::vector<uint32_t> parents;
+    std::vector<Run> runs = findRuns(binary, parents);
+
+    std::vector<Shape> bounds(runs.size());
+    for (uint32_t i = 0; i < runs.size(); i++) {
+        const Run& run = runs[i];
+        Shape& shape = bounds[findRoot(parents, i)];
+        if (shape.area == 0) {
+            shape.left = run.first;
+            shape.top = run.row;
+        }
+        const int64_t length = run.last - run.first + 1;
+        shape.area += length;
+        shape.sumCol += (int64_t)(run.first + run.last) * length / 2;
+        shape.sumRow += run.row * length;
+        shape.left = std::min(shape.left, run.first);
+        shape.right = std::max(shape.right, run.last);
+        shape.bottom = run.row;
+    }
+
+    std::vector<int32_t> indices(runs.size(), -1);
+    std::vector<Shape> shapes;
+    for (uint32_t i = 0; i < runs.size(); i++) {
+        const Shape& shape = bounds[i];
+        const int32_t width = shape.right - shape.left + 1;
+        const int32_t height = shape.bottom - shape.top + 1;
+        if (shape.area == 0 || width < minSize || height < minSize || width > maxSize || height > maxSize
+            || shape.left == 0 || shape.top == 0 || shape.right == binary->cols - 1 || shape.bottom == binary->rows - 1) {
+            continue;
+        }
+        indices[i] = shapes.size();
+        shapes.push_back(shape);
+    }
+    for (uint32_t i = 0; i < runs.size(); i++) {
+        const int32_t index = indices[findRoot(parents, i)];
+        if (index >= 0) {
+            shapes[index].ends.push_back({ runs[i].first, runs[i].row });
+            shapes[index].ends.push_back({ runs[i].last, runs[i].row });
+        }
+    }
+    return shapes;
+}
+
+static double cross(const Point<double>& origin, const Point<double>& a, const Point<double>& b)
+{
+    return (a.col - origin.col) * (b.row - origin.row) - (a.row - origin.row) * (b.col - origin.col);
+}
+
+// Fits a quad to the outline of the shape, clockwise in the image. The corners are the outline pixels that lie
+// furthest out: the one furthest from the centroid, the one furthest from that, and the ones furthest on both
+// sides of the diagonal between them.
+static bool fitQuad(const Shape& shape, Point<double> quad[4])
+{
+    const Point<double> centroid = { (double)shape.sumCol / shape.area, (double)shape.sumRow / shape.area };
+    auto furthest = [&shape](auto distance) {
+        Point<double> best = { 0.0, 0.0 };
+        double bestDistance = -INFINITY;
+        for (const Point<int32_t>& end : shape.ends) {
+            Point<double> point = { (double)end.col, (double)end.row };
+            double d = distance(point);
+            if (d > bestDistance) {
+                bestDistance = d;
+                best = point;
+            }
+        }
+        return best;
+    };
+    auto squared = [](const Point<double>& a, const Point<double>& b) {
+        return (a.col - b.col) * (a.col - b.col) + (a.row - b.row) * (a.row - b.row);
+    };
+    quad[0] = furthest([&](const Point<double>& p) { return squared(p, centroid); });
+    quad[2] = furthest([&](const Point<double>& p) { return squared(p, quad[0]); });
+    quad[1] = furthest([&](const Point<double>& p) { return cross(quad[0], quad[2], p); });
+    quad[3] = furthest([&](const Point<double>& p) { return -cross(quad[0], quad[2], p); });
+    if (cross(quad[0], quad[2], quad[1]) <= 0.0 || cross(quad[0], quad[2], quad[3]) >= 0.0) {
+        return false;
+    }
+    // With the rows pointing down, the cross product of clockwise corners is positive.
+    if (cross(quad[0], quad[1], quad[2]) < 0.0) {
+        std::swap(quad[1], quad[3]);
+    }
+
+    double shortest = INFINITY;
+    double longest = 0.0;
+    double area = 0.0;
+    for (int32_t i = 0; i < 4; i++) {
+        const Point<double>& a = quad[i];
+        const Point<double>& b = quad[(i + 1) % 4];
+        double side = std::sqrt(squared(a, b));
+        shortest = std::min(shortest, side);
+        longest = std::max(longest, side);
+        area += a.col * b.row - b.col * a.row;
+    }
+    area = std::abs(area) / 2;
+    if (longest > FIDUCIAL_MAX_SIDE_RATIO * shortest || shape.area < FIDUCIAL_MIN_FILL * area) {
+        return false;
+    }
+    // A square outline lies within the quad, a round or ragged one does not.
+    const double tolerance = std::max(FIDUCIAL_QUAD_TOLERANCE * (shortest + longest) / 2, 1.5);
+    for (int32_t i = 0; i < 4; i++) {
+        const Point<double>& a = quad[i];
+        const Point<double>& b = quad[(i + 1) % 4];
+        const double length = std::sqrt(squared(a, b));
+        for (const Point<int32_t>& end : shape.ends) {
+            if (cross(a, b, { (double)end.col, (double)end.row }) / length < -tolerance) {
+                return false;
+            }
+        }
+    }
+    // From the centers of the outer pixels to their outer corners, away from the centroid
+    for (int32_t i = 0; i < 4; i++) {
+        quad[i].col += quad[i].col < centroid.col ? -0.5 : 0.5;
+        quad[i].row += quad[i].row < centroid.row ? -0.5 : 0.5;
+    }
+    return true;
+}
+
+// Reads the cells of the quad with the given corner as the left-top corner of the code.
+// Returns the code, or -1 when the border is not black.
+static int32_t readCode(const image_t* gray, const Point<double> quad[4], int32_t start)
+{
+    const Point<double>& a = quad[start];
+    const Point<double>& b = quad[(start + 1) % 4];
+    const Point<double>& c = quad[(start + 2) % 4];
+    const Point<double>& d = quad[(start + 3) % 4];
+    int32_t cells[FIDUCIAL_CELLS][FIDUCIAL_CELLS];
+    int32_t darkest = 255;
+    int32_t brightest = 0;
+    for (int32_t row = 0; row < FIDUCIAL_CELLS; row++) {
+        for (int32_t col = 0; col < FIDUCIAL_CELLS; col++) {
+            // The center of the cell, interpolated between the corners
+            const double u = (col + 0.5) / FIDUCIAL_CELLS;
+            const double v = (row + 0.5) / FIDUCIAL_CELLS;
+            const double x = (1 - u) * (1 - v) * a.col + u * (1 - v) * b.col + u * v * c.col + (1 - u) * v * d.col;
+            const double y = (1 - u) * (1 - v) * a.row + u * (1 - v) * b.row + u * v * c.row + (1 - u) * v * d.row;
+            const int32_t centerCol = std::min(std::max((int32_t)std::lround(x), 1), gray->cols - 2);
+            const int32_t centerRow = std::min(std::max((int32_t)std::lround(y), 1), gray->rows - 2);
+            int32_t sum = 0;
+            for (int32_t r = -1; r <= 1; r++) {
+                for (int32_t q = -1; q <= 1; q++) {
+                    sum += getBasicPixel(gray, centerCol + q, centerRow + r);
+                }
+            }
+            cells[row][col] = sum / 9;
+            darkest = std::min(darkest, cells[row][col]);
+            brightest = std::max(brightest, cells[row][col]);
+        }
+    }
+    if (brightest - darkest < FIDUCIAL_MIN_CONTRAST) {
+        return -1;
+    }
+    const int32_t level = (darkest + brightest) / 2;
+    int32_t code = 0;
+    for (int32_t row = 0; row < FIDUCIAL_CELLS; row++) {
+        for (int32_t col = 0; col < FIDUCIAL_CELLS; col++) {
+            const bool white = cells[row][col] > level;
+            if (row == 0 || col == 0 || row == FIDUCIAL_CELLS - 1 || col == FIDUCIAL_CELLS - 1) {
+                if (white) {
+                    return -1;
+                }
+            } else {
+                code = (code << 1) | (white ? 1 : 0);
+            }
+        }
+    }
+    return code;
+}
+
+static uint32_t bitCount(uint32_t bits)
+{
+    uint32_t count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+// Finds which corner of the quad is the left-top corner of which code.
+static bool decode(const image_t* gray, const Point<double> quad[4], FiducialDetector::Marker& marker)
+{
+    bool found = false;
+    marker.bitErrors = FIDUCIAL_MAX_BIT_ERRORS + 1;
+    for (int32_t start = 0; start < 4; start++) {
+        const int32_t code = readCode(gray, quad, start);
+        if (code < 0) {
+            // The border looks the same from every corner.
+            return false;
+        }
+        for (uint32_t id = 0; id < FiducialDetector::FIDUCIAL_MARKER_COUNT; id++) {
+            const uint32_t errors = bitCount((uint32_t)code ^ FiducialDetector::FIDUCIAL_CODES[id]);
+            if (errors < marker.bitErrors) {
+                found = true;
+                marker.id = id;
+                marker.bitErrors = errors;
+                for (int32_t i = 0; i < 4; i++) {
+                    marker.corners[i] = quad[(start + i) % 4];
+                }
+            }
+        }
+    }
+    return found;
+}
+
+FiducialDetector::Detection FiducialDetector::detect(const image_t* img)
+{
+    const int32_t shorter = std::min(img->cols, img->rows);
+    const uint8_t factor = (uint8_t)std::min(std::max(std::round(shorter / FIDUCIAL_GRAY_SIZE), 1.0), 255.0);
+    image_t* gray = newBasicImage(img->cols / factor, img->rows / factor);
+    downscale(img, gray, factor);
+    const int32_t grayShorter = std::min(gray->cols, gray->rows);
+
+    image_t* binary = newBinaryImage(gray->cols, gray->rows);
+    const uint8_t radius = (uint8_t)std::min(std::max(std::lround(FIDUCIAL_THRESHOLD_RADIUS * grayShorter), 1L), 255L);
+    thresholdAdaptive(gray, binary, radius, FIDUCIAL_THRESHOLD_OFFSET, DARK);
+    std::vector<Shape> shapes = findShapes(binary, (int32_t)(FIDUCIAL_MIN_SIZE * grayShorter), (int32_t)(FIDUCIAL_MAX_SIZE * grayShorter));
+    deleteImage(binary);
+
+    // The marker with the fewest wrong bits wins when an id is found more than once.
+    Detection detection;
+    std::vector<int32_t> found(FIDUCIAL_MARKER_COUNT, -1);
+    for (const Shape& shape : shapes) {
+        Point<double> quad[4];
+        Marker marker;
+        if (!fitQuad(shape, quad) || !decode(gray, quad, marker)) {
+            continue;
+        }
+        // The center of a gray pixel lies in the middle of the block of frame pixels it was made of.
+        for (Point<double>& corner : marker.corners) {
+            corner = { corner.col * factor + (factor - 1) / 2.0, corner.row * factor + (factor - 1) / 2.0 };
+        }
+        if (found[marker.id] < 0) {
+            found[marker.id] = detection.markers.size();
+            detection.markers.push_back(marker);
+        } else if (marker.bitErrors < detection.markers[found[marker.id]].bitErrors) {
+            detection.markers[found[marker.id]] = marker;
+        }
+    }
+    deleteImage(gray);
+
+    if (std::find(found.begin(), found.end(), -1) == found.end()) {
+        for (uint32_t id = 0; id < FIDUCIAL_MARKER_COUNT; id++) {
+            const Point<double>& corner = detection.markers[found[id]].corners[id];
+            detection.points.push_back({ (int32_t)std::lround(corner.col), (int32_t)std::lround(corner.row) });
+        }
+    }
+    return detection;
+}
+
+std::vector<Point<int32_t>> FiducialDetector::detectMarkers(const image_t* img)
+{
+    return detect(img).points;
+}
+
+void FiducialDetector::drawMarker(image_t* img, uint32_t id, const Point<int32_t>& topLeft, int32_t size)
+{
+    const uint16_t code = FIDUCIAL_CODES[id % FIDUCIAL_MARKER_COUNT];
+    int32_t bit = 15;
+    for (int32_t row = 0; row < FIDUCIAL_CELLS; row++) {
+        for (int32_t col = 0; col < FIDUCIAL_CELLS; col++) {
+            bool border = row == 0 || col == 0 || row == FIDUCIAL_CELLS - 1 || col == FIDUCIAL_CELLS - 1;
+            bool white = !border && ((code >> bit--) & 1);
+            // Cells end where the next one starts, so the marker is exactly size pixels wide.
+            int32_t cellTopLeft[2] = { topLeft.col + col * size / FIDUCIAL_CELLS, topLeft.row + row * size / FIDUCIAL_CELLS };
+            int32_t cellSize[2] = { topLeft.col + (col + 1) * size / FIDUCIAL_CELLS - cellTopLeft[0], topLeft.row + (row + 1) * size / FIDUCIAL_CELLS - cellTopLeft[1] };
+            pixel_t color;
+            color.rgb888_pixel = white ? FIDUCIAL_WHITE : FIDUCIAL_BLACK;
+            drawRect(img, cellTopLeft, cellSize, color, SHAPE_FILL, 0);
+        }
+    }
+}
+
+} // namespace cpparas
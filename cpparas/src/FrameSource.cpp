@@ -0,0 +1,547 @@
+#include "FrameSource.hpp"
+#include "debug/Debug.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace cpparas {
+
+static bool sameRect(const Rect<int32_t>& a, const Rect<int32_t>& b)
+{
+    return a.origin.col == b.origin.col && a.origin.row == b.origin.row && a.width == b.width && a.height == b.height;
+}
+
+// Crops a region out of a basic or RGB888 plane and scales it to the size of dst, nearest neighbour.
+static void resamplePlane(const image_t* src, const Rect<int32_t>& region, image_t* dst)
+{
+    const int32_t pixelSize = src->type == IMGTYPE_RGB888 ? 3 : 1;
+    const uint8_t* srcData = (const uint8_t*)src->data;
+    uint8_t* dstData = (uint8_t*)dst->data;
+    for (int32_t row = 0; row < dst->rows; row++) {
+        int32_t srcRow = region.origin.row + row * region.height / dst->rows;
+        const uint8_t* srcLine = srcData + ((std::size_t)srcRow * src->cols + region.origin.col) * pixelSize;
+        uint8_t* dstLine = dstData + (std::size_t)row * dst->cols * pixelSize;
+        if (region.width == dst->cols) {
+            // Only cropped
+            std::memcpy(dstLine, srcLine, (std::size_t)dst->cols * pixelSize);
+            continue;
+        }
+        for (int32_t col = 0; col < dst->cols; col++) {
+            const uint8_t* srcPixel = srcLine + (std::size_t)(col * region.width / dst->cols) * pixelSize;
+            for (int32_t i = 0; i < pixelSize; i++) {
+                dstLine[col * pixelSize + i] = srcPixel[i];
+            }
+        }
+    }
+}
+
+// Returns the size of the frames that show a region in a stream mode.
+static void streamSize(StreamMode mode, const Rect<int32_t>& region, FrameFormat format, uint32_t& cols, uint32_t& rows)
+{
+    cols = region.width;
+    rows = region.height;
+    if (mode == StreamMode::PREVIEW) {
+        // Keep at least two cols and rows, so even tiny test frames fit a YUV420 frame.
+        cols = std::max(cols / PREVIEW_DOWNSCALE, 2u);
+        rows = std::max(rows / PREVIEW_DOWNSCALE, 2u);
+    }
+    if (format == FrameFormat::YUV420) {
+        cols &= ~1u;
+        rows &= ~1u;
+    }
+}
+
+// Returns a view of the first cols x rows frame in a slot image.
+static image_t frameInImage(const image_t* image, FrameFormat format, uint32_t cols, uint32_t rows)
+{
+    image_t frame = *image;
+    frame.cols = cols;
+    frame.rows = format == FrameFormat::YUV420 ? rows * 3 / 2 : rows;
+    return frame;
+}
+
+FrameSource::FrameSource(double frameRate_, FrameFormat format_)
+    : frameRate(frameRate_)
+    , format(format_)
+    , requestedMode(StreamMode::FULL)
+    , requestedRegion({ { 0, 0 }, 0, 0 })
+    , running(false)
+    , firstFrameReady(false)
+    , latestSequence(0)
+    , readerWoken(false)
+    , frameCols(0)
+    , frameRows(0)
+    , activeRing((int32_t)StreamMode::FULL)
+    , currentRing((int32_t)StreamMode::FULL)
+    , consumedSequence(0)
+{
+}
+
+FrameSource::~FrameSource()
+{
+    stop();
+}
+
+void FrameSource::start()
+{
+    if (running) {
+        return;
+    }
+    if (captureWorker.joinable()) {
+        // The previous capture thread stopped on its own.
+        captureWorker.join();
+    }
+    // The rings may be rebuilt when the backend opens again.
+    releaseFrame();
+    running = true;
+    firstFrameReady = false;
+    captureWorker = std::thread(&FrameSource::captureThread, this);
+    std::unique_lock<std::mutex> locker(mtx);
+    while (!firstFrameReady && running) {
+        condVar.wait(locker);
+    }
+}
+
+void FrameSource::stop()
+{
+    {
+        // Wakes up a capture thread that waits with a still frame
+        std::unique_lock<std::mutex> locker(mtx);
+        running = false;
+        condVar.notify_all();
+    }
+    if (captureWorker.joinable()) {
+        captureWorker.join();
+    }
+    releaseFrame();
+}
+
+bool FrameSource::isRunning() const
+{
+    return running;
+}
+
+image_t* FrameSource::getFrame()
+{
+    if (!running) {
+        return nullptr;
+    }
+    releaseFrame();
+    currentRing = activeRing;
+    FrameRing& ring = *frames[currentRing];
+    if (!ring.acquireLatest(currentFrame)) {
+        return nullptr;
+    }
+    if (currentFrame.sequence != consumedSequence) {
+        std::lock_guard<std::mutex> locker(statisticsMtx);
+        if (consumedSequence != 0 && currentFrame.sequence > consumedSequence) {
+            statistics.skippedFrames += currentFrame.sequence - consumedSequence - 1;
+        }
+        statistics.consumedFrames++;
+        statistics.readerLag.add(std::chrono::duration<double, std::milli>(CaptureClock::now() - currentFrame.timestamp).count());
+        consumedSequence = currentFrame.sequence;
+    }
+    frameView = frameInImage(currentFrame.image, ring.getFormat(), currentFrame.cols, currentFrame.rows);
+    if (ring.getFormat() == FrameFormat::RGB888) {
+        return &frameView;
+    }
+    viewFramePlanes(&frameView, ring.getFormat(), lumaView, chromaUView, chromaVView);
+    return &lumaView;
+}
+
+const image_t* FrameSource::getChromaU() const
+{
+    if (currentFrame.image == nullptr || frames[currentRing]->getFormat() != FrameFormat::YUV420) {
+        return nullptr;
+    }
+    return &chromaUView;
+}
+
+const image_t* FrameSource::getChromaV() const
+{
+    if (currentFrame.image == nullptr || frames[currentRing]->getFormat() != FrameFormat::YUV420) {
+        return nullptr;
+    }
+    return &chromaVView;
+}
+
+const RingFrame& FrameSource::getFrameInfo() const
+{
+    return currentFrame;
+}
+
+void FrameSource::setFrameRate(double frameRate_)
+{
+    frameRate = frameRate_;
+}
+
+double FrameSource::getFrameRate() const
+{
+    return frameRate;
+}
+
+void FrameSource::setFormat(FrameFormat format_)
+{
+    format = format_;
+}
+
+FrameFormat FrameSource::getFormat() const
+{
+    return format;
+}
+
+void FrameSource::setStreamMode(StreamMode mode)
+{
+    if (requestedMode.exchange(mode) != mode) {
+        std::unique_lock<std::mutex> locker(mtx);
+        condVar.notify_all();
+    }
+}
+
+StreamMode FrameSource::getStreamMode() const
+{
+    return requestedMode;
+}
+
+void FrameSource::setRegionOfInterest(const Rect<int32_t>& region)
+{
+    {
+        std::lock_guard<std::mutex> locker(regionMtx);
+        requestedRegion = region;
+    }
+    std::unique_lock<std::mutex> locker(mtx);
+    condVar.notify_all();
+}
+
+Rect<int32_t> FrameSource::getRegionOfInterest() const
+{
+    std::lock_guard<std::mutex> locker(regionMtx);
+    return requestedRegion;
+}
+
+uint32_t FrameSource::getFullCols() const
+{
+    return frameCols;
+}
+
+uint32_t FrameSource::getFullRows() const
+{
+    return frameRows;
+}
+
+CaptureStatistics FrameSource::getStatistics() const
+{
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    return statistics;
+}
+
+void FrameSource::resetStatistics()
+{
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    statistics = CaptureStatistics();
+}
+
+bool FrameSource::waitForFrame(uint64_t sequence, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> locker(mtx);
+    condVar.wait_for(locker, timeout, [&]() {
+        return latestSequence > sequence || !running || readerWoken;
+    });
+    readerWoken = false;
+    return latestSequence > sequence;
+}
+
+void FrameSource::wakeReader()
+{
+    std::unique_lock<std::mutex> locker(mtx);
+    readerWoken = true;
+    condVar.notify_all();
+}
+
+bool FrameSource::deliversStillFrames() const
+{
+    return false;
+}
+
+bool FrameSource::pacedByDevice() const
+{
+    return false;
+}
+
+uint32_t FrameSource::warmupFrames() const
+{
+    return 0;
+}
+
+FrameFormat FrameSource::nativeFormat() const
+{
+    return FrameFormat::RGB888;
+}
+
+uint64_t FrameSource::droppedByDevice() const
+{
+    return 0;
+}
+
+bool FrameSource::configureStream(StreamMode mode, const Rect<int32_t>& region, uint32_t cols, uint32_t rows, Rect<int32_t>& nativeRegion)
+{
+    (void)mode;
+    (void)region;
+    (void)cols;
+    (void)rows;
+    (void)nativeRegion;
+    return true;
+}
+
+void FrameSource::setFrameSize(uint32_t cols, uint32_t rows)
+{
+    frameCols = cols;
+    frameRows = rows;
+}
+
+void FrameSource::releaseFrame()
+{
+    if (currentFrame.image != nullptr) {
+        frames[currentRing]->release(currentFrame);
+    }
+}
+
+// Returns the ring of a stream mode, big enough for frames that show the whole field of view.
+// Rings are created on the capture thread before the reader can see them.
+FrameRing* FrameSource::ringForMode(StreamMode mode, FrameFormat ringFormat)
+{
+    Rect<int32_t> fullRegion = alignRegion({ { 0, 0 }, 0, 0 }, ringFormat);
+    uint32_t cols;
+    uint32_t rows;
+    streamSize(mode, fullRegion, ringFormat, cols, rows);
+    std::unique_ptr<FrameRing>& ring = frames[(int32_t)mode];
+    if (!ring || ring->getCols() != cols || ring->getRows() != rows || ring->getFormat() != ringFormat) {
+        ring.reset(new FrameRing(cols, rows, 3, ringFormat));
+    }
+    return ring.get();
+}
+
+Rect<int32_t> FrameSource::alignRegion(Rect<int32_t> region, FrameFormat ringFormat) const
+{
+    const int32_t cols = frameCols;
+    const int32_t rows = frameRows;
+    int32_t left = std::min(std::max(region.origin.col, 0), cols);
+    int32_t top = std::min(std::max(region.origin.row, 0), rows);
+    int32_t right = std::min(std::max(region.origin.col + region.width, left), cols);
+    int32_t bottom = std::min(std::max(region.origin.row + region.height, top), rows);
+    if (region.width <= 0 || region.height <= 0 || right - left < 2 || bottom - top < 2) {
+        left = 0;
+        top = 0;
+        right = cols;
+        bottom = rows;
+    }
+    if (ringFormat == FrameFormat::YUV420) {
+        // The chroma planes have half the resolution, and a conversion drops an odd last row and col.
+        left &= ~1;
+        top &= ~1;
+        right = left + ((right - left) & ~1);
+        bottom = top + ((bottom - top) & ~1);
+    }
+    return { { left, top }, right - left, bottom - top };
+}
+
+void FrameSource::captureThread()
+{
+    const FrameFormat frameFormat = format;
+    if (nativeFormat() != frameFormat && nativeFormat() != FrameFormat::RGB888) {
+        Debug::println("Frame source can't convert to the requested frame format");
+        running = false;
+    } else if (open()) {
+        // Nobody holds a frame at this point, so rings with another layout can be rebuilt.
+        ringForMode(StreamMode::PREVIEW, frameFormat);
+        FrameRing* ring = ringForMode(StreamMode::FULL, frameFormat);
+        uint64_t sequence = std::max(frames[0]->latestSequence(), frames[1]->latestSequence()) + 1;
+        // open() prepares the backend for full resolution frames of the whole field of view.
+        StreamMode mode = StreamMode::FULL;
+        Rect<int32_t> region = alignRegion({ { 0, 0 }, 0, 0 }, frameFormat);
+        activeRing = (int32_t)mode;
+        // The part of the full resolution frame the backend reads
+        Rect<int32_t> nativeRegion = { { 0, 0 }, (int32_t)frameCols, (int32_t)frameRows };
+        bool streamCommitted = true;
+        bool buffersReady = false;
+        uint32_t cols = 0;
+        uint32_t rows = 0;
+        // Whether the backend frames need to be cropped or scaled
+        bool resampled = false;
+        Rect<int32_t> cropRegion = region;
+
+        // Frames are read here first when the backend delivers another format or size than the ring.
+        image_t* nativeFrame = nullptr;
+        // RGB888 frames that are resampled before they are converted
+        image_t* scaledFrame = nullptr;
+        // Only used when every free slot is held by the reader, which can't happen with a single reader.
+        image_t* discardFrame = nullptr;
+        uint32_t skippedFrames = 0;
+        CaptureClock::time_point nextFrameTime = CaptureClock::now();
+        CaptureClock::time_point lastCommitTime;
+        bool committed = false;
+        // Whether the picture of a still source was published in the current stream mode and region
+        bool stillPublished = false;
+
+        while (running) {
+            StreamMode wantedMode = requestedMode;
+            Rect<int32_t> wantedRegion = alignRegion(getRegionOfInterest(), frameFormat);
+            if (wantedMode != mode || !sameRect(wantedRegion, region)) {
+                uint32_t wantedCols;
+                uint32_t wantedRows;
+                streamSize(wantedMode, wantedRegion, frameFormat, wantedCols, wantedRows);
+                const Rect<int32_t> previousNative = nativeRegion;
+                if (!configureStream(wantedMode, wantedRegion, wantedCols, wantedRows, nativeRegion)) {
+                    running = false;
+                    break;
+                }
+                if (!sameRect(nativeRegion, previousNative)) {
+                    // The backend restarted, e.g. the camera adjusts its exposure again.
+                    skippedFrames = 0;
+                }
+                if (wantedMode != mode) {
+                    streamCommitted = false;
+                }
+                mode = wantedMode;
+                region = wantedRegion;
+                ring = frames[(int32_t)mode].get();
+                buffersReady = false;
+                stillPublished = false;
+            }
+            if (stillPublished) {
+                // Every further frame would show the same picture, so the next one is only read
+                // for another stream mode or region.
+                std::unique_lock<std::mutex> locker(mtx);
+                condVar.wait(locker, [&]() {
+                    return !running || requestedMode != mode || !sameRect(alignRegion(getRegionOfInterest(), frameFormat), region);
+                });
+                continue;
+            }
+            if (!buffersReady) {
+                for (image_t** buffer : { &nativeFrame, &scaledFrame, &discardFrame }) {
+                    if (*buffer != nullptr) {
+                        deleteImage(*buffer);
+                        *buffer = nullptr;
+                    }
+                }
+                streamSize(mode, region, frameFormat, cols, rows);
+                // The region in pixels of the backend frames
+                cropRegion = { { region.origin.col - nativeRegion.origin.col, region.origin.row - nativeRegion.origin.row }, region.width, region.height };
+                resampled = !(sameRect(region, nativeRegion) && region.width == (int32_t)cols && region.height == (int32_t)rows);
+                if (nativeFormat() != frameFormat || resampled) {
+                    nativeFrame = newFrameImage(nativeRegion.width, nativeRegion.height, nativeFormat());
+                }
+                if (nativeFormat() != frameFormat && resampled) {
+                    scaledFrame = newRGB888Image(cols, rows);
+                }
+                buffersReady = true;
+            }
+
+            image_t* slot = ring->beginWrite();
+            if (slot == nullptr) {
+                if (nativeFrame == nullptr && discardFrame == nullptr) {
+                    discardFrame = newFrameImage(cols, rows, nativeFormat());
+                }
+                if (!readFrame(nativeFrame != nullptr ? nativeFrame : discardFrame)) {
+                    running = false;
+                    break;
+                }
+                std::lock_guard<std::mutex> locker(statisticsMtx);
+                statistics.discardedFrames++;
+                continue;
+            }
+            image_t frame = frameInImage(slot, frameFormat, cols, rows);
+            CaptureClock::time_point readStart = CaptureClock::now();
+            bool frameRead = readFrame(nativeFrame != nullptr ? nativeFrame : &frame);
+            CaptureClock::time_point timestamp = CaptureClock::now();
+            if (!frameRead) {
+                ring->abortWrite();
+                running = false;
+                break;
+            }
+            if (skippedFrames < warmupFrames()) {
+                ring->abortWrite();
+                skippedFrames++;
+                std::lock_guard<std::mutex> locker(statisticsMtx);
+                statistics.warmupFrames++;
+                continue;
+            }
+            if (nativeFrame != nullptr) {
+                image_t luma;
+                image_t chromaU;
+                image_t chromaV;
+                viewFramePlanes(&frame, frameFormat, luma, chromaU, chromaV);
+                if (nativeFormat() != frameFormat) {
+                    const image_t* rgb = nativeFrame;
+                    if (scaledFrame != nullptr) {
+                        resamplePlane(nativeFrame, cropRegion, scaledFrame);
+                        rgb = scaledFrame;
+                    }
+                    convertRGB888ToYUV420(rgb, &luma, chromaU.data != nullptr ? &chromaU : NULL, chromaV.data != nullptr ? &chromaV : NULL);
+                } else if (frameFormat == FrameFormat::RGB888) {
+                    resamplePlane(nativeFrame, cropRegion, &frame);
+                } else {
+                    // Same planar layout, the chroma planes show the region at half the resolution.
+                    image_t nativeLuma;
+                    image_t nativeChromaU;
+                    image_t nativeChromaV;
+                    viewFramePlanes(nativeFrame, frameFormat, nativeLuma, nativeChromaU, nativeChromaV);
+                    resamplePlane(&nativeLuma, cropRegion, &luma);
+                    if (frameFormat == FrameFormat::YUV420) {
+                        Rect<int32_t> chromaRegion = { { cropRegion.origin.col / 2, cropRegion.origin.row / 2 }, cropRegion.width / 2, cropRegion.height / 2 };
+                        resamplePlane(&nativeChromaU, chromaRegion, &chromaU);
+                        resamplePlane(&nativeChromaV, chromaRegion, &chromaV);
+                    }
+                }
+            }
+            ring->commitWrite(timestamp, region, sequence++, cols, rows);
+            {
+                std::lock_guard<std::mutex> locker(statisticsMtx);
+                statistics.capturedFrames++;
+                statistics.droppedFrames = droppedByDevice();
+                statistics.readDuration.add(std::chrono::duration<double, std::milli>(timestamp - readStart).count());
+                if (committed) {
+                    statistics.frameInterval.add(std::chrono::duration<double, std::milli>(timestamp - lastCommitTime).count());
+                }
+                lastCommitTime = timestamp;
+                committed = true;
+            }
+            stillPublished = deliversStillFrames();
+            if (!streamCommitted) {
+                // The reader moves over to the new mode with its first frame.
+                activeRing = (int32_t)mode;
+                streamCommitted = true;
+            }
+            {
+                // Wakes up start() on the first frame and waitForFrame on every frame
+                std::unique_lock<std::mutex> locker(mtx);
+                latestSequence = sequence - 1;
+                firstFrameReady = true;
+                condVar.notify_all();
+            }
+
+            double rate = frameRate;
+            if (!pacedByDevice() && rate > 0.0) {
+                nextFrameTime += std::chrono::duration_cast<CaptureClock::duration>(std::chrono::duration<double>(1.0 / rate));
+                // Don't try to catch up when reading took longer than a frame period.
+                if (nextFrameTime < timestamp) {
+                    nextFrameTime = timestamp;
+                }
+                std::this_thread::sleep_until(nextFrameTime);
+            }
+        }
+        for (image_t* buffer : { nativeFrame, scaledFrame, discardFrame }) {
+            if (buffer != nullptr) {
+                deleteImage(buffer);
+            }
+        }
+        close();
+    } else {
+        running = false;
+    }
+    // Wake up anyone still waiting for the first frame.
+    std::unique_lock<std::mutex> locker(mtx);
+    condVar.notify_all();
+}
+
+} // namespace cpparas
@@ -4,22 +4,39 @@
 namespace cpparas {
 
 HandDetection::HandDetection()
-    : handDetected(false)
+    : thresholdedImage(nullptr)
+    , scratch(nullptr)
+    , handDetected(false)
     , simulatedHandDetected(false)
 {
 }
 
-void HandDetection::update(const image_t* image)
+HandDetection::~HandDetection()
 {
-    image_t* hsvImage = toHSVImage(image);
-    image_t* thresholdedImage = newBasicImage(image->cols, image->rows);
+    if (thresholdedImage != nullptr) {
+        deleteImage(thresholdedImage);
+        deleteBinaryScratch(scratch);
+    }
+}
+
+void HandDetection::update(const image_t* hsvImage)
+{
+    if (thresholdedImage == nullptr || thresholdedImage->cols != hsvImage->cols || thresholdedImage->rows != hsvImage->rows) {
+        if (thresholdedImage != nullptr) {
+            deleteImage(thresholdedImage);
+            deleteBinaryScratch(scratch);
+        }
+        // Packed, so the noise is opened away and the skin pixels are counted 64 at a time
+        thresholdedImage = newBinaryImage(hsvImage->cols, hsvImage->rows);
+        scratch = newBinaryScratch(hsvImage->cols, hsvImage->rows);
+    }
+
     threshold_hsv(hsvImage, thresholdedImage, HAND_THRESHOLD_LOW, HAND_THRESHOLD_HIGH);
+    binaryOpen(thresholdedImage, thresholdedImage, HAND_NOISE_SIZE, scratch);
     pixel_t th;
     th.basic_pixel = 1;
     uint32_t count = pixelCount(thresholdedImage, th);
     handDetected = count >= HAND_THRESHOLD_AREA;
-    deleteImage(hsvImage);
-    deleteImage(thresholdedImage);
 }
 
 bool HandDetection::containsHand() const
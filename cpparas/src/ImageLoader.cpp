@@ -1,9 +1,13 @@
 #include "ImageLoader.hpp"
+#include "Camera.hpp"
 
 namespace cpparas {
 
 ImageLoader::ImageLoader()
-    : new_UI_frame_available(false)
+    : selected_source(SourceType::CAMERA)
+    , user_image(nullptr)
+    , frame_rate(CAMERA_MAX_FRAME_RATE)
+    , frame_format(FrameFormat::YUV420)
 {
 }
 
@@ -40,23 +44,35 @@ image_t* ImageLoader::Get_source_image()
     return nullptr;
 }
 
-//Save frame to be displayed to ui, and raise flag for the ui to look for a new frame to show
-void ImageLoader::Set_UI_frame(image_t* frame)
+// Set the directory or raw stream file to replay
+void ImageLoader::Set_source_path(std::string path)
 {
-    ui_image = frame;
-    new_UI_frame_available = true;
+    source_path = path;
 }
 
-//request back the frame that was saved for the ui, used by the ui itself to get the image
-image_t* ImageLoader::Get_UI_frame()
+std::string ImageLoader::Get_source_path()
 {
-    new_UI_frame_available = false;
-    return ui_image;
+    return source_path;
 }
 
-bool ImageLoader::Get_new_UI_frame_available() const
+void ImageLoader::Set_frame_rate(double frameRate)
 {
-    return new_UI_frame_available;
+    frame_rate = frameRate;
+}
+
+double ImageLoader::Get_frame_rate()
+{
+    return frame_rate;
+}
+
+void ImageLoader::Set_frame_format(FrameFormat format)
+{
+    frame_format = format;
+}
+
+FrameFormat ImageLoader::Get_frame_format()
+{
+    return frame_format;
 }
 
 } // namespace cpparas
@@ -1,21 +1,92 @@
 #include "Locator.hpp"
-#include "MarkerDetector.hpp"
+#include "Camera.hpp"
+#include "DirectorySource.hpp"
+#include "RawStreamSource.hpp"
 #include "RegionExtractor.hpp"
+#include "StillImageSource.hpp"
+#include "SyntheticSource.hpp"
+#include "types/Calibration.hpp"
+#include "debug/Debug.hpp"
+#include <algorithm>
 #include <chrono>
-#include <stdexcept>
+#include <cmath>
+#include <iostream>
 #include <thread>
+#include <utility>
 
 namespace cpparas {
 
+// Margin around the baseplate that is still captured, in full resolution pixels.
+// Leaves room for the markers around the corners and for shifts the location checker reports.
+const int32_t CAPTURE_REGION_MARGIN = 150;
+// The whole frame is captured again when the markers were missed this often in a row
+const uint32_t CAPTURE_REGION_MAX_MISSES = 10;
+// The locator checks whether it should stop at least this often while no frames come in
+const std::chrono::milliseconds LOCATOR_WAIT_TIMEOUT(500);
+
+// The bounding box of the baseplate, of all four corners
+static Rect<int32_t> cornerBounds(const std::vector<Point<int32_t>>& corners)
+{
+    int32_t left = corners[0].col;
+    int32_t top = corners[0].row;
+    int32_t right = corners[0].col;
+    int32_t bottom = corners[0].row;
+    for (const Point<int32_t>& point : corners) {
+        left = std::min(left, point.col);
+        top = std::min(top, point.row);
+        right = std::max(right, point.col);
+        bottom = std::max(bottom, point.row);
+    }
+    return { { left, top }, right - left + 1, bottom - top + 1 };
+}
+
+// The center of the baseplate where its diagonals cross, which the perspective moves away from the middle between two corners
+static Point<int32_t> baseplateCenter(const std::vector<Point<int32_t>>& corners)
+{
+    const double diagonalCol = corners[2].col - corners[0].col;
+    const double diagonalRow = corners[2].row - corners[0].row;
+    const double otherCol = corners[3].col - corners[1].col;
+    const double otherRow = corners[3].row - corners[1].row;
+    const double det = diagonalCol * otherRow - diagonalRow * otherCol;
+    double t = 0.5;
+    if (det != 0.0) {
+        t = ((corners[1].col - corners[0].col) * otherRow - (corners[1].row - corners[0].row) * otherCol) / det;
+    }
+    return { corners[0].col + (int32_t)std::lround(t * diagonalCol), corners[0].row + (int32_t)std::lround(t * diagonalRow) };
+}
+
+// Whether two frames show the same part of a still picture at the same size
+static bool sameView(const RingFrame& frame, const RingFrame& other)
+{
+    return frame.cols == other.cols && frame.rows == other.rows
+        && frame.fieldOfView.origin.col == other.fieldOfView.origin.col && frame.fieldOfView.origin.row == other.fieldOfView.origin.row
+        && frame.fieldOfView.width == other.fieldOfView.width && frame.fieldOfView.height == other.fieldOfView.height;
+}
+
 Locator::Locator(std::shared_ptr<ImageLoader> imageLoader_)
     : locator_running(false)
     , first_frame(false)
     , moved_interupt(false)
     , active_corner_detection(true)
+    , stream_mode(StreamMode::FULL)
+    , full_frame_cut(false)
+    , stud_layer(0)
+    , work_requested(false)
+    , max_rate(FRAME_RATE_UNLIMITED)
+    , scene_changes(0)
     , imageLoader(imageLoader_)
-    , PiCamera(1440, 1440)
     , RegExtractor(800, 800)
+    , cut_frames(FrameChannel::create(800, 800, FrameFormat::RGB888))
+    , stud_grid(DEFAULT_CALIBRATION)
+    , stud_frames(FrameChannel::create(stud_grid.getCols(), stud_grid.getRows(), FrameFormat::RGB888))
+    , capture_region({ { 0, 0 }, 0, 0 })
+    , missed_detections(0)
+    , motion_markers(motion.addReference())
+    , motion_baseplate(motion.addReference())
+    , markers_found(false)
 {
+    // The markers sit on the corners of the baseplate, the region spans the centers of the corner studs
+    RegExtractor.setBaseplate(DEFAULT_CALIBRATION.baseplateCols, DEFAULT_CALIBRATION.baseplateRows);
 }
 
 //Kill thread, which in turn will kill camera thread as well;
@@ -31,8 +102,17 @@ Locator::~Locator()
 void Locator::Start_Locator_thread()
 {
     if (!locator_running) {
+        if (locator_thread.joinable()) {
+            // The previous thread stopped on its own when its source ran out of frames.
+            locator_thread.join();
+        }
+        frame_source = user_frame_source ? user_frame_source : Create_frame_source();
+        if (!frame_source) {
+            return;
+        }
         locator_running = true;
-        source_type = imageLoader->Get_source_type();
+        cut_frames->open();
+        stud_frames->open();
         locator_thread = std::thread(&Locator::Locator_thread, this);
     }
 }
@@ -41,6 +121,7 @@ void Locator::Start_Locator_thread()
 void Locator::Stop_Locator_thread()
 {
     locator_running = false;
+    Wake_locator_thread();
     if (locator_thread.joinable()) {
         locator_thread.join();
     }
@@ -48,44 +129,84 @@ void Locator::Stop_Locator_thread()
 
 void Locator::Locator_thread()
 {
-    if (source_type == SourceType::CAMERA) {
-        //start Camera thread
-        PiCamera.Camera_thread_worker_start();
-    }
+    //start capture thread, the markers need to be found in the whole frame first
+    capture_region = { { 0, 0 }, 0, 0 };
+    frame_source->setRegionOfInterest(capture_region);
+    RegExtractor.resetTracking();
+    markers_found = false;
+    cut_points.clear();
+    frame_source->start();
+
+    // The last frame that was looked at
+    RingFrame processed_frame;
+    CaptureClock::time_point next_run = CaptureClock::now();
 
     while (locator_running) {
-        if (source_type == SourceType::CAMERA) {
-            //Get a new frame from camera
-            new_full_frame = PiCamera.Camera_get_frame();
-        } else if (source_type == SourceType::IMAGE) {
-            //Load user image
-            new_full_frame = imageLoader->Get_source_image();
-        } else {
-            //smth is wrong I can feel it
-            locator_running = false;
-            break;
+        frame_source->setStreamMode(stream_mode);
+        //Sleep until a new frame comes in or work is requested
+        if (!work_requested && !frame_source->waitForFrame(processed_frame.sequence, LOCATOR_WAIT_TIMEOUT) && frame_source->isRunning()) {
+            continue;
+        }
+        //Don't run more often than the current state needs
+        double rate = max_rate;
+        if (rate > 0.0) {
+            std::this_thread::sleep_until(next_run);
         }
-        //if new frame is none, camera is dead, so we need to stop locator
+        bool work = work_requested.exchange(false);
+
+        //Get the newest frame from the source
+        new_full_frame = frame_source->getFrame();
+        //if new frame is none, the source is dead or out of frames, so we need to stop locator
         if (new_full_frame == nullptr) {
             locator_running = false;
             break;
         }
+        const RingFrame& frame = frame_source->getFrameInfo();
+        bool unchanged = frame.sequence == processed_frame.sequence
+            || (frame_source->deliversStillFrames() && sameView(frame, processed_frame));
+        processed_frame = frame;
+        if (unchanged && !work) {
+            // Nothing to find or cut that wasn't already
+            continue;
+        }
+        if (rate > 0.0) {
+            next_run = CaptureClock::now() + std::chrono::duration_cast<CaptureClock::duration>(std::chrono::duration<double>(1.0 / rate));
+        }
 
-        //Get cameras center point
-        Central_camera_point.col = new_full_frame->cols / 2;
-        Central_camera_point.row = new_full_frame->rows / 2;
+        // Frames may only show a region, and preview frames show it at a lower resolution.
+        // Corners are kept in full resolution pixels.
+        const Rect<int32_t>& fieldOfView = frame.fieldOfView;
+        bool fullResolution = fieldOfView.width == new_full_frame->cols;
 
-        //find corners
+        //Get cameras center point, where the baseplate lies under the projector
+        Central_camera_point.col = frame_source->getFullCols() / 2 + DEFAULT_CALIBRATION.projectorCenterOffset.col;
+        Central_camera_point.row = frame_source->getFullRows() / 2 + DEFAULT_CALIBRATION.projectorCenterOffset.row;
+        // The capture rows span the vertical field of view, the perspective of the baseplate follows from it
+        const double focal_length = frame_source->getFullRows() / 2.0 / std::tan(DEFAULT_CALIBRATION.cameraVerticalFov / 2.0 * std::acos(-1.0) / 180.0);
+        RegExtractor.setCamera(focal_length, { frame_source->getFullCols() / 2.0, frame_source->getFullRows() / 2.0 });
+
+        //See which parts of the frame changed
+        motion.update(new_full_frame, fieldOfView);
+
+        //find corners, unless the markers were found and nothing changed around them
         std::vector<Point<int32_t>> corner_points;
-        if(active_corner_detection){
-            corner_points = RegExtractor.updateImage(new_full_frame);
+        if (active_corner_detection && fullResolution && (work || !markers_found || Markers_changed())) {
+            // Only the windows around the previous corners are searched while the markers can be tracked.
+            // A captured region is searched for markers as far apart as in the full frame.
+            const double marker_spacing = MarkerDetector::markerSpacing(frame_source->getFullCols(), frame_source->getFullRows());
+            corner_points = RegExtractor.locateMarkers(new_full_frame, fieldOfView.origin, marker_spacing);
+            motion.accept(motion_markers);
+            markers_found = corner_points.size() == 3;
+            if (!markers_found && ++missed_detections >= CAPTURE_REGION_MAX_MISSES) {
+                // The baseplate may have moved out of the region
+                Update_capture_region({});
+            }
         }
         if (corner_points.size() == 3) {
+            missed_detections = 0;
 
-            //caclulate center point based on 3 points
-            Central_board_point.col = (corner_points[0].col + corner_points[2].col) / 2;
-            // the magic number 50 is an offset because the camera is not perfectly centered to the projector
-            Central_board_point.row = ((corner_points[0].row + corner_points[2].row) / 2) + 50;
+            //caclulate center point based on the 3 points and the fourth corner they imply
+            Central_board_point = baseplateCenter(RegExtractor.completeCorners(corner_points));
 
             // Reset flag
             moved_interupt = false;
@@ -99,63 +220,102 @@ void Locator::Locator_thread()
                 moved_interupt = true;
             }
 
-            // Get the new cut frame
-            new_cut_frame = RegExtractor.getRegionImage();
+            // Only capture the baseplate, or the whole frame again to follow a shifted baseplate
+            Update_capture_region(moved_interupt ? std::vector<Point<int32_t>>() : corner_points);
 
             // Save good coordinates
             corner_points_old = corner_points;
+        }
+
+        //cut and warp frame using the newest coordinates, which may be older ones when no new points were found
+        if (corner_points_old.size() == 3) {
+            // Cut again when the baseplate changed or was found somewhere else
+            std::vector<Point<int32_t>> baseplate_corners = RegExtractor.completeCorners(corner_points_old);
+            bool baseplate_changed = motion.changed(motion_baseplate, cornerBounds(baseplate_corners));
+            if (baseplate_changed) {
+                scene_changes++;
+            }
+            if (work || baseplate_changed || corner_points_old != cut_points) {
+                // moved into the frame, which may be a region or a preview, with the fourth corner to take out the perspective
+                std::vector<Point<int32_t>> frame_points = baseplate_corners;
+                for (Point<int32_t>& point : frame_points) {
+                    point.col = (point.col - fieldOfView.origin.col) * new_full_frame->cols / fieldOfView.width;
+                    point.row = (point.row - fieldOfView.origin.row) * new_full_frame->rows / fieldOfView.height;
+                }
+                Publish_cut_frame(frame_points, fullResolution);
+                motion.accept(motion_baseplate);
+                cut_points = corner_points_old;
+            }
 
             // Set first frame accuaried bool
             if (!first_frame) {
                 first_frame = true;
             }
-
         } else {
-            //No new points found but we have older coordinates
-            if (corner_points_old.size() == 3) {
-                int32_t colpos[3] = {
-                    corner_points_old[0].col,
-                    corner_points_old[1].col,
-                    corner_points_old[2].col,
-                };
-                int32_t rowpos[3] = {
-                    corner_points_old[0].row,
-                    corner_points_old[1].row,
-                    corner_points_old[2].row
-                };
-                //cut and warp frame using old coordinates
-                warp(new_full_frame, new_cut_frame, colpos, rowpos);
-            } else {
-                // If no points were found at all, do nothing and try again
-                std::cout<<"No coordinates found, like at all, not even once since we started:/"<<std::endl;
-            }
+            // If no points were found at all, do nothing and try again
+            std::cout<<"No coordinates found, like at all, not even once since we started:/"<<std::endl;
         }
-
-        //wait a bit, no need to run this at full powaa
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
-    PiCamera.Camera_thread_worker_stop();
+    frame_source->stop();
+    // Subscribers waiting for a frame give up
+    cut_frames->close();
+    stud_frames->close();
 }
 
-//Get latest cut frame from locator
-image_t* Locator::Get_new_frame()
+std::shared_ptr<FrameSubscriber> Locator::Subscribe(DropPolicy policy)
 {
-    if (!locator_running) {
-        throw std::runtime_error("Camera and locator thread stopped unexpectedly");
+    return cut_frames->subscribe(policy);
+}
+
+std::shared_ptr<FrameSubscriber> Locator::Subscribe_studs(DropPolicy policy)
+{
+    return stud_frames->subscribe(policy);
+}
+
+// Cut the region out of the current frame straight into the channel
+void Locator::Publish_cut_frame(const std::vector<Point<int32_t>>& frame_points, bool full_resolution)
+{
+    std::shared_ptr<Frame> cut_frame = cut_frames->acquire();
+    // The HSV image is made while the region is sampled, for the hand detection and every other reader of the frame
+    RegExtractor.extractRegion(new_full_frame, frame_source->getChromaU(), frame_source->getChromaV(), frame_points, cut_frame->getImage(), cut_frame->provideHSVImage());
+    const RingFrame& frame = frame_source->getFrameInfo();
+    FrameInfo info;
+    info.sequence = frame.sequence;
+    info.timestamp = frame.timestamp;
+    info.fieldOfView = frame.fieldOfView;
+    info.sceneChanges = scene_changes;
+    cut_frame->setInfo(info);
+    full_frame_cut = full_resolution;
+    cut_frames->publish(std::move(cut_frame));
+
+    // Preview frames are too coarse to tell the studs apart
+    if (!full_resolution) {
+        return;
     }
-    if (new_cut_frame->type != IMGTYPE_RGB888) {
-        throw std::runtime_error("Locator tried to return wrong type (and probably empty) image. That's not good");
+    // The studs are gathered straight from the frame, with their HSV colors in the same pass
+    std::shared_ptr<Frame> stud_frame = stud_frames->acquire();
+    info.studLayer = stud_layer;
+    stud_grid.setLayer(info.studLayer);
+    stud_grid.setCorners(frame_points);
+    if (!stud_grid.sample(new_full_frame, frame_source->getChromaU(), frame_source->getChromaV(), stud_frame->getImage(), stud_frame->provideHSVImage())) {
+        return;
     }
-    return new_cut_frame;
+    stud_frame->setInfo(info);
+    stud_frames->publish(std::move(stud_frame));
 }
 
-//Send a frame to image loader
-void Locator::Send_frame_to_ui(image_t* frame)
+TrackingStatistics Locator::Get_tracking_statistics()
 {
-    if (!locator_running) {
-        throw std::runtime_error("Camera and locator thread stopped unexpectedly");
+    return RegExtractor.getTrackingStatistics();
+}
+
+CaptureStatistics Locator::Get_capture_statistics()
+{
+    std::shared_ptr<FrameSource> source = frame_source;
+    if (!source) {
+        return CaptureStatistics();
     }
-    imageLoader->Set_UI_frame(frame);
+    return source->getStatistics();
 }
 
 // Check if at least one frame is available
@@ -170,9 +330,148 @@ bool Locator::Location_checker()
     return moved_interupt;
 }
 
+uint64_t Locator::Scene_changes()
+{
+    return scene_changes;
+}
+
+// Whether the parts of the frame around the markers changed since the markers were last looked for
+bool Locator::Markers_changed()
+{
+    if (corner_points_old.size() != 3) {
+        return motion.changed(motion_markers, { { 0, 0 }, 0, 0 });
+    }
+    const int32_t radius = MARKER_TRACKING_WINDOW_RADIUS;
+    for (const Point<int32_t>& corner : corner_points_old) {
+        if (motion.changed(motion_markers, { { corner.col - radius, corner.row - radius }, 2 * radius, 2 * radius })) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Locator::Active_corner_detection(bool state)
 {
-    active_corner_detection = state;
+    bool was_active = active_corner_detection.exchange(state);
+    if (state && !was_active) {
+        // Look for the markers again, even when the frame didn't change
+        work_requested = true;
+        Wake_locator_thread();
+    }
+}
+
+void Locator::Set_max_rate(double frames_per_second)
+{
+    max_rate = frames_per_second;
+}
+
+void Locator::Wake_locator_thread()
+{
+    std::shared_ptr<FrameSource> source = frame_source;
+    if (source) {
+        source->wakeReader();
+    }
+}
+
+void Locator::Set_frame_source(std::shared_ptr<FrameSource> source)
+{
+    user_frame_source = source;
+}
+
+void Locator::Request_stream_mode(StreamMode mode)
+{
+    if (mode != stream_mode) {
+        // Frames in the previous mode may still be cut until the source switched.
+        full_frame_cut = false;
+        stream_mode = mode;
+        // The locator thread passes the mode on to the source
+        Wake_locator_thread();
+    }
+}
+
+void Locator::Request_stud_layer(uint32_t layer)
+{
+    if (stud_layer.exchange(layer) != layer) {
+        // Gather the current frame again for the new layer
+        work_requested = true;
+        Wake_locator_thread();
+    }
+}
+
+bool Locator::Full_frame_available()
+{
+    return full_frame_cut;
+}
+
+// Captures only the bounding box of the baseplate with a margin, or the whole frame without corners.
+// The region only grows or moves when the baseplate leaves its inner part, because every change
+// may restart the camera.
+void Locator::Update_capture_region(const std::vector<Point<int32_t>>& corners)
+{
+    Rect<int32_t> region = { { 0, 0 }, 0, 0 };
+    if (corners.size() == 3) {
+        Rect<int32_t> bounds = cornerBounds(RegExtractor.completeCorners(corners));
+        int32_t left = bounds.origin.col;
+        int32_t top = bounds.origin.row;
+        int32_t right = left + bounds.width - 1;
+        int32_t bottom = top + bounds.height - 1;
+        const int32_t innerMargin = CAPTURE_REGION_MARGIN / 2;
+        if (capture_region.width > 0 && left - innerMargin >= capture_region.origin.col && top - innerMargin >= capture_region.origin.row
+            && right + innerMargin <= capture_region.origin.col + capture_region.width && bottom + innerMargin <= capture_region.origin.row + capture_region.height) {
+            return;
+        }
+        region = { { left - CAPTURE_REGION_MARGIN, top - CAPTURE_REGION_MARGIN }, right - left + 2 * CAPTURE_REGION_MARGIN, bottom - top + 2 * CAPTURE_REGION_MARGIN };
+    } else if (capture_region.width == 0) {
+        return;
+    }
+    capture_region = region;
+    missed_detections = 0;
+    frame_source->setRegionOfInterest(region);
+}
+
+// Create the frame source that was selected in the image loader
+std::shared_ptr<FrameSource> Locator::Create_frame_source()
+{
+    const uint32_t cols = DEFAULT_CALIBRATION.captureResolutionCols;
+    const uint32_t rows = DEFAULT_CALIBRATION.captureResolutionRows;
+    const double frameRate = imageLoader->Get_frame_rate();
+    FrameFormat format = imageLoader->Get_frame_format();
+    std::shared_ptr<FrameSource> source;
+    switch (imageLoader->Get_source_type()) {
+    case SourceType::CAMERA:
+        source = std::make_shared<Camera>(cols, rows, frameRate, format);
+        break;
+    case SourceType::IMAGE:
+        if (imageLoader->Get_source_image() != nullptr) {
+            source = std::make_shared<StillImageSource>(imageLoader->Get_source_image(), frameRate);
+        }
+        break;
+    case SourceType::DIRECTORY:
+        source = std::make_shared<DirectorySource>(imageLoader->Get_source_path(), frameRate);
+        break;
+    case SourceType::RAW_STREAM: {
+        // The file tells the format it was recorded in, only RGB888 streams can be converted to the captured format
+        FrameFormat stream_format = FrameFormat::RGB888;
+        RawStreamSource::formatOfFile(imageLoader->Get_source_path(), stream_format);
+        source = std::make_shared<RawStreamSource>(imageLoader->Get_source_path(), cols, rows, frameRate, true, stream_format);
+        if (stream_format != FrameFormat::RGB888) {
+            format = stream_format;
+        }
+        break;
+    }
+    case SourceType::SYNTHETIC:
+        source = std::make_shared<SyntheticSource>(cols, rows, frameRate);
+        break;
+    default:
+        break;
+    }
+    if (!source) {
+        //smth is wrong I can feel it
+        Debug::println("Locator: no usable frame source selected");
+        return nullptr;
+    }
+    source->setFormat(format);
+    return source;
 }
 
 } // namespace cpparas
@@ -1,14 +1,137 @@
 #include "MarkerDetector.hpp"
 #include "debug/Debug.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace cpparas {
 
-std::vector<Point<int32_t>> MarkerDetector::detectMarkers(const image_t* img)
+// Strongest corners the three markers are chosen from
+static const uint32_t MARKER_CORNER_CANDIDATES = 8;
+// Responses this close to a stronger response belong to the same corner, in pixels of the corner image.
+static const uint8_t MARKER_CORNER_SEPARATION = 8;
+// Distance between the markers in the gray image that the erosion and dilation sizes are chosen for
+static const double MARKER_GRAY_SPACING = 395.0;
+static const double MARKER_ERODE_SIZE = 15.0;
+static const double MARKER_DILATE_SIZE = 8.0;
+// Distance between the markers in the corner image that the corner kernel, separation and side offset are chosen for
+static const double MARKER_CORNER_SPACING = 99.0;
+// The distances between the markers may lie this far below or above the expected spacing, as a fraction.
+static const double MARKER_MIN_SPACING = 0.63;
+static const double MARKER_MAX_SPACING = 1.4;
+// Half the size of the window a corner is refined in, as a fraction of the spacing
+static const double MARKER_REFINE_RADIUS = 0.02;
+// A refinement stops when a step moves the corner less than this, in frame pixels.
+static const double MARKER_REFINE_EPSILON = 0.01;
+static const int32_t MARKER_REFINE_ITERATIONS = 10;
+// How far the two sides along the markers may differ, and how far the diagonal may differ from
+// sqrt(2) times a side, as a fraction.
+static const double MARKER_SIDE_TOLERANCE = 0.15;
+// Pixels of the corner image between a corner and the pixels that tell on which side the marker lies
+static const int32_t MARKER_SIDE_OFFSET = 2;
+
+// Every thread that detects markers keeps its own scratch memory, which grows to the largest image it saw.
+static corner_scratch_t* cornerScratch(const image_t* img)
+{
+    thread_local std::unique_ptr<corner_scratch_t, decltype(&deleteCornerScratch)> scratch(nullptr, &deleteCornerScratch);
+    if (!scratch || scratch->capacity < img->cols * img->rows || scratch->cols < img->cols) {
+        scratch.reset(newCornerScratch(img->cols, img->rows));
+    }
+    return scratch.get();
+}
+
+static binary_scratch_t* binaryScratch(const image_t* img)
+{
+    thread_local std::unique_ptr<binary_scratch_t, decltype(&deleteBinaryScratch)> scratch(nullptr, &deleteBinaryScratch);
+    if (!scratch || scratch->cols < img->cols || scratch->rows < img->rows) {
+        scratch.reset(newBinaryScratch(img->cols, img->rows));
+    }
+    return scratch.get();
+}
+
+static uint8_t grayAt(const image_t* img, int32_t col, int32_t row)
+{
+    if (img->type == IMGTYPE_BASIC) {
+        return getBasicPixel(img, col, row);
+    }
+    rgb888_pixel_t pixel = getRGB888Pixel(img, col, row);
+    return (pixel.r + 2 * pixel.g + pixel.b) / 4;
+}
+
+// The sizes the detection uses for a frame, derived from the distance between the markers in it.
+struct DetectionScale {
+    // Expected distance between the markers in frame pixels
+    double spacing;
+    // Frame pixels per pixel of the gray image
+    uint8_t gray;
+    // Gray pixels per pixel of the corner image
+    int32_t corner;
+    uint8_t erode;
+    uint8_t dilate;
+};
+
+double MarkerDetector::markerSpacing(int32_t cols, int32_t rows)
+{
+    return MARKER_SPACING * std::min(cols, rows);
+}
+
+// Without a spacing the image is the whole frame
+static double spacingIn(const image_t* img, double spacing)
+{
+    return spacing > 0.0 ? spacing : MarkerDetector::markerSpacing(img->cols, img->rows);
+}
+
+static DetectionScale detectionScale(const image_t* img, double spacing)
+{
+    auto factor = [](double ratio, double max) {
+        return std::min(std::max(std::round(ratio), 1.0), max);
+    };
+    DetectionScale scale;
+    scale.spacing = spacingIn(img, spacing);
+    scale.gray = (uint8_t)factor(scale.spacing / MARKER_GRAY_SPACING, 255);
+    double graySpacing = scale.spacing / scale.gray;
+    scale.corner = (int32_t)factor(graySpacing / MARKER_CORNER_SPACING, 255);
+    scale.erode = (uint8_t)factor(MARKER_ERODE_SIZE * graySpacing / MARKER_GRAY_SPACING, 255);
+    scale.dilate = (uint8_t)factor(MARKER_DILATE_SIZE * graySpacing / MARKER_GRAY_SPACING, 255);
+    return scale;
+}
+
+// Returns the grayscale image that the detection runs on, at about the same size for every resolution of the frame.
+// The RGB888 frame or the Y plane of a YUV420 frame is read once, and every pixel is the mean of a block.
+static image_t* prepareImage(const image_t* img, const DetectionScale& scale)
+{
+    image_t* src_basic = newBasicImage(img->cols / scale.gray, img->rows / scale.gray);
+    downscale(img, src_basic, scale.gray);
+    return src_basic;
+}
+
+static std::vector<Point<int32_t>> detectPointsPrepared(const image_t* src_basic, const uint8_t thresh_val, const DetectionScale& scale);
+
+// Refines the corners in the frame and rounds them back to the points.
+static void refineDetection(const image_t* img, std::vector<Point<int32_t>>& points, std::vector<Point<double>>& corners, double spacing)
+{
+    corners.clear();
+    for (const Point<int32_t>& point : points) {
+        corners.push_back({ (double)point.col, (double)point.row });
+    }
+    corners = MarkerDetector::refineCorners(img, corners, spacing);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        points[i] = { (int32_t)std::lround(corners[i].col), (int32_t)std::lround(corners[i].row) };
+    }
+}
+
+// Returns the thresholds to try, best guess first.
+static std::vector<uint8_t> thresholdCandidates(const image_t* src_basic, MarkerDetector::ThresholdSelection selection)
 {
     // Do multiple sweeps with different intervals to
     // try to get the least iterations possible.
-    const std::vector<uint8_t> thresholds = {
+    const std::vector<uint8_t> sweep = {
         180,
         185,
         190,
@@ -20,115 +143,328 @@ std::vector<Point<int32_t>> MarkerDetector::detectMarkers(const image_t* img)
         215,
         170
     };
+    if (selection == MarkerDetector::ThresholdSelection::SWEEP) {
+        return sweep;
+    }
 
-    std::vector<Point<int32_t>> points;
-    for (std::size_t step = 0; step < thresholds.size(); step++) {
-        uint8_t thresh = thresholds[step];
-        points = detectPoints(img, thresh);
-        if (points.size() == 3) {
-            Debug::println(std::string("Marker detector threshold: ") + std::to_string(thresh) + std::string(" after ") + std::to_string(step + 1) + std::string(" steps"));
-            return points;
+    std::vector<uint8_t> candidates;
+    auto add = [&candidates](uint32_t thresh) {
+        if (thresh <= 255 && std::find(candidates.begin(), candidates.end(), thresh) == candidates.end()) {
+            candidates.push_back(thresh);
         }
+    };
+    // The markers are bright, so they lie above the level. The thresholds select the pixels at or above them.
+    uint32_t hist[256];
+    histogram32(src_basic, hist);
+    uint8_t otsu = thresholdOtsuLevel(hist);
+    add(otsu + 1);
+    // On a dark background the first split lies between the background and the baseplate,
+    // splitting the bright part again separates the markers.
+    uint32_t bright[256] = { 0 };
+    std::copy(hist + otsu + 1, hist + 256, bright + otsu + 1);
+    add(thresholdOtsuLevel(bright) + 1);
+    add(threshold2MeansLevel(hist) + 1);
+    for (uint8_t thresh : sweep) {
+        add(thresh);
     }
-    return points;
+    return candidates;
 }
 
-std::vector<Point<int32_t>> MarkerDetector::detectPoints(const image_t* img, const uint8_t thresh_val)
+static MarkerDetector::Detection detectInOrder(const image_t* src_basic, const std::vector<uint8_t>& candidates, const DetectionScale& scale)
 {
+    MarkerDetector::Detection detection;
+    for (uint8_t thresh : candidates) {
+        detection.threshold = thresh;
+        detection.attempts++;
+        detection.evaluated++;
+        detection.points = detectPointsPrepared(src_basic, thresh, scale);
+        if (detection.points.size() == 3) {
+            break;
+        }
+    }
+    return detection;
+}
 
-    image_t* img_basic = newRGB888Image(img->cols, img->rows);
-    image_t* src_basic = newBasicImage(img->cols / 2, img->rows / 2);
-    copy(img, img_basic);
-    img_basic = toBasicImage(img_basic);
-    scaleImage(img_basic, src_basic);
-    image_t* dst_thresh = newBasicImage(src_basic->cols, src_basic->rows);
-    image_t* dst_scaled = newBasicImage((src_basic->cols) / 4, (src_basic->rows) / 4);
-    image_t* dst_harris = newBasicImage(dst_scaled->cols, dst_scaled->rows);
-    image_t* dst_eroded = newBasicImage(src_basic->cols, src_basic->rows);
+// The threads detectConcurrently runs on besides the calling thread. They are started the first time
+// they are needed and kept until the program ends, so a detection doesn't start threads and every worker
+// keeps its scratch memory from one frame to the next.
+class DetectionWorkers {
+public:
+    DetectionWorkers() = default;
+    DetectionWorkers(const DetectionWorkers&) = delete;
+    DetectionWorkers& operator=(const DetectionWorkers&) = delete;
 
-    threshold(src_basic, dst_thresh, thresh_val, 255, 1);
-    clear_center(dst_thresh);
-    invert(dst_thresh, dst_thresh, 1);
-    binaryErode(dst_thresh, dst_eroded, 8);
-    binaryErode(dst_eroded, dst_thresh, 8);
-    invert(dst_thresh, dst_thresh, 1);
-    binaryErode(dst_thresh, dst_eroded, 8);
-    scaleImage(dst_eroded, dst_scaled);
+    ~DetectionWorkers()
+    {
+        {
+            std::unique_lock<std::mutex> locker(mtx);
+            stopping = true;
+            condVar.notify_all();
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Runs work on the calling thread and on helpers of the workers at the same time,
+    // and returns when all of them have returned.
+    void run(uint32_t helpers, const std::function<void()>& work)
+    {
+        // One job at a time, so the workers of a job are never taken by another one
+        std::unique_lock<std::mutex> running(runMtx);
+        {
+            std::unique_lock<std::mutex> locker(mtx);
+            while (threads.size() < helpers) {
+                threads.emplace_back(&DetectionWorkers::workerThread, this, generation);
+            }
+            job = &work;
+            generation++;
+            waiting = helpers;
+            pending = helpers;
+            condVar.notify_all();
+        }
+        work();
+        std::unique_lock<std::mutex> locker(mtx);
+        condVar.wait(locker, [&]() { return pending == 0; });
+        job = nullptr;
+    }
 
-    Corner(dst_scaled, dst_harris, 2, 7, 0.04, 0);
+private:
+    void workerThread(uint64_t seen)
+    {
+        std::unique_lock<std::mutex> locker(mtx);
+        while (true) {
+            condVar.wait(locker, [&]() { return stopping || (waiting > 0 && generation != seen); });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            waiting--;
+            const std::function<void()>* current = job;
+            locker.unlock();
+            (*current)();
+            locker.lock();
+            if (--pending == 0) {
+                condVar.notify_all();
+            }
+        }
+    }
 
-    uint16_t c;
-    uint16_t r;
-    basic_pixel_t pixel;
-    std::vector<uint32_t> pos_x;
-    std::vector<uint32_t> pos_y;
-    uint8_t corners = 0;
+    std::mutex runMtx;
+    // Guards everything below
+    std::mutex mtx;
+    std::condition_variable condVar;
+    std::vector<std::thread> threads;
+    const std::function<void()>* job = nullptr;
+    // Counts the jobs, so a worker takes every job at most once
+    uint64_t generation = 0;
+    // Workers that still have to take the job, and workers that haven't finished it yet
+    uint32_t waiting = 0;
+    uint32_t pending = 0;
+    bool stopping = false;
+};
 
-    std::vector<Point<int32_t>> points;
+static DetectionWorkers& detectionWorkers()
+{
+    static DetectionWorkers workers;
+    return workers;
+}
 
-    for (c = 0; c < dst_harris->cols; c++) {
-        for (r = 0; r < dst_harris->rows; r++) {
-            pixel = getBasicPixel(dst_harris, c, r);
-            if (pixel == 0) {
-                pos_x.push_back(c * 8);
-                pos_y.push_back(r * 8);
-                corners++;
-                //Debug::println(std::string("Corner at (") + std::to_string(c) + std::string(", ") + std::to_string(r) + std::string(")"));
+static MarkerDetector::Detection detectConcurrently(const image_t* src_basic, const std::vector<uint8_t>& candidates, uint32_t workers, const DetectionScale& scale)
+{
+    const std::size_t count = candidates.size();
+    std::vector<std::vector<Point<int32_t>>> results(count);
+    std::atomic<std::size_t> next(0);
+    // The first candidate in list order that found the markers. Candidates after it are not started,
+    // candidates before it always run to the end, so the result is the same as in order.
+    std::atomic<std::size_t> first(count);
+    std::atomic<uint32_t> evaluated(0);
+    auto work = [&]() {
+        for (std::size_t i = next++; i < count && i < first; i = next++) {
+            results[i] = detectPointsPrepared(src_basic, candidates[i], scale);
+            evaluated++;
+            if (results[i].size() == 3) {
+                std::size_t current = first;
+                while (i < current && !first.compare_exchange_weak(current, i)) {
+                }
             }
         }
+    };
+    // The calling thread is one of the workers
+    detectionWorkers().run(std::min<std::size_t>(workers, count) - 1, work);
+
+    MarkerDetector::Detection detection;
+    std::size_t result = std::min<std::size_t>(first, count - 1);
+    detection.points = results[result];
+    detection.threshold = candidates[result];
+    detection.attempts = result + 1;
+    detection.evaluated = evaluated;
+    return detection;
+}
+
+MarkerDetector::Detection MarkerDetector::detect(const image_t* img, ThresholdSelection selection, uint32_t workers, double spacing)
+{
+    // The grayscale conversion is the same for every threshold.
+    const DetectionScale scale = detectionScale(img, spacing);
+    image_t* src_basic = prepareImage(img, scale);
+    std::vector<uint8_t> candidates = thresholdCandidates(src_basic, selection);
+    Detection detection = workers > 1 && candidates.size() > 1 ? detectConcurrently(src_basic, candidates, workers, scale) : detectInOrder(src_basic, candidates, scale);
+    if (detection.points.size() == 3) {
+        refineDetection(img, detection.points, detection.corners, spacing);
+        Debug::println(std::string("Marker detector threshold: ") + std::to_string(detection.threshold) + std::string(" after ") + std::to_string(detection.attempts) + std::string(" steps"));
     }
-    Point<int32_t> point0;
-    Point<int32_t> point1;
-    Point<int32_t> point2;
-    //sort points by size if we have 3 points
-    if (corners == 3) {
-        point0.col = pos_x[0];
-        point0.row = pos_y[0];
-        point1.col = pos_x[1];
-        point1.row = pos_y[1];
-        point2.col = pos_x[2];
-        point2.row = pos_y[2];
-
-        if ((point0.col + point0.row) > (point1.col + point1.row)) {
-            std::swap(point0, point1);
-        }
-        if ((point1.col + point1.row) > (point2.col + point2.row)) {
-            std::swap(point1, point2);
+    deleteImage(src_basic);
+    return detection;
+}
+
+std::vector<Point<int32_t>> MarkerDetector::detectMarkers(const image_t* img)
+{
+    return detect(img).points;
+}
+
+std::vector<Point<int32_t>> MarkerDetector::detectPoints(const image_t* img, const uint8_t thresh_val, double spacing)
+{
+    const DetectionScale scale = detectionScale(img, spacing);
+    image_t* src_basic = prepareImage(img, scale);
+    std::vector<Point<int32_t>> points = detectPointsPrepared(src_basic, thresh_val, scale);
+    deleteImage(src_basic);
+    std::vector<Point<double>> corners;
+    refineDetection(img, points, corners, spacing);
+    return points;
+}
+
+std::vector<Point<double>> MarkerDetector::refineCorners(const image_t* img, const std::vector<Point<double>>& corners, double spacing)
+{
+    // Every gradient in the window is perpendicular to the vector from the corner to its pixel, because the
+    // gradients lie on the two edges that meet in the corner. The corner is the least squares solution of
+    // sum(g * g^T) * corner = sum(g * g^T * p), solved again around the new corner until it stops moving.
+    const int32_t radius = std::max((int32_t)std::lround(MARKER_REFINE_RADIUS * spacingIn(img, spacing)), 2);
+    std::vector<Point<double>> refined;
+    for (const Point<double>& corner : corners) {
+        Point<double> current = corner;
+        for (int32_t iteration = 0; iteration < MARKER_REFINE_ITERATIONS; iteration++) {
+            const int32_t centerCol = (int32_t)std::lround(current.col);
+            const int32_t centerRow = (int32_t)std::lround(current.row);
+            double gxx = 0.0, gxy = 0.0, gyy = 0.0, bcol = 0.0, brow = 0.0;
+            for (int32_t row = std::max(centerRow - radius, 1); row <= std::min(centerRow + radius, img->rows - 2); row++) {
+                for (int32_t col = std::max(centerCol - radius, 1); col <= std::min(centerCol + radius, img->cols - 2); col++) {
+                    const double gx = grayAt(img, col + 1, row) - grayAt(img, col - 1, row);
+                    const double gy = grayAt(img, col, row + 1) - grayAt(img, col, row - 1);
+                    gxx += gx * gx;
+                    gxy += gx * gy;
+                    gyy += gy * gy;
+                    bcol += gx * gx * col + gx * gy * row;
+                    brow += gx * gy * col + gy * gy * row;
+                }
+            }
+            // A single edge or a flat window has no corner to move to.
+            const double det = gxx * gyy - gxy * gxy;
+            if (det <= 1e-6 * (gxx + gyy) * (gxx + gyy)) {
+                break;
+            }
+            const Point<double> next = { (gyy * bcol - gxy * brow) / det, (gxx * brow - gxy * bcol) / det };
+            const Point<double> step = next - current;
+            current = next;
+            if (std::hypot(step.col, step.row) < MARKER_REFINE_EPSILON) {
+                break;
+            }
         }
-        if ((point0.col + point0.row) > (point1.col + point1.row)) {
-            std::swap(point0, point1);
+        // The window moves along with the corner, but a corner that ends up further than another window
+        // away found another corner, or none.
+        if (std::hypot(current.col - corner.col, current.row - corner.row) > 2 * radius) {
+            current = corner;
         }
+        refined.push_back(current);
+    }
+    return refined;
+}
+
+// Whether the corners, in the order of detectMarkers, lie like the markers: at the distances of the
+// baseplate, with the right-top corner where both sides meet at a right angle.
+static bool markerLayout(const corner_t corners[3], const DetectionScale& scale)
+{
+    auto distance = [&scale](const corner_t& a, const corner_t& b) {
+        return std::hypot((double)(a.col - b.col), (double)(a.row - b.row)) * scale.gray * scale.corner;
+    };
+    const double top = distance(corners[0], corners[1]);
+    const double right = distance(corners[1], corners[2]);
+    const double diagonal = distance(corners[0], corners[2]);
+    const double min = MARKER_MIN_SPACING * scale.spacing;
+    const double max = MARKER_MAX_SPACING * scale.spacing;
+    if (top <= min || top >= max || right <= min || right >= max) {
+        return false;
+    }
+    if (std::abs(top - right) > MARKER_SIDE_TOLERANCE * std::max(top, right)
+        || std::abs(diagonal / ((top + right) / 2) - std::sqrt(2.0)) > MARKER_SIDE_TOLERANCE) {
+        return false;
+    }
+    // Clockwise
+    int64_t cross = (int64_t)(corners[1].col - corners[0].col) * (corners[2].row - corners[0].row)
+        - (int64_t)(corners[1].row - corners[0].row) * (corners[2].col - corners[0].col);
+    return cross > 0;
+}
+
+// Whether the corner image holds a marker on the side of the corner the direction points to, and nothing
+// on the other three sides, like at the sharp corner of a marker.
+static bool markerBesideCorner(const image_t* img, const corner_t& corner, const int32_t direction[2])
+{
+    auto marker = [img](int32_t col, int32_t row) {
+        return col >= 0 && col < img->cols && row >= 0 && row < img->rows && getBasicPixel(img, col, row) != 0;
+    };
+    const int32_t dcol = direction[0] * MARKER_SIDE_OFFSET;
+    const int32_t drow = direction[1] * MARKER_SIDE_OFFSET;
+    return marker(corner.col + dcol, corner.row + drow) && !marker(corner.col - dcol, corner.row - drow)
+        && !marker(corner.col + dcol, corner.row - drow) && !marker(corner.col - dcol, corner.row + drow);
+}
 
-        //Check distance between points are correct distance
-        int distance_x;
-        int distance_y;
-        double distance_01;
-        double distance_12;
-        double distance_02;
-
-        distance_x = (point1.col - point0.col) * (point1.col - point0.col);
-        distance_y = (point1.row - point0.row) * (point1.row - point0.row);
-        distance_01 = sqrt(distance_x + distance_y);
-
-        distance_x = (point2.col - point1.col) * (point2.col - point1.col);
-        distance_y = (point2.row - point1.row) * (point2.row - point1.row);
-        distance_12 = sqrt(distance_x + distance_y);
-
-        distance_x = (point2.col - point0.col) * (point2.col - point0.col);
-        distance_y = (point2.row - point0.row) * (point2.row - point0.row);
-        distance_02 = sqrt(distance_x + distance_y);
-
-        if (distance_01 > 500 && distance_01 < 1100 && distance_12 > 500 && distance_12 < 1100 && distance_02 > 700 && distance_02 < 1300) {
-            points.push_back(point0);
-            points.push_back(point1);
-            points.push_back(point2);
+static std::vector<Point<int32_t>> detectPointsPrepared(const image_t* src_basic, const uint8_t thresh_val, const DetectionScale& scale)
+{
+    image_t* dst_thresh = newBinaryImage(src_basic->cols, src_basic->rows);
+    image_t* dst_scaled = newBasicImage(src_basic->cols / scale.corner, src_basic->rows / scale.corner);
+
+    // The markers are 1 in the packed image. Eroding removes bright spots smaller than the markers,
+    // dilating grows the markers back by about half of that.
+    threshold(src_basic, dst_thresh, thresh_val, 255, 1);
+    clear_center(dst_thresh);
+    invert(dst_thresh, dst_thresh, 1);
+    binaryErode(dst_thresh, dst_thresh, scale.erode, binaryScratch(dst_thresh));
+    binaryDilate(dst_thresh, dst_thresh, scale.dilate, binaryScratch(dst_thresh));
+    scaleImage(dst_thresh, dst_scaled);
+
+    corner_t candidates[MARKER_CORNER_CANDIDATES];
+    uint32_t found = cornerResponse(dst_scaled, cornerScratch(dst_scaled), CORNER_HARRIS, 7, 0.04f, MARKER_CORNER_SEPARATION, candidates, MARKER_CORNER_CANDIDATES);
+
+    // Of every three candidates that lie like the markers, the three whose weakest corner is the strongest win.
+    // Stronger corners elsewhere in the frame don't make the threshold fail, as long as the markers are among the candidates.
+    std::vector<Point<int32_t>> points;
+    int64_t best = 0;
+    for (uint32_t i = 0; i < found; i++) {
+        for (uint32_t j = i + 1; j < found; j++) {
+            for (uint32_t k = j + 1; k < found; k++) {
+                corner_t corners[3] = { candidates[i], candidates[j], candidates[k] };
+                // Left-top, right-top, right-bottom
+                std::sort(corners, corners + 3, [](const corner_t& a, const corner_t& b) { return a.col + a.row < b.col + b.row; });
+                int64_t weakest = std::min({ corners[0].response, corners[1].response, corners[2].response });
+                if (weakest <= best || !markerLayout(corners, scale)) {
+                    continue;
+                }
+                bool beside = true;
+                for (std::size_t n = 0; n < 3; n++) {
+                    beside = beside && markerBesideCorner(dst_scaled, corners[n], MarkerDetector::MARKER_DIRECTIONS[n]);
+                }
+                if (!beside) {
+                    continue;
+                }
+                best = weakest;
+                points.clear();
+                for (const corner_t& corner : corners) {
+                    points.push_back({ corner.col * scale.corner * scale.gray, corner.row * scale.corner * scale.gray });
+                }
+            }
         }
     }
-    deleteImage(dst_eroded);
     deleteImage(dst_thresh);
-    deleteImage(src_basic);
     deleteImage(dst_scaled);
-    deleteImage(dst_harris);
     return points;
 }
 
@@ -0,0 +1,246 @@
+#include "MarkerTracker.hpp"
+#include "MarkerDetector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace cpparas {
+
+// A window without this much difference between its mean and its brightest pixel holds no marker.
+static const int32_t MARKER_MIN_CONTRAST = 24;
+// A corner needs marker pixels this far into the marker, so a single bright pixel is no corner.
+static const int32_t MARKER_CORNER_DEPTH = 3;
+// The square next to a sharp corner that lies within the marker, in full resolution pixels.
+static const int32_t MARKER_CORNER_SIZE = 24;
+// The confidence drops to 0 when a distance between the markers changes by this fraction.
+static const double MARKER_MAX_SIDE_DEVIATION = 0.1;
+
+static uint8_t grayAt(const image_t* img, int32_t col, int32_t row)
+{
+    if (img->type == IMGTYPE_BASIC) {
+        return getBasicPixel(img, col, row);
+    }
+    rgb888_pixel_t pixel = getRGB888Pixel(img, col, row);
+    return (pixel.r + 2 * pixel.g + pixel.b) / 4;
+}
+
+static std::vector<double> sideLengths(const std::vector<Point<int32_t>>& corners)
+{
+    auto distance = [](const Point<int32_t>& a, const Point<int32_t>& b) {
+        return std::hypot((double)(a.col - b.col), (double)(a.row - b.row));
+    };
+    return { distance(corners[0], corners[1]), distance(corners[1], corners[2]), distance(corners[0], corners[2]) };
+}
+
+std::string TrackingStatistics::summary() const
+{
+    std::ostringstream text;
+    text.precision(2);
+    text << std::fixed << "Markers tracked " << trackedFrames << ", full searches " << fullSearches << " (found " << foundSearches
+         << ", thresholds tried " << detectionAttempts << "), lost " << lostTracks << ", confidence " << confidence;
+    return text.str();
+}
+
+MarkerTracker::MarkerTracker(int32_t windowRadius_, double minConfidence_)
+    : windowRadius(windowRadius_)
+    , minConfidence(minConfidence_)
+    , tracking(false)
+{
+}
+
+std::vector<Point<int32_t>> MarkerTracker::update(const image_t* img, const Point<int32_t>& origin, double spacing)
+{
+    if (tracking) {
+        std::vector<Window> windows;
+        double confidence = findCorners(img, origin, corners, windows) ? confidenceOf(windows) : 0.0;
+        std::lock_guard<std::mutex> locker(statisticsMtx);
+        statistics.confidence = confidence;
+        if (confidence >= minConfidence) {
+            for (std::size_t i = 0; i < windows.size(); i++) {
+                corners[i] = windows[i].corner;
+            }
+            statistics.trackedFrames++;
+            return corners;
+        }
+        tracking = false;
+        statistics.lostTracks++;
+    }
+    return search(img, origin, spacing);
+}
+
+void MarkerTracker::reset()
+{
+    tracking = false;
+    corners.clear();
+}
+
+bool MarkerTracker::isTracking() const
+{
+    return tracking;
+}
+
+double MarkerTracker::getConfidence() const
+{
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    return statistics.confidence;
+}
+
+TrackingStatistics MarkerTracker::getStatistics() const
+{
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    return statistics;
+}
+
+void MarkerTracker::resetStatistics()
+{
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    statistics = TrackingStatistics();
+}
+
+std::vector<Point<int32_t>> MarkerTracker::search(const image_t* img, const Point<int32_t>& origin, double spacing)
+{
+    // Searched frames are in full resolution pixels, so the spacing holds for the image as it is
+    MarkerDetector::Detection detection = MarkerDetector::detect(img, MarkerDetector::ThresholdSelection::HISTOGRAM, MarkerDetector::MARKER_DETECTION_WORKERS, spacing);
+    std::vector<Point<int32_t>> detected = detection.points;
+    for (Point<int32_t>& point : detected) {
+        point = point + origin;
+    }
+    std::lock_guard<std::mutex> locker(statisticsMtx);
+    statistics.fullSearches++;
+    statistics.detectionAttempts += detection.attempts;
+    if (detected.size() != 3) {
+        return detected;
+    }
+    statistics.foundSearches++;
+
+    // The windows tell whether the detected corners are sharp and lie within the frame, and give the
+    // corners the tracking continues from.
+    std::vector<Window> windows;
+    if (!findCorners(img, origin, detected, windows)) {
+        return detected;
+    }
+    for (const Window& window : windows) {
+        if (window.clipped) {
+            return detected;
+        }
+    }
+    corners.clear();
+    for (const Window& window : windows) {
+        corners.push_back(window.corner);
+    }
+    referenceSides = sideLengths(corners);
+    tracking = true;
+    statistics.confidence = 1.0;
+    return corners;
+}
+
+bool MarkerTracker::findCorners(const image_t* img, const Point<int32_t>& origin, const std::vector<Point<int32_t>>& around, std::vector<Window>& windows) const
+{
+    windows.resize(around.size());
+    for (std::size_t i = 0; i < around.size(); i++) {
+        if (!findCorner(img, around[i] - origin, i, windows[i])) {
+            return false;
+        }
+        windows[i].corner = windows[i].corner + origin;
+    }
+    return true;
+}
+
+bool MarkerTracker::findCorner(const image_t* img, const Point<int32_t>& around, std::size_t index, Window& window) const
+{
+    const int32_t left = std::max(around.col - windowRadius, 0);
+    const int32_t top = std::max(around.row - windowRadius, 0);
+    const int32_t right = std::min(around.col + windowRadius, (int32_t)img->cols);
+    const int32_t bottom = std::min(around.row + windowRadius, (int32_t)img->rows);
+    const int32_t cols = right - left;
+    const int32_t rows = bottom - top;
+    if (cols <= MARKER_CORNER_DEPTH || rows <= MARKER_CORNER_DEPTH) {
+        return false;
+    }
+
+    // The markers are the brightest part of the window, so the threshold lies between its mean and its maximum.
+    std::vector<uint8_t> gray(cols * rows);
+    uint32_t sum = 0;
+    uint8_t max = 0;
+    for (int32_t row = 0; row < rows; row++) {
+        for (int32_t col = 0; col < cols; col++) {
+            uint8_t value = grayAt(img, left + col, top + row);
+            gray[row * cols + col] = value;
+            sum += value;
+            max = std::max(max, value);
+        }
+    }
+    const int32_t mean = sum / (cols * rows);
+    if (max - mean < MARKER_MIN_CONTRAST) {
+        return false;
+    }
+    const uint8_t threshold = (mean + max + 1) / 2;
+
+    // The sharp corner is the marker pixel that lies furthest out, away from the marker.
+    const int32_t dcol = MarkerDetector::MARKER_DIRECTIONS[index][0];
+    const int32_t drow = MarkerDetector::MARKER_DIRECTIONS[index][1];
+    const int32_t depthCol = dcol * MARKER_CORNER_DEPTH;
+    const int32_t depthRow = drow * MARKER_CORNER_DEPTH;
+    auto marker = [&](int32_t col, int32_t row) {
+        return col >= 0 && col < cols && row >= 0 && row < rows && gray[row * cols + col] >= threshold;
+    };
+    int32_t best = std::numeric_limits<int32_t>::max();
+    for (int32_t row = 0; row < rows; row++) {
+        for (int32_t col = 0; col < cols; col++) {
+            if (gray[row * cols + col] < threshold) {
+                continue;
+            }
+            int32_t outward = dcol * col + drow * row;
+            if (outward < best && marker(col + depthCol, row) && marker(col, row + depthRow) && marker(col + depthCol, row + depthRow)) {
+                best = outward;
+                window.corner = { left + col, top + row };
+            }
+        }
+    }
+    if (best == std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+    // A marker that reaches the outer edge of the window may lie partly outside of it.
+    int32_t outerCol = dcol > 0 ? left : right - 1;
+    int32_t outerRow = drow > 0 ? top : bottom - 1;
+    window.clipped = window.corner.col == outerCol || window.corner.row == outerRow;
+
+    // A sharp corner fills the square next to it, a rounded corner or a partly covered marker does not.
+    uint32_t filled = 0;
+    uint32_t total = 0;
+    for (int32_t r = 0; r < MARKER_CORNER_SIZE; r++) {
+        for (int32_t c = 0; c < MARKER_CORNER_SIZE; c++) {
+            int32_t col = window.corner.col + dcol * c;
+            int32_t row = window.corner.row + drow * r;
+            if (col >= 0 && col < (int32_t)img->cols && row >= 0 && row < (int32_t)img->rows && grayAt(img, col, row) >= threshold) {
+                filled++;
+            }
+            total++;
+        }
+    }
+    window.fill = (double)filled / total;
+    return true;
+}
+
+double MarkerTracker::confidenceOf(const std::vector<Window>& windows) const
+{
+    // Every corner needs to be sharp, and the markers need to keep their distances.
+    double confidence = 1.0;
+    std::vector<Point<int32_t>> found;
+    for (const Window& window : windows) {
+        if (window.clipped) {
+            return 0.0;
+        }
+        confidence = std::min(confidence, window.fill);
+        found.push_back(window.corner);
+    }
+    std::vector<double> sides = sideLengths(found);
+    for (std::size_t i = 0; i < sides.size(); i++) {
+        double deviation = std::abs(sides[i] - referenceSides[i]) / std::max(referenceSides[i], 1.0);
+        confidence = std::min(confidence, std::max(1.0 - deviation / MARKER_MAX_SIDE_DEVIATION, 0.0));
+    }
+    return confidence;
+}
+
+} // namespace cpparas
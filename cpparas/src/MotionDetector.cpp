@@ -0,0 +1,146 @@
+#include "MotionDetector.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace cpparas {
+
+// Higher than the score of any tile, for references that can't be compared
+static const double MOTION_SCORE_UNKNOWN = 256.0;
+
+static uint8_t grayAt(const image_t* img, int32_t col, int32_t row)
+{
+    if (img->type == IMGTYPE_BASIC) {
+        return getBasicPixel(img, col, row);
+    }
+    rgb888_pixel_t pixel = getRGB888Pixel(img, col, row);
+    return (pixel.r + 2 * pixel.g + pixel.b) / 4;
+}
+
+MotionDetector::MotionDetector(uint32_t cols_, uint32_t rows_, uint32_t tileSize_, double threshold_)
+    : cols(cols_)
+    , rows(rows_)
+    , tileSize(std::max(tileSize_, 1u))
+    , threshold(threshold_)
+    , current(cols_ * rows_, 0)
+    , fieldOfView({ { 0, 0 }, 0, 0 })
+{
+}
+
+std::size_t MotionDetector::addReference()
+{
+    Reference reference;
+    reference.pixels.assign(cols * rows, 0);
+    reference.fieldOfView = { { 0, 0 }, 0, 0 };
+    reference.valid = false;
+    references.push_back(reference);
+    return references.size() - 1;
+}
+
+void MotionDetector::update(const image_t* img, const Rect<int32_t>& fieldOfView_)
+{
+    fieldOfView = fieldOfView_;
+    // Every gray pixel is the mean of four samples of its block, which is enough to smooth out sensor noise.
+    for (uint32_t row = 0; row < rows; row++) {
+        int32_t top = row * img->rows / rows;
+        int32_t height = (row + 1) * img->rows / rows - top;
+        int32_t rowSamples[2] = { top + height / 4, top + height * 3 / 4 };
+        for (uint32_t col = 0; col < cols; col++) {
+            int32_t left = col * img->cols / cols;
+            int32_t width = (col + 1) * img->cols / cols - left;
+            int32_t colSamples[2] = { left + width / 4, left + width * 3 / 4 };
+            uint32_t sum = 0;
+            for (int32_t sampleRow : rowSamples) {
+                for (int32_t sampleCol : colSamples) {
+                    sum += grayAt(img, sampleCol, sampleRow);
+                }
+            }
+            current[row * cols + col] = (sum + 2) / 4;
+        }
+    }
+}
+
+bool MotionDetector::changed(std::size_t reference, const Rect<int32_t>& region) const
+{
+    return score(reference, region) > threshold;
+}
+
+double MotionDetector::score(std::size_t reference, const Rect<int32_t>& region) const
+{
+    const Reference& ref = references.at(reference);
+    if (!comparable(ref)) {
+        return MOTION_SCORE_UNKNOWN;
+    }
+    const uint32_t tileCols = getTileCols();
+    const uint32_t tileRows = getTileRows();
+    int32_t firstCol = 0;
+    int32_t firstRow = 0;
+    int32_t lastCol = tileCols - 1;
+    int32_t lastRow = tileRows - 1;
+    if (region.width > 0 && region.height > 0) {
+        // From full resolution pixels to gray pixels to tiles
+        auto tileCol = [&](int32_t col) { return (int32_t)((int64_t)(col - fieldOfView.origin.col) * (int32_t)cols / fieldOfView.width) / (int32_t)tileSize; };
+        auto tileRow = [&](int32_t row) { return (int32_t)((int64_t)(row - fieldOfView.origin.row) * (int32_t)rows / fieldOfView.height) / (int32_t)tileSize; };
+        firstCol = std::max(tileCol(region.origin.col), firstCol);
+        firstRow = std::max(tileRow(region.origin.row), firstRow);
+        lastCol = std::min(tileCol(region.origin.col + region.width - 1), lastCol);
+        lastRow = std::min(tileRow(region.origin.row + region.height - 1), lastRow);
+    }
+    double highest = 0.0;
+    for (int32_t row = firstRow; row <= lastRow; row++) {
+        for (int32_t col = firstCol; col <= lastCol; col++) {
+            highest = std::max(highest, tileScore(ref, col, row));
+        }
+    }
+    return highest;
+}
+
+void MotionDetector::accept(std::size_t reference)
+{
+    Reference& ref = references.at(reference);
+    ref.pixels = current;
+    ref.fieldOfView = fieldOfView;
+    ref.valid = fieldOfView.width > 0 && fieldOfView.height > 0;
+}
+
+std::vector<double> MotionDetector::tileScores(std::size_t reference) const
+{
+    const Reference& ref = references.at(reference);
+    std::vector<double> scores;
+    for (uint32_t row = 0; row < getTileRows(); row++) {
+        for (uint32_t col = 0; col < getTileCols(); col++) {
+            scores.push_back(comparable(ref) ? tileScore(ref, col, row) : MOTION_SCORE_UNKNOWN);
+        }
+    }
+    return scores;
+}
+
+uint32_t MotionDetector::getTileCols() const
+{
+    return (cols + tileSize - 1) / tileSize;
+}
+
+uint32_t MotionDetector::getTileRows() const
+{
+    return (rows + tileSize - 1) / tileSize;
+}
+
+double MotionDetector::tileScore(const Reference& reference, uint32_t tileCol, uint32_t tileRow) const
+{
+    uint32_t sum = 0;
+    uint32_t count = 0;
+    for (uint32_t row = tileRow * tileSize; row < std::min((tileRow + 1) * tileSize, rows); row++) {
+        for (uint32_t col = tileCol * tileSize; col < std::min((tileCol + 1) * tileSize, cols); col++) {
+            sum += std::abs(current[row * cols + col] - reference.pixels[row * cols + col]);
+            count++;
+        }
+    }
+    return count == 0 ? 0.0 : (double)sum / count;
+}
+
+bool MotionDetector::comparable(const Reference& reference) const
+{
+    return reference.valid && reference.fieldOfView.origin.col == fieldOfView.origin.col && reference.fieldOfView.origin.row == fieldOfView.origin.row
+        && reference.fieldOfView.width == fieldOfView.width && reference.fieldOfView.height == fieldOfView.height;
+}
+
+} // namespace cpparas
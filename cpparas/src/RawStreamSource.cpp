@@ -0,0 +1,86 @@
+#include "RawStreamSource.hpp"
+#include "debug/Debug.hpp"
+#include <algorithm>
+
+namespace cpparas {
+
+RawStreamSource::RawStreamSource(const std::string& filePath_, uint32_t cols_, uint32_t rows_, double frameRate, bool loop_, FrameFormat format)
+    : FrameSource(frameRate, format)
+    , filePath(filePath_)
+    , cols(cols_)
+    , rows(rows_)
+    , loop(loop_)
+    , streamFormat(format)
+    , file(NULL)
+{
+}
+
+RawStreamSource::~RawStreamSource()
+{
+    stop();
+}
+
+bool RawStreamSource::formatOfFile(const std::string& filePath, FrameFormat& format)
+{
+    std::size_t dot = filePath.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = filePath.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == "rgb") {
+        format = FrameFormat::RGB888;
+    } else if (extension == "yuv") {
+        format = FrameFormat::YUV420;
+    } else if (extension == "gray") {
+        format = FrameFormat::GRAY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool RawStreamSource::open()
+{
+    file = fopen(filePath.c_str(), "rb");
+    if (file == NULL) {
+        Debug::println(std::string("Failed to open raw stream ") + filePath);
+        return false;
+    }
+    setFrameSize(cols, rows);
+    return true;
+}
+
+bool RawStreamSource::readFrame(image_t* dst)
+{
+    size_t frameSize = (size_t)cols * rows;
+    if (streamFormat == FrameFormat::RGB888) {
+        frameSize *= 3;
+    } else if (streamFormat == FrameFormat::YUV420) {
+        frameSize = frameSize * 3 / 2;
+    }
+    size_t readBytes = fread(dst->data, 1, frameSize, file);
+    if (readBytes == frameSize) {
+        return true;
+    }
+    // A partial frame at the end of the file is skipped.
+    if (!loop) {
+        return false;
+    }
+    rewind(file);
+    readBytes = fread(dst->data, 1, frameSize, file);
+    return readBytes == frameSize;
+}
+
+void RawStreamSource::close()
+{
+    fclose(file);
+    file = NULL;
+}
+
+FrameFormat RawStreamSource::nativeFormat() const
+{
+    return streamFormat;
+}
+
+} // namespace cpparas
@@ -1,8 +1,62 @@
 #include "RegionExtractor.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace cpparas {
 
+// Newton steps to solve the fourth corner, it converges in a few when the perspective is slight.
+static const int32_t FOURTH_CORNER_ITERATIONS = 20;
+// The perspective is solved when the sides of the baseplate are this close to square and equally long.
+static const double FOURTH_CORNER_TOLERANCE = 1e-9;
+// A fourth corner further than this fraction of a side from the parallelogram is no slight perspective, but noise.
+static const double FOURTH_CORNER_MAX_SHIFT = 0.25;
+
+// Maps the unit square onto the corners (Heckbert), so H * (u, v, 1) is the corner at (u, v) in homogeneous coordinates.
+static bool squareToQuad(const double col[4], const double row[4], double H[3][3])
+{
+    const double sumCol = col[0] - col[1] + col[2] - col[3];
+    const double sumRow = row[0] - row[1] + row[2] - row[3];
+    const double det = (col[1] - col[2]) * (row[3] - row[2]) - (col[3] - col[2]) * (row[1] - row[2]);
+    if (det == 0.0) {
+        return false;
+    }
+    const double g = (sumCol * (row[3] - row[2]) - (col[3] - col[2]) * sumRow) / det;
+    const double h = ((col[1] - col[2]) * sumRow - sumCol * (row[1] - row[2])) / det;
+    H[0][0] = col[1] - col[0] + g * col[1];
+    H[0][1] = col[3] - col[0] + h * col[3];
+    H[0][2] = col[0];
+    H[1][0] = row[1] - row[0] + g * row[1];
+    H[1][1] = row[3] - row[0] + h * row[3];
+    H[1][2] = row[0];
+    H[2][0] = g;
+    H[2][1] = h;
+    H[2][2] = 1.0;
+    return true;
+}
+
+// How far the baseplate seen through the corners is from a square, in rays of the camera (col and row divided by the focal length).
+// The columns of the homography are the sides of the baseplate in camera space, which are perpendicular and equally long.
+static bool squareError(const double col[4], const double row[4], double error[2])
+{
+    double H[3][3];
+    if (!squareToQuad(col, row, H)) {
+        return false;
+    }
+    const double side1 = H[0][0] * H[0][0] + H[1][0] * H[1][0] + H[2][0] * H[2][0];
+    const double side2 = H[0][1] * H[0][1] + H[1][1] * H[1][1] + H[2][1] * H[2][1];
+    const double dot = H[0][0] * H[0][1] + H[1][0] * H[1][1] + H[2][0] * H[2][1];
+    error[0] = dot / std::sqrt(side1 * side2);
+    error[1] = (side1 - side2) / (side1 + side2);
+    return true;
+}
+
 RegionExtractor::RegionExtractor(int32_t cols, int32_t rows)
+    : warpTable(nullptr)
+    , warpTableBuilds(0)
+    , focalLength(0.0)
+    , principalPoint({ 0.0, 0.0 })
+    , studCols(0)
+    , studRows(0)
 {
     regionImage = newRGB888Image(cols, rows);
     erase(regionImage);
@@ -10,6 +64,7 @@ RegionExtractor::RegionExtractor(int32_t cols, int32_t rows)
 
 RegionExtractor::~RegionExtractor()
 {
+    deleteWarpTable(warpTable);
     deleteImage(regionImage);
 }
 
@@ -18,25 +73,205 @@ image_t* RegionExtractor::getRegionImage()
     return regionImage;
 }
 
-std::vector<Point<int32_t>> RegionExtractor::updateImage(const image_t* img)
+std::vector<Point<int32_t>> RegionExtractor::updateImage(const image_t* img, const image_t* chromaU, const image_t* chromaV)
 {
-    std::vector<Point<int32_t>> corners = MarkerDetector::detectMarkers(img);
+    std::vector<Point<int32_t>> corners = locateMarkers(img);
     if (corners.size() < 3) {
         return corners;
     } else {
-        int32_t colpos[3] = {
-            corners[0].col,
-            corners[1].col,
-            corners[2].col,
-        };
-        int32_t rowpos[3] = {
-            corners[0].row,
-            corners[1].row,
-            corners[2].row
-        };
-        warp(img, regionImage, colpos, rowpos);
+        extractRegion(img, chromaU, chromaV, completeCorners(corners));
+        return corners;
+    }
+}
+
+std::vector<Point<int32_t>> RegionExtractor::locateMarkers(const image_t* img, const Point<int32_t>& origin, double spacing)
+{
+    return tracker.update(img, origin, spacing);
+}
+
+void RegionExtractor::resetTracking()
+{
+    tracker.reset();
+}
+
+TrackingStatistics RegionExtractor::getTrackingStatistics() const
+{
+    return tracker.getStatistics();
+}
+
+void RegionExtractor::setCamera(double focalLength_, const Point<double>& principalPoint_)
+{
+    focalLength = focalLength_;
+    principalPoint = principalPoint_;
+}
+
+std::vector<Point<int32_t>> RegionExtractor::completeCorners(const std::vector<Point<int32_t>>& corners) const
+{
+    std::vector<Point<int32_t>> completed(corners.begin(), corners.begin() + 3);
+    const Point<int32_t> parallelogram = { corners[0].col + corners[2].col - corners[1].col, corners[0].row + corners[2].row - corners[1].row };
+    completed.push_back(parallelogram);
+    if (focalLength <= 0.0) {
+        return completed;
+    }
+
+    // Newton's method on the fourth corner, from the parallelogram, until the baseplate is a square in camera space.
+    double col[4];
+    double row[4];
+    for (std::size_t i = 0; i < 4; i++) {
+        col[i] = (completed[i].col - principalPoint.col) / focalLength;
+        row[i] = (completed[i].row - principalPoint.row) / focalLength;
+    }
+    const double step = 1e-6;
+    double error[2];
+    for (int32_t iteration = 0; iteration < FOURTH_CORNER_ITERATIONS; iteration++) {
+        if (!squareError(col, row, error)) {
+            return completed;
+        }
+        if (std::abs(error[0]) < FOURTH_CORNER_TOLERANCE && std::abs(error[1]) < FOURTH_CORNER_TOLERANCE) {
+            break;
+        }
+        double errorCol[2];
+        double errorRow[2];
+        col[3] += step;
+        bool solvable = squareError(col, row, errorCol);
+        col[3] -= step;
+        row[3] += step;
+        solvable = solvable && squareError(col, row, errorRow);
+        row[3] -= step;
+        const double j00 = (errorCol[0] - error[0]) / step;
+        const double j10 = (errorCol[1] - error[1]) / step;
+        const double j01 = (errorRow[0] - error[0]) / step;
+        const double j11 = (errorRow[1] - error[1]) / step;
+        const double det = j00 * j11 - j01 * j10;
+        if (!solvable || det == 0.0) {
+            return completed;
+        }
+        col[3] -= (j11 * error[0] - j01 * error[1]) / det;
+        row[3] -= (j00 * error[1] - j10 * error[0]) / det;
+    }
+    if (std::abs(error[0]) >= FOURTH_CORNER_TOLERANCE || std::abs(error[1]) >= FOURTH_CORNER_TOLERANCE) {
+        return completed;
+    }
+
+    const Point<int32_t> fourth = { (int32_t)std::lround(col[3] * focalLength + principalPoint.col), (int32_t)std::lround(row[3] * focalLength + principalPoint.row) };
+    const double side = std::hypot((double)(corners[1].col - corners[0].col), (double)(corners[1].row - corners[0].row));
+    if (std::hypot((double)(fourth.col - parallelogram.col), (double)(fourth.row - parallelogram.row)) > FOURTH_CORNER_MAX_SHIFT * side) {
+        return completed;
+    }
+    completed[3] = fourth;
+    return completed;
+}
+
+void RegionExtractor::setBaseplate(uint32_t studCols_, uint32_t studRows_)
+{
+    studCols = studCols_;
+    studRows = studRows_;
+}
+
+std::vector<Point<int32_t>> RegionExtractor::studCorners(const std::vector<Point<int32_t>>& corners) const
+{
+    if (studCols == 0 || studRows == 0 || corners.size() < 3) {
+        return corners;
+    }
+    // Three corners are a parallelogram, four follow the perspective of the baseplate.
+    double col[4];
+    double row[4];
+    for (std::size_t i = 0; i < 3; i++) {
+        col[i] = corners[i].col;
+        row[i] = corners[i].row;
+    }
+    col[3] = corners.size() > 3 ? corners[3].col : corners[0].col + corners[2].col - corners[1].col;
+    row[3] = corners.size() > 3 ? corners[3].row : corners[0].row + corners[2].row - corners[1].row;
+    double H[3][3];
+    if (!squareToQuad(col, row, H)) {
         return corners;
     }
+
+    const double insetCol = 0.5 / studCols;
+    const double insetRow = 0.5 / studRows;
+    const double u[4] = { insetCol, 1.0 - insetCol, 1.0 - insetCol, insetCol };
+    const double v[4] = { insetRow, insetRow, 1.0 - insetRow, 1.0 - insetRow };
+    std::vector<Point<int32_t>> studs;
+    for (std::size_t i = 0; i < std::min<std::size_t>(corners.size(), 4); i++) {
+        const double w = H[2][0] * u[i] + H[2][1] * v[i] + H[2][2];
+        studs.push_back({ (int32_t)std::lround((H[0][0] * u[i] + H[0][1] * v[i] + H[0][2]) / w),
+            (int32_t)std::lround((H[1][0] * u[i] + H[1][1] * v[i] + H[1][2]) / w) });
+    }
+    return studs;
+}
+
+void RegionExtractor::extractRegion(const image_t* img, const image_t* chromaU, const image_t* chromaV, const std::vector<Point<int32_t>>& corners)
+{
+    extractRegion(img, chromaU, chromaV, corners, regionImage);
+}
+
+void RegionExtractor::extractRegion(const image_t* img, const image_t* chromaU, const image_t* chromaV, const std::vector<Point<int32_t>>& markerCorners, image_t* dst, image_t* hsvDst)
+{
+    const std::vector<Point<int32_t>> corners = studCorners(markerCorners);
+    // While the corners stay the same, every frame only gathers its pixels from the table.
+    if (!updateWarpTable(img, corners, dst)) {
+        // Without a table the affine warp of the first three corners is the best there is
+        int32_t colpos[3] = { corners[0].col, corners[1].col, corners[2].col };
+        int32_t rowpos[3] = { corners[0].row, corners[1].row, corners[2].row };
+        if (img->type == IMGTYPE_BASIC) {
+            warpYUV420(img, chromaU, chromaV, dst, colpos, rowpos);
+        } else {
+            warp(img, dst, colpos, rowpos);
+        }
+        if (hsvDst != nullptr) {
+            convertToHSVImage(dst, hsvDst);
+        }
+        return;
+    }
+    if (img->type == IMGTYPE_BASIC) {
+        warpYUV420WithTable(img, chromaU, chromaV, dst, hsvDst, warpTable);
+    } else {
+        warpWithTable(img, dst, hsvDst, warpTable);
+    }
+}
+
+uint32_t RegionExtractor::getWarpTableBuilds() const
+{
+    return warpTableBuilds;
+}
+
+bool RegionExtractor::updateWarpTable(const image_t* img, const std::vector<Point<int32_t>>& corners, const image_t* dst)
+{
+    if (warpTable != nullptr && (warpTable->cols != (int32_t)dst->cols || warpTable->rows != (int32_t)dst->rows)) {
+        deleteWarpTable(warpTable);
+        warpTable = nullptr;
+    }
+    if (warpTable == nullptr) {
+        warpTable = newWarpTable(dst->cols, dst->rows);
+        if (warpTable == nullptr) {
+            return false;
+        }
+        warpCorners.clear();
+    }
+    std::vector<Point<int32_t>> used(corners.begin(), corners.begin() + std::min<std::size_t>(corners.size(), 4));
+    if (used == warpCorners && warpTable->srcCols == (int32_t)img->cols && warpTable->srcRows == (int32_t)img->rows) {
+        return true;
+    }
+
+    int32_t colpos[4] = { 0 };
+    int32_t rowpos[4] = { 0 };
+    for (std::size_t i = 0; i < used.size(); i++) {
+        colpos[i] = used[i].col;
+        rowpos[i] = used[i].row;
+    }
+    float homography[3][3];
+    if (used.size() == 4 && homographyFromCorners(dst, colpos, rowpos, homography)) {
+        if (!warpTableFromHomography(warpTable, img->cols, img->rows, homography)) {
+            // The table is marked as made for no source, so the next frame tries again
+            warpCorners.clear();
+            return false;
+        }
+    } else {
+        warpTableFromCorners(warpTable, img->cols, img->rows, colpos, rowpos);
+    }
+    warpCorners = used;
+    warpTableBuilds++;
+    return true;
 }
 
 } // namespace cpparas
@@ -1,6 +1,7 @@
 #include "StateMachine.hpp"
 #include "debug/Debug.hpp"
 #include <iostream>
+#include <stdexcept>
 
 namespace cpparas {
 
@@ -9,10 +10,13 @@ StateMachine::StateMachine(std::shared_ptr<Locator> locator_)
     , simulatedBaseplateShifted(false)
     , stateStep()
     , lsfData()
-    , coordinateMatrix(DEFAULT_CALIBRATION)
     , handDetection()
+    , handChecked(false)
+    , handSceneChanges(0)
     , projection(std::make_shared<Projection>(DEFAULT_CALIBRATION))
     , locator(locator_)
+    , studFrames(locator_->Subscribe_studs(DropPolicy::LATEST))
+    , handFrames(locator_->Subscribe(DropPolicy::LATEST))
 {
     addStateName(State::NOT_STARTED, "Not Started");
     addStateName(State::INIT, "Init");
@@ -26,6 +30,12 @@ StateMachine::StateMachine(std::shared_ptr<Locator> locator_)
     addStateName(State::MOVE_BASEPLATE, "Move Baseplate");
     addStateName(State::FINAL_STEP, "Final Step");
 
+    // States that wait for a frame get every frame as soon as possible
+    setLocatorRate(State::CHECK_CURRENT_STEP, FRAME_RATE_UNLIMITED);
+    setLocatorRate(State::WAIT_HAND_ENTER, FRAME_RATE_UNLIMITED);
+    setLocatorRate(State::WAIT_HAND_EXIT, FRAME_RATE_UNLIMITED);
+    setLocatorRate(State::MOVE_BASEPLATE, FRAME_RATE_UNLIMITED);
+
     setDoHook(std::bind(&StateMachine::doHook, this));
 
     addHandler(State::INIT, StateFuncType::ENTRY, std::bind(&StateMachine::INIT_entry, this));
@@ -93,6 +103,23 @@ std::shared_ptr<Projection> StateMachine::getProjection() const
     return projection;
 }
 
+FrameInfo StateMachine::getFrameInfo() const
+{
+    return frameInfo;
+}
+
+CaptureStatistics StateMachine::getCaptureStatistics() const
+{
+    CaptureStatistics statistics = locator->Get_capture_statistics();
+    statistics.frameAge = frameAge;
+    return statistics;
+}
+
+std::shared_ptr<Locator> StateMachine::getLocator() const
+{
+    return locator;
+}
+
 void StateMachine::setLSFData(const LSFParser::LSFData& data)
 {
     lsfData = data;
@@ -127,9 +154,16 @@ std::pair<bool, StateStep> StateMachine::nextStateStep(StateStep fromStep) const
 
 // State machine actions
 
+void StateMachine::setLocatorRate(State state, double frameRate)
+{
+    locatorRates[state] = frameRate;
+}
+
 void StateMachine::doHook()
 {
     State currentState = getCurrentState();
+    auto rate = locatorRates.find(currentState);
+    locator->Set_max_rate(rate != locatorRates.end() ? rate->second : LOCATOR_IDLE_RATE);
     if (currentState != State::INIT && currentState != State::STARTING && currentState != State::FINAL_STEP && currentState != State::MOVE_BASEPLATE) {
         if (simulatedBaseplateShifted || locator->Location_checker()) {
             locator->Active_corner_detection(true);
@@ -138,6 +172,31 @@ void StateMachine::doHook()
     }
 }
 
+std::shared_ptr<const Frame> StateMachine::takeFrame(FrameSubscriber& frames)
+{
+    std::shared_ptr<const Frame> frame = frames.tryTake();
+    if (frame == nullptr) {
+        if (frames.isClosed()) {
+            throw std::runtime_error("Camera and locator thread stopped unexpectedly");
+        }
+        return nullptr;
+    }
+    frameInfo = frame->getInfo();
+    frameAge.add(std::chrono::duration<double, std::milli>(CaptureClock::now() - frameInfo.timestamp).count());
+    return frame;
+}
+
+void StateMachine::updateHandDetection()
+{
+    std::shared_ptr<const Frame> frame = takeFrame(*handFrames);
+    // Frames of an unchanged scene can't show a hand that wasn't there before
+    if (frame && (!handChecked || frame->getInfo().sceneChanges != handSceneChanges)) {
+        handDetection.update(frame->getHSVImage());
+        handSceneChanges = frame->getInfo().sceneChanges;
+        handChecked = true;
+    }
+}
+
 void StateMachine::INIT_entry()
 {
     // Spawn camera-locator thread
@@ -171,18 +230,34 @@ void StateMachine::STARTING_do()
 }
 void StateMachine::STARTING_exit() {}
 
-void StateMachine::CHECK_CURRENT_STEP_entry() {}
+void StateMachine::CHECK_CURRENT_STEP_entry()
+{
+    // Studs are checked on full resolution frames only
+    locator->Request_stream_mode(StreamMode::FULL);
+    // Only the layer of the step is gathered onto the stud lattice, besides the reference colors
+    const LSFParser::LSFDataStruct& stepinst = lsfData.Layer.at(stateStep.layer).Step.at(stateStep.step);
+    locator->Request_stud_layer(stepinst.layer);
+    // The locator only cuts frames when the scene changed, so the newest frame may have been checked already
+    studFrames->rewind();
+}
 void StateMachine::CHECK_CURRENT_STEP_do()
 {
-    image_t* axne = locator->Get_new_frame();
-    locator->Send_frame_to_ui(axne);
-
-    // Calculate coordinate matrix
-    coordinateMatrix.update(0, 0, axne->cols, axne->rows);
+    if (!locator->Full_frame_available()) {
+        return;
+    }
+    std::shared_ptr<const Frame> frame = takeFrame(*studFrames);
+    if (!frame) {
+        return;
+    }
+    // Frames gathered before the layer of the step was requested are skipped
+    const LSFParser::LSFDataStruct& stepinst = lsfData.Layer.at(stateStep.layer).Step.at(stateStep.step);
+    StudFrame studs(frame);
+    if (!studs.hasLayer(stepinst.layer)) {
+        return;
+    }
 
     // recognise image
-    const LSFParser::LSFDataStruct& stepinst = lsfData.Layer.at(stateStep.layer).Step.at(stateStep.step);
-    bool brickPlacedCorrectly = StudChecker::matches(axne, coordinateMatrix, stepinst.coordinates, stepinst.layer, stepinst.color);
+    bool brickPlacedCorrectly = StudChecker::matches(studs, stepinst.coordinates, stepinst.layer, stepinst.color);
     if (brickPlacedCorrectly) {
         switchState(State::CHECK_NEXT_STEP);
     } else {
@@ -218,25 +293,28 @@ void StateMachine::PROJECT_STEP_do()
 }
 void StateMachine::PROJECT_STEP_exit() {}
 
-void StateMachine::WAIT_HAND_ENTER_entry() {}
+void StateMachine::WAIT_HAND_ENTER_entry()
+{
+    // The hand is detected on preview frames, which come in faster
+    locator->Request_stream_mode(StreamMode::PREVIEW);
+}
 void StateMachine::WAIT_HAND_ENTER_do()
 {
     locator->Active_corner_detection(false);
-    image_t* axne = locator->Get_new_frame();
-    handDetection.update(axne);
-    locator->Send_frame_to_ui(axne);
+    updateHandDetection();
     if (handDetection.containsHand()) {
         switchState(State::WAIT_HAND_EXIT);
     }
 }
 void StateMachine::WAIT_HAND_ENTER_exit() {}
 
-void StateMachine::WAIT_HAND_EXIT_entry() {}
+void StateMachine::WAIT_HAND_EXIT_entry()
+{
+    locator->Request_stream_mode(StreamMode::PREVIEW);
+}
 void StateMachine::WAIT_HAND_EXIT_do()
 {
-    image_t* axne = locator->Get_new_frame();
-    handDetection.update(axne);
-    locator->Send_frame_to_ui(axne);
+    updateHandDetection();
     if (!handDetection.containsHand()) {
         switchState(State::PROJECT_OFF);
     }
@@ -251,6 +329,9 @@ void StateMachine::PROJECT_OFF_entry()
 
     // Start timer.
     projectOffStartTime = std::chrono::system_clock::now();
+
+    // Let the camera switch to full resolution while the projector is off
+    locator->Request_stream_mode(StreamMode::FULL);
 }
 void StateMachine::PROJECT_OFF_do()
 {
@@ -281,6 +362,9 @@ void StateMachine::CHECK_NEXT_STEP_exit() {}
 
 void StateMachine::MOVE_BASEPLATE_entry()
 {
+    // The markers are only found on full resolution frames
+    locator->Request_stream_mode(StreamMode::FULL);
+
     projection->clear();
     projection->showBaseplateOutline();
     projection->showMoveBaseplateWarning();
@@ -288,8 +372,8 @@ void StateMachine::MOVE_BASEPLATE_entry()
 }
 void StateMachine::MOVE_BASEPLATE_do()
 {
-    image_t* axne = locator->Get_new_frame();
-    locator->Send_frame_to_ui(axne);
+    // Nothing is looked at while waiting for the user, but a stopped locator still has to be noticed
+    takeFrame(*handFrames);
     if (!simulatedBaseplateShifted && !locator->Location_checker()) {
         switchState(getPreviousState());
     }
@@ -0,0 +1,39 @@
+#include "StillImageSource.hpp"
+
+namespace cpparas {
+
+StillImageSource::StillImageSource(const image_t* image, double frameRate)
+    : FrameSource(frameRate)
+{
+    stillImage = newRGB888Image(image->cols, image->rows);
+    copy(image, stillImage);
+}
+
+StillImageSource::~StillImageSource()
+{
+    stop();
+    deleteImage(stillImage);
+}
+
+bool StillImageSource::deliversStillFrames() const
+{
+    return true;
+}
+
+bool StillImageSource::open()
+{
+    setFrameSize(stillImage->cols, stillImage->rows);
+    return true;
+}
+
+bool StillImageSource::readFrame(image_t* dst)
+{
+    copy(stillImage, dst);
+    return true;
+}
+
+void StillImageSource::close()
+{
+}
+
+} // namespace cpparas
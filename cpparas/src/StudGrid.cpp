@@ -0,0 +1,217 @@
+#include "StudGrid.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace cpparas {
+
+StudGrid::StudGrid(Calibration calibration_, uint32_t studPixels_)
+    : calibration(calibration_)
+    , studPixels(studPixels_)
+    , layer(0)
+    , table(nullptr)
+    , tableBuilds(0)
+{
+    if (studPixels == 0 || studPixels % 4 != 0) {
+        throw std::invalid_argument("stud grid pixels must be a multiple of 4");
+    }
+    for (int32_t& tableLayer : tableLayers) {
+        tableLayer = -1;
+    }
+}
+
+StudGrid::~StudGrid()
+{
+    deleteWarpTable(table);
+}
+
+uint32_t StudGrid::getStudPixels() const
+{
+    return studPixels;
+}
+
+uint32_t StudGrid::getCols() const
+{
+    return calibration.baseplateCols * studPixels;
+}
+
+uint32_t StudGrid::getRows() const
+{
+    return calibration.baseplateRows * studPixels * STUD_FRAME_LAYERS;
+}
+
+void StudGrid::setCorners(const std::vector<Point<int32_t>>& corners_)
+{
+    if (corners_ == corners) {
+        return;
+    }
+    corners = corners_;
+    for (int32_t& tableLayer : tableLayers) {
+        tableLayer = -1;
+    }
+}
+
+void StudGrid::setLayer(uint32_t layer_)
+{
+    layer = layer_;
+}
+
+uint32_t StudGrid::getLayer() const
+{
+    return layer;
+}
+
+bool StudGrid::sample(const image_t* img, const image_t* chromaU, const image_t* chromaV, image_t* dst, image_t* hsvDst)
+{
+    if (corners.size() != 4) {
+        return false;
+    }
+    if (table == nullptr) {
+        table = newWarpTable(getCols(), getRows());
+        if (table == nullptr) {
+            return false;
+        }
+    }
+    if (table->srcCols != img->cols || table->srcRows != img->rows) {
+        for (int32_t& tableLayer : tableLayers) {
+            tableLayer = -1;
+        }
+    }
+    // The bottom layer is always there for the reference colors
+    if (!updateBlock(0, 0, img, dst) || !updateBlock(1, layer, img, dst)) {
+        return false;
+    }
+
+    if (img->type == IMGTYPE_BASIC) {
+        warpYUV420WithTable(img, chromaU, chromaV, dst, hsvDst, table);
+    } else {
+        warpWithTable(img, dst, hsvDst, table);
+    }
+    return true;
+}
+
+uint32_t StudGrid::getTableBuilds() const
+{
+    return tableBuilds;
+}
+
+bool StudGrid::updateBlock(uint32_t block, uint32_t blockLayer, const image_t* img, const image_t* dst)
+{
+    if (tableLayers[block] == (int32_t)blockLayer) {
+        return true;
+    }
+    int32_t colpos[4];
+    int32_t rowpos[4];
+    for (std::size_t i = 0; i < 4; i++) {
+        colpos[i] = corners[i].col;
+        rowpos[i] = corners[i].row;
+    }
+    // Maps the pixels of dst onto the baseplate, dst spanning it from its outer corners
+    float baseplate[3][3];
+    if (!homographyFromCorners(dst, colpos, rowpos, baseplate)) {
+        return false;
+    }
+
+    // Pixel x of a block samples stud (x + 0.5) / studPixels - 0.5, whose center lies (stud + 0.5) / baseplateCols
+    // along the baseplate, moved away from the center by the scale of the layer.
+    const double scale = layerScale(blockLayer);
+    const double stepCol = scale / (studPixels * calibration.baseplateCols) * dst->cols;
+    const double stepRow = scale / (studPixels * calibration.baseplateRows) * dst->rows;
+    const double firstCol = (0.5 + (0.5 / studPixels - calibration.baseplateCols / 2.0) / calibration.baseplateCols * scale) * dst->cols;
+    const double firstRow = (0.5 + (0.5 / studPixels - calibration.baseplateRows / 2.0) / calibration.baseplateRows * scale) * dst->rows;
+    float homography[3][3];
+    for (int32_t i = 0; i < 3; i++) {
+        homography[i][0] = (float)(baseplate[i][0] * stepCol);
+        homography[i][1] = (float)(baseplate[i][1] * stepRow);
+        homography[i][2] = (float)(baseplate[i][0] * firstCol + baseplate[i][1] * firstRow + baseplate[i][2]);
+    }
+
+    // The rows of the table that belong to the block
+    const int32_t blockPixels = table->cols * table->rows / STUD_FRAME_LAYERS;
+    warp_table_t part = *table;
+    part.rows = table->rows / STUD_FRAME_LAYERS;
+    part.offsets += block * blockPixels;
+    part.chromaOffsets += block * blockPixels;
+    part.fractions += 2 * block * blockPixels;
+    if (!warpTableFromHomography(&part, img->cols, img->rows, homography)) {
+        tableLayers[block] = -1;
+        return false;
+    }
+    table->srcCols = img->cols;
+    table->srcRows = img->rows;
+    tableLayers[block] = blockLayer;
+    tableBuilds++;
+    return true;
+}
+
+double StudGrid::layerScale(uint32_t layer) const
+{
+    // x' = x / z, with z relative to the bottom layer
+    return calibration.cameraHeight / (calibration.cameraHeight - layer * calibration.blockHeight);
+}
+
+StudFrame::StudFrame(std::shared_ptr<const Frame> frame_, uint32_t studPixels_)
+    : frame(frame_)
+    , studPixels(studPixels_)
+{
+}
+
+bool StudFrame::hasLayer(uint32_t layer) const
+{
+    return layer == 0 || layer == frame->getInfo().studLayer;
+}
+
+const image_t* StudFrame::getImage() const
+{
+    return frame->getImage();
+}
+
+const image_t* StudFrame::getHSVImage() const
+{
+    return frame->getHSVImage();
+}
+
+uint32_t StudFrame::getStudPixels() const
+{
+    return studPixels;
+}
+
+Point<int32_t> StudFrame::blockPosition(uint32_t layer, const Point<uint32_t>& stud) const
+{
+    if (!hasLayer(layer)) {
+        throw std::invalid_argument("stud frame doesn't hold layer " + std::to_string(layer));
+    }
+    const int32_t blockRows = frame->getImage()->rows / STUD_FRAME_LAYERS;
+    Point<int32_t> position;
+    position.col = stud.col * studPixels;
+    position.row = (layer == 0 ? 0 : blockRows) + stud.row * studPixels;
+    return position;
+}
+
+hsv_pixel_t StudFrame::studColor(uint32_t layer, const Point<uint32_t>& stud) const
+{
+    const image_t* hsvImage = getHSVImage();
+    const Point<int32_t> block = blockPosition(layer, stud);
+    // The pixels of a block sample the stud at (i + 0.5) / studPixels - 0.5 studs from its center,
+    // the middle half of them lie within a quarter stud.
+    const uint32_t first = studPixels / 4;
+    const uint32_t last = studPixels * 3 / 4;
+    long int sum_h = 0;
+    long int sum_s = 0;
+    long int sum_v = 0;
+    for (uint32_t r = first; r < last; r++) {
+        for (uint32_t c = first; c < last; c++) {
+            const hsv_pixel_t pixel = getHSVPixel(hsvImage, block.col + c, block.row + r);
+            sum_h += pixel.h;
+            sum_s += pixel.s;
+            sum_v += pixel.v;
+        }
+    }
+    const long int count = (last - first) * (last - first);
+    hsv_pixel_t average;
+    average.h = sum_h / count;
+    average.s = sum_s / count;
+    average.v = sum_v / count;
+    return average;
+}
+
+} // namespace cpparas
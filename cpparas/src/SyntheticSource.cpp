@@ -0,0 +1,144 @@
+#include "SyntheticSource.hpp"
+#include <algorithm>
+
+namespace cpparas {
+
+const rgb888_pixel_t SYNTHETIC_TABLE_COLOR = { 196, 140, 80 };
+const rgb888_pixel_t SYNTHETIC_BASEPLATE_COLOR = { 160, 160, 165 };
+const rgb888_pixel_t SYNTHETIC_MARKER_COLOR = { 245, 245, 245 };
+// Falls within HAND_THRESHOLD_LOW and HAND_THRESHOLD_HIGH.
+const rgb888_pixel_t SYNTHETIC_HAND_COLOR = { 200, 150, 120 };
+
+// Sizes are factors of the smallest frame dimension.
+const float SYNTHETIC_BASEPLATE_SIZE = 0.55f;
+const float SYNTHETIC_MARKER_SIZE = 0.075f;
+// The camera sits slightly below the projector, see the offset in Locator.
+const float SYNTHETIC_BASEPLATE_ROW_SHIFT = -0.017f;
+
+SyntheticSource::SyntheticSource(uint32_t cols_, uint32_t rows_, double frameRate)
+    : FrameSource(frameRate)
+    , cols(cols_)
+    , rows(rows_)
+    , handPresent(false)
+    , offsetCols(0)
+    , offsetRows(0)
+    , scene(nullptr)
+    , sceneOffsetCols(0)
+    , sceneOffsetRows(0)
+{
+}
+
+SyntheticSource::~SyntheticSource()
+{
+    stop();
+}
+
+void SyntheticSource::setHandPresent(bool handPresent_)
+{
+    handPresent = handPresent_;
+}
+
+void SyntheticSource::setBaseplateOffset(int32_t cols_, int32_t rows_)
+{
+    offsetCols = cols_;
+    offsetRows = rows_;
+}
+
+std::vector<Point<int32_t>> SyntheticSource::getMarkerCorners() const
+{
+    int32_t size = std::min(cols, rows) * SYNTHETIC_BASEPLATE_SIZE;
+    int32_t left = (int32_t)cols / 2 - size / 2 + offsetCols;
+    int32_t top = (int32_t)rows / 2 - size / 2 + (int32_t)(std::min(cols, rows) * SYNTHETIC_BASEPLATE_ROW_SHIFT) + offsetRows;
+    return {
+        { left, top },
+        { left + size - 1, top },
+        { left + size - 1, top + size - 1 }
+    };
+}
+
+bool SyntheticSource::open()
+{
+    setFrameSize(cols, rows);
+    scene = newRGB888Image(cols, rows);
+    sceneOffsetCols = offsetCols;
+    sceneOffsetRows = offsetRows;
+    renderScene(scene);
+    return true;
+}
+
+bool SyntheticSource::readFrame(image_t* dst)
+{
+    if (sceneOffsetCols != offsetCols || sceneOffsetRows != offsetRows) {
+        sceneOffsetCols = offsetCols;
+        sceneOffsetRows = offsetRows;
+        renderScene(scene);
+    }
+    copy(scene, dst);
+    if (handPresent) {
+        renderHand(dst);
+    }
+    return true;
+}
+
+void SyntheticSource::close()
+{
+    deleteImage(scene);
+    scene = nullptr;
+}
+
+void SyntheticSource::renderScene(image_t* dst) const
+{
+    const std::vector<Point<int32_t>> corners = getMarkerCorners();
+    const int32_t baseplateSize = corners[1].col - corners[0].col + 1;
+    int32_t topLeft[2] = { 0, 0 };
+    int32_t size[2] = { (int32_t)cols, (int32_t)rows };
+    pixel_t color;
+    color.rgb888_pixel = SYNTHETIC_TABLE_COLOR;
+    drawRect(dst, topLeft, size, color, SHAPE_FILL, 0);
+
+    topLeft[0] = corners[0].col;
+    topLeft[1] = corners[0].row;
+    size[0] = baseplateSize;
+    size[1] = baseplateSize;
+    color.rgb888_pixel = SYNTHETIC_BASEPLATE_COLOR;
+    drawRect(dst, topLeft, size, color, SHAPE_FILL, 0);
+
+    // The markers are squares with one sharp corner on the baseplate corner and the other three corners rounded.
+    const int32_t markerSize = std::min(cols, rows) * SYNTHETIC_MARKER_SIZE;
+    const int32_t radius = markerSize / 2;
+    // Direction from the sharp corner into the marker for each corner.
+    const int32_t directions[3][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 } };
+    for (std::size_t i = 0; i < corners.size(); i++) {
+        for (int32_t r = 0; r < markerSize; r++) {
+            for (int32_t c = 0; c < markerSize; c++) {
+                // Everything outside the quadrant of the sharp corner is clipped to a circle around the marker center.
+                if (c >= radius || r >= radius) {
+                    int32_t dc = c - std::max(c, radius) + std::max(0, c - (markerSize - radius));
+                    int32_t dr = r - std::max(r, radius) + std::max(0, r - (markerSize - radius));
+                    if (dc * dc + dr * dr > radius * radius) {
+                        continue;
+                    }
+                }
+                int32_t col = corners[i].col + directions[i][0] * c;
+                int32_t row = corners[i].row + directions[i][1] * r;
+                if (col >= 0 && col < (int32_t)cols && row >= 0 && row < (int32_t)rows) {
+                    setRGB888Pixel(dst, col, row, SYNTHETIC_MARKER_COLOR);
+                }
+            }
+        }
+    }
+}
+
+void SyntheticSource::renderHand(image_t* dst) const
+{
+    const std::vector<Point<int32_t>> corners = getMarkerCorners();
+    const int32_t baseplateSize = corners[1].col - corners[0].col + 1;
+    // An arm reaching in from the bottom edge of the frame to the middle of the baseplate.
+    int32_t topLeft[2] = { corners[0].col + baseplateSize * 2 / 5, corners[0].row + baseplateSize / 2 };
+    int32_t size[2] = { baseplateSize / 5, (int32_t)rows - topLeft[1] };
+    pixel_t color;
+    color.rgb888_pixel = SYNTHETIC_HAND_COLOR;
+    drawRect(dst, topLeft, size, color, SHAPE_FILL, 0);
+}
+
+} // namespace cpparas
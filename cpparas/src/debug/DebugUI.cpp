@@ -12,6 +12,7 @@ DebugUI::DebugUI(std::shared_ptr<StateMachine> stateMachine_)
     , logViewport()
     , logTextView()
     , stateNameLabel()
+    , captureLabel()
     , imageViewport()
     , imageContainer()
     , imageArea()
@@ -32,12 +33,14 @@ DebugUI::DebugUI(std::shared_ptr<StateMachine> stateMachine_)
     imageViewport.set_vexpand(true);
 
     stateNameLabel.set_justify(Gtk::JUSTIFY_LEFT);
+    captureLabel.set_justify(Gtk::JUSTIFY_LEFT);
 
     logViewport.add(logTextView);
     imageViewport.add(imageArea);
     widgetContainer.attach(stateNameLabel, 1, 1, 1, 1);
-    widgetContainer.attach(logViewport, 1, 2, 1, 5);
-    widgetContainer.attach(imageViewport, 1, 7, 1, 15);
+    widgetContainer.attach(captureLabel, 1, 2, 1, 3);
+    widgetContainer.attach(logViewport, 1, 5, 1, 5);
+    widgetContainer.attach(imageViewport, 1, 10, 1, 15);
 
     Glib::signal_timeout().connect(
         sigc::mem_fun(*this, &DebugUI::update),
@@ -48,6 +51,7 @@ DebugUI::DebugUI(std::shared_ptr<StateMachine> stateMachine_)
     logTextView.show();
     logViewport.show();
     stateNameLabel.show();
+    captureLabel.show();
     imageViewport.show();
     imageContainer.show();
     imageArea.show();
@@ -72,6 +76,14 @@ bool DebugUI::update()
 
     stateNameLabel.set_text(std::string("Current state: ") + stateMachine->getCurrentStateName());
 
+    FrameInfo frameInfo = stateMachine->getFrameInfo();
+    std::string frameText = "No frame processed yet";
+    if (frameInfo.sequence != 0) {
+        double age = std::chrono::duration<double, std::milli>(CaptureClock::now() - frameInfo.timestamp).count();
+        frameText = "Frame " + std::to_string(frameInfo.sequence) + ", captured " + std::to_string((int)age) + " ms ago";
+    }
+    captureLabel.set_text(frameText + "\n" + stateMachine->getCaptureStatistics().summary() + "\n" + stateMachine->getLocator()->Get_tracking_statistics().summary());
+
     const image_t* image = Debug::getImage();
     if (currentImage != image) {
         if (image) {
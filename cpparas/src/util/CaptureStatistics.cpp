@@ -0,0 +1,108 @@
+#include "util/CaptureStatistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace cpparas {
+
+Histogram::Histogram(double bucketWidth_, std::size_t bucketCount)
+    : bucketWidth(bucketWidth_)
+    , buckets(std::max<std::size_t>(bucketCount, 1), 0)
+    , count(0)
+    , min(0.0)
+    , max(0.0)
+    , sum(0.0)
+{
+}
+
+void Histogram::add(double value)
+{
+    double bucket = std::floor(std::max(value, 0.0) / bucketWidth);
+    buckets[std::min((std::size_t)bucket, buckets.size() - 1)]++;
+    if (count == 0 || value < min) {
+        min = value;
+    }
+    if (count == 0 || value > max) {
+        max = value;
+    }
+    sum += value;
+    count++;
+}
+
+void Histogram::reset()
+{
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    min = 0.0;
+    max = 0.0;
+    sum = 0.0;
+}
+
+uint64_t Histogram::getCount() const
+{
+    return count;
+}
+
+double Histogram::getMin() const
+{
+    return min;
+}
+
+double Histogram::getMax() const
+{
+    return max;
+}
+
+double Histogram::getMean() const
+{
+    return count == 0 ? 0.0 : sum / count;
+}
+
+double Histogram::getPercentile(double fraction) const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t target = (uint64_t)std::ceil(fraction * count);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= target && seen > 0) {
+            // The last bucket holds everything above the range
+            return i == buckets.size() - 1 ? max : (i + 1) * bucketWidth;
+        }
+    }
+    return max;
+}
+
+double Histogram::getBucketWidth() const
+{
+    return bucketWidth;
+}
+
+const std::vector<uint64_t>& Histogram::getBuckets() const
+{
+    return buckets;
+}
+
+std::string Histogram::summary() const
+{
+    std::ostringstream text;
+    text.precision(1);
+    text << std::fixed << "n=" << count << " mean=" << getMean() << " p50=" << getPercentile(0.5) << " p99=" << getPercentile(0.99) << " max=" << max;
+    return text.str();
+}
+
+std::string CaptureStatistics::summary() const
+{
+    std::ostringstream text;
+    text << "Frames captured " << capturedFrames << ", taken " << consumedFrames << ", skipped " << skippedFrames
+         << ", dropped " << droppedFrames << ", discarded " << discardedFrames << ", warm-up " << warmupFrames << "\n";
+    text << "Frame interval (ms): " << frameInterval.summary() << "\n";
+    text << "Read duration (ms): " << readDuration.summary() << "\n";
+    text << "Reader lag (ms): " << readerLag.summary() << "\n";
+    text << "Frame age (ms): " << frameAge.summary();
+    return text.str();
+}
+
+} // namespace cpparas
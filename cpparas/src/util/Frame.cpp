@@ -0,0 +1,129 @@
+#include "util/Frame.hpp"
+
+namespace cpparas {
+
+Frame::Frame(image_t* image_)
+    : image(image_)
+    , hsvImage(nullptr)
+    , hsvValid(false)
+{
+}
+
+Frame::~Frame()
+{
+    if (hsvImage != nullptr) {
+        deleteImage(hsvImage);
+    }
+    deleteImage(image);
+}
+
+const image_t* Frame::getImage() const
+{
+    return image;
+}
+
+image_t* Frame::getImage()
+{
+    return image;
+}
+
+const image_t* Frame::getHSVImage() const
+{
+    std::lock_guard<std::mutex> locker(hsvMtx);
+    if (!hsvValid) {
+        convertToHSVImage(image, hsvImageLocked());
+        hsvValid = true;
+    }
+    return hsvImage;
+}
+
+image_t* Frame::provideHSVImage()
+{
+    std::lock_guard<std::mutex> locker(hsvMtx);
+    hsvValid = true;
+    return hsvImageLocked();
+}
+
+image_t* Frame::hsvImageLocked() const
+{
+    if (hsvImage == nullptr) {
+        hsvImage = newHSVImage(image->cols, image->rows);
+    }
+    return hsvImage;
+}
+
+const FrameInfo& Frame::getInfo() const
+{
+    return info;
+}
+
+void Frame::setInfo(const FrameInfo& info_)
+{
+    info = info_;
+}
+
+std::shared_ptr<FramePool> FramePool::create(uint32_t cols, uint32_t rows, FrameFormat format)
+{
+    return std::shared_ptr<FramePool>(new FramePool(cols, rows, format));
+}
+
+FramePool::FramePool(uint32_t cols_, uint32_t rows_, FrameFormat format_)
+    : cols(cols_)
+    , rows(rows_)
+    , format(format_)
+    , allocatedFrames(0)
+{
+}
+
+FramePool::~FramePool()
+{
+    for (Frame* frame : freeFrames) {
+        delete frame;
+    }
+}
+
+std::shared_ptr<Frame> FramePool::acquire()
+{
+    Frame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> locker(mtx);
+        if (!freeFrames.empty()) {
+            frame = freeFrames.back();
+            freeFrames.pop_back();
+        } else {
+            allocatedFrames++;
+        }
+    }
+    if (frame == nullptr) {
+        frame = new Frame(newFrameImage(cols, rows, format));
+    }
+    frame->info = FrameInfo();
+    frame->hsvValid = false;
+    std::weak_ptr<FramePool> pool = shared_from_this();
+    return std::shared_ptr<Frame>(frame, [pool](Frame* released) { recycle(pool, released); });
+}
+
+void FramePool::recycle(const std::weak_ptr<FramePool>& pool, Frame* frame)
+{
+    std::shared_ptr<FramePool> owner = pool.lock();
+    if (!owner) {
+        delete frame;
+        return;
+    }
+    std::lock_guard<std::mutex> locker(owner->mtx);
+    owner->freeFrames.push_back(frame);
+}
+
+std::size_t FramePool::getAllocatedFrames() const
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    return allocatedFrames;
+}
+
+std::size_t FramePool::getFreeFrames() const
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    return freeFrames.size();
+}
+
+} // namespace cpparas
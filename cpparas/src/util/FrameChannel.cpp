@@ -0,0 +1,152 @@
+#include "util/FrameChannel.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace cpparas {
+
+std::shared_ptr<FrameChannel> FrameChannel::create(uint32_t cols, uint32_t rows, FrameFormat format, std::size_t depth)
+{
+    return std::shared_ptr<FrameChannel>(new FrameChannel(cols, rows, format, depth));
+}
+
+FrameChannel::FrameChannel(uint32_t cols, uint32_t rows, FrameFormat format, std::size_t depth_)
+    : pool(FramePool::create(cols, rows, format))
+    , depth(std::max<std::size_t>(depth_, 1))
+    , publishedFrames(0)
+    , closed(false)
+{
+}
+
+std::shared_ptr<Frame> FrameChannel::acquire()
+{
+    // Frames still kept in the history or referenced by a subscriber are not in the pool,
+    // so the pool grows instead of the publisher waiting.
+    return pool->acquire();
+}
+
+void FrameChannel::publish(std::shared_ptr<Frame> frame)
+{
+    std::shared_ptr<const Frame> dropped;
+    {
+        std::lock_guard<std::mutex> locker(mtx);
+        Published published;
+        published.index = ++publishedFrames;
+        published.frame = std::move(frame);
+        history.push_back(std::move(published));
+        if (history.size() > depth) {
+            // Given back to the pool outside of the lock
+            dropped = std::move(history.front().frame);
+            history.pop_front();
+        }
+    }
+    condVar.notify_all();
+}
+
+void FrameChannel::close()
+{
+    {
+        std::lock_guard<std::mutex> locker(mtx);
+        closed = true;
+    }
+    condVar.notify_all();
+}
+
+void FrameChannel::open()
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    closed = false;
+}
+
+bool FrameChannel::isClosed() const
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    return closed;
+}
+
+std::shared_ptr<FrameSubscriber> FrameChannel::subscribe(DropPolicy policy)
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    uint64_t cursor = history.empty() ? publishedFrames : history.back().index - 1;
+    return std::shared_ptr<FrameSubscriber>(new FrameSubscriber(shared_from_this(), policy, cursor));
+}
+
+const FramePool& FrameChannel::getPool() const
+{
+    return *pool;
+}
+
+const FrameChannel::Published* FrameChannel::next(uint64_t cursor, DropPolicy policy) const
+{
+    if (history.empty() || history.back().index <= cursor) {
+        return nullptr;
+    }
+    if (policy == DropPolicy::LATEST) {
+        return &history.back();
+    }
+    for (const Published& published : history) {
+        if (published.index > cursor) {
+            return &published;
+        }
+    }
+    return nullptr;
+}
+
+FrameSubscriber::FrameSubscriber(std::shared_ptr<FrameChannel> channel_, DropPolicy policy_, uint64_t cursor_)
+    : channel(channel_)
+    , policy(policy_)
+    , cursor(cursor_)
+    , droppedFrames(0)
+{
+}
+
+std::shared_ptr<const Frame> FrameSubscriber::tryTake()
+{
+    std::lock_guard<std::mutex> locker(channel->mtx);
+    return takePublished(channel->next(cursor, policy));
+}
+
+std::shared_ptr<const Frame> FrameSubscriber::take(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> locker(channel->mtx);
+    const FrameChannel::Published* published = nullptr;
+    channel->condVar.wait_for(locker, timeout, [&]() {
+        published = channel->next(cursor, policy);
+        return published != nullptr || channel->closed;
+    });
+    return takePublished(published);
+}
+
+std::shared_ptr<const Frame> FrameSubscriber::takePublished(const FrameChannel::Published* published)
+{
+    if (published == nullptr) {
+        return nullptr;
+    }
+    droppedFrames += published->index - cursor - 1;
+    cursor = published->index;
+    return published->frame;
+}
+
+void FrameSubscriber::rewind()
+{
+    std::lock_guard<std::mutex> locker(channel->mtx);
+    if (!channel->history.empty() && cursor >= channel->history.back().index) {
+        cursor = channel->history.back().index - 1;
+    }
+}
+
+DropPolicy FrameSubscriber::getPolicy() const
+{
+    return policy;
+}
+
+uint64_t FrameSubscriber::getDroppedFrames() const
+{
+    return droppedFrames;
+}
+
+bool FrameSubscriber::isClosed() const
+{
+    return channel->isClosed();
+}
+
+} // namespace cpparas
@@ -0,0 +1,168 @@
+#include "util/FrameRing.hpp"
+#include <stdexcept>
+
+namespace cpparas {
+
+image_t* newFrameImage(uint32_t cols, uint32_t rows, FrameFormat format)
+{
+    switch (format) {
+    case FrameFormat::YUV420:
+        return newBasicImage(cols, rows * 3 / 2);
+    case FrameFormat::GRAY:
+        return newBasicImage(cols, rows);
+    default:
+        return newRGB888Image(cols, rows);
+    }
+}
+
+void viewFramePlanes(const image_t* frame, FrameFormat format, image_t& luma, image_t& chromaU, image_t& chromaV)
+{
+    int32_t rows = format == FrameFormat::YUV420 ? frame->rows * 2 / 3 : frame->rows;
+    luma = *frame;
+    luma.rows = rows;
+    chromaU = luma;
+    chromaU.cols = frame->cols / 2;
+    chromaU.rows = rows / 2;
+    chromaU.data = nullptr;
+    chromaV = chromaU;
+    if (format == FrameFormat::YUV420) {
+        chromaU.data = frame->data + frame->cols * rows;
+        chromaV.data = chromaU.data + chromaU.cols * chromaU.rows;
+    }
+}
+
+FrameRing::FrameRing(uint32_t cols_, uint32_t rows_, std::size_t slotCount, FrameFormat format_)
+    : cols(cols_)
+    , rows(rows_)
+    , format(format_)
+    , latestSlot(-1)
+    , writeSlot(-1)
+    , nextSequence(1)
+{
+    if (slotCount < 3) {
+        throw std::invalid_argument("a frame ring needs at least three slots");
+    }
+    if (format == FrameFormat::YUV420 && (cols % 2 != 0 || rows % 2 != 0)) {
+        throw std::invalid_argument("YUV420 frames need an even number of cols and rows");
+    }
+    for (std::size_t i = 0; i < slotCount; i++) {
+        Slot slot;
+        slot.image = newFrameImage(cols, rows, format);
+        slot.sequence = 0;
+        slot.cols = cols;
+        slot.rows = rows;
+        slot.readers = 0;
+        slots.push_back(slot);
+    }
+}
+
+FrameRing::~FrameRing()
+{
+    for (Slot& slot : slots) {
+        deleteImage(slot.image);
+    }
+}
+
+image_t* FrameRing::beginWrite()
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    if (writeSlot != -1) {
+        throw std::logic_error("frame ring write already in progress");
+    }
+    // Take the oldest free slot, so readers that come in late still find the newest frame.
+    for (int32_t i = 0; i < (int32_t)slots.size(); i++) {
+        if (i == latestSlot || slots[i].readers > 0) {
+            continue;
+        }
+        if (writeSlot == -1 || slots[i].sequence < slots[writeSlot].sequence) {
+            writeSlot = i;
+        }
+    }
+    if (writeSlot == -1) {
+        return nullptr;
+    }
+    return slots[writeSlot].image;
+}
+
+void FrameRing::commitWrite(CaptureClock::time_point timestamp)
+{
+    Rect<int32_t> fieldOfView = { { 0, 0 }, (int32_t)cols, (int32_t)rows };
+    commitWrite(timestamp, fieldOfView, nextSequence, cols, rows);
+}
+
+void FrameRing::commitWrite(CaptureClock::time_point timestamp, const Rect<int32_t>& fieldOfView, uint64_t sequence, uint32_t frameCols, uint32_t frameRows)
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    if (writeSlot == -1) {
+        throw std::logic_error("frame ring commit without write");
+    }
+    if (frameCols > cols || frameRows > rows) {
+        throw std::invalid_argument("frame is larger than the frame ring");
+    }
+    slots[writeSlot].sequence = sequence;
+    slots[writeSlot].timestamp = timestamp;
+    slots[writeSlot].fieldOfView = fieldOfView;
+    slots[writeSlot].cols = frameCols;
+    slots[writeSlot].rows = frameRows;
+    nextSequence = sequence + 1;
+    latestSlot = writeSlot;
+    writeSlot = -1;
+}
+
+void FrameRing::abortWrite()
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    writeSlot = -1;
+}
+
+bool FrameRing::acquireLatest(RingFrame& frame)
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    if (latestSlot == -1) {
+        return false;
+    }
+    Slot& slot = slots[latestSlot];
+    slot.readers++;
+    frame.slot = latestSlot;
+    frame.image = slot.image;
+    frame.sequence = slot.sequence;
+    frame.timestamp = slot.timestamp;
+    frame.fieldOfView = slot.fieldOfView;
+    frame.cols = slot.cols;
+    frame.rows = slot.rows;
+    return true;
+}
+
+void FrameRing::release(RingFrame& frame)
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    if (frame.slot < 0 || frame.slot >= (int32_t)slots.size() || slots[frame.slot].readers == 0) {
+        throw std::logic_error("released a frame that was not acquired");
+    }
+    slots[frame.slot].readers--;
+    frame.slot = -1;
+    frame.image = nullptr;
+}
+
+uint64_t FrameRing::latestSequence() const
+{
+    std::lock_guard<std::mutex> locker(mtx);
+    return latestSlot == -1 ? 0 : slots[latestSlot].sequence;
+}
+
+uint32_t FrameRing::getCols() const
+{
+    return cols;
+}
+
+uint32_t FrameRing::getRows() const
+{
+    return rows;
+}
+
+FrameFormat FrameRing::getFormat() const
+{
+    return format;
+}
+
+} // namespace cpparas
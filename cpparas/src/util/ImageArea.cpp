@@ -27,6 +27,14 @@ void ImageArea::setImage(const image_t* image)
     } catch (const Gdk::PixbufError& ex) {
         std::cerr << "PixbufError: " << ex.what() << std::endl;
     }
+    m_frame.reset();
+}
+
+void ImageArea::setFrame(std::shared_ptr<const Frame> frame)
+{
+    setImage(frame->getImage());
+    // The pixbuf shares the frame memory
+    m_frame = frame;
 }
 
 bool ImageArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
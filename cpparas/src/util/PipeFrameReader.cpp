@@ -0,0 +1,114 @@
+#include "util/PipeFrameReader.hpp"
+#include "debug/Debug.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <unistd.h>
+
+namespace cpparas {
+
+PipeFrameReader::PipeFrameReader(int fd_, std::size_t frameSize_)
+    : fd(-1)
+    , frameSize(frameSize_)
+    , frame(frameSize_)
+    , latest(frameSize_)
+    , filled(0)
+    , droppedFrames(0)
+{
+    reset(fd_);
+}
+
+void PipeFrameReader::reset(int fd_)
+{
+    fd = fd_;
+    filled = 0;
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags != -1) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+#ifdef F_SETPIPE_SZ
+    // The default pipe holds 64 KB, far less than a frame, so the writer would block on the frame
+    // after the one being read and a newer frame could never be waiting. Ask for room for two frames;
+    // when that is more than the system allows, the pipe keeps its size and frames are only dropped
+    // once the reader falls a whole frame behind.
+    if (fcntl(fd, F_GETPIPE_SZ) < (int)(2 * frameSize) && fcntl(fd, F_SETPIPE_SZ, (int)(2 * frameSize)) < 0) {
+        Debug::println(std::string("PipeFrameReader: pipe not enlarged to ") + std::to_string(2 * frameSize) + std::string(" bytes: ") + std::strerror(errno));
+    }
+#endif
+}
+
+PipeFrameReader::Status PipeFrameReader::readLatest(uint8_t* dst, int timeoutMs)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        int remainingMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ret = poll(&pfd, 1, std::max(remainingMs, 0));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Status::ERROR;
+        }
+        if (ret == 0) {
+            return Status::TIMEOUT;
+        }
+
+        // Read everything the pipe holds. Every frame that completes replaces the previous one,
+        // which was outdated before it was handed out.
+        bool complete = false;
+        Status status = Status::FRAME;
+        while (status == Status::FRAME) {
+            status = readSome();
+            if (filled == frameSize) {
+                if (complete) {
+                    droppedFrames++;
+                }
+                std::swap(frame, latest);
+                filled = 0;
+                complete = true;
+            }
+        }
+        if (complete) {
+            std::memcpy(dst, latest.data(), frameSize);
+            // A closed or failed pipe is reported on the next call.
+            return Status::FRAME;
+        }
+        if (status != Status::TIMEOUT) {
+            // The writer is gone, a partial frame is thrown away.
+            filled = 0;
+            return status;
+        }
+    }
+}
+
+uint64_t PipeFrameReader::getDroppedFrames() const
+{
+    return droppedFrames;
+}
+
+// Reads at most the rest of the current frame. Returns FRAME when bytes were read,
+// TIMEOUT when the pipe is empty, CLOSED at the end of the pipe and ERROR when reading failed.
+PipeFrameReader::Status PipeFrameReader::readSome()
+{
+    while (true) {
+        ssize_t n = read(fd, frame.data() + filled, frameSize - filled);
+        if (n > 0) {
+            filled += n;
+            return Status::FRAME;
+        }
+        if (n == 0) {
+            return Status::CLOSED;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK ? Status::TIMEOUT : Status::ERROR;
+    }
+}
+
+} // namespace cpparas
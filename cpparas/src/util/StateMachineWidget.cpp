@@ -15,6 +15,7 @@ StateMachineWidget::StateMachineWidget(std::shared_ptr<StateMachine> _stateMachi
     , stepLabel()
     , imageViewport()
     , imageArea()
+    , previewFrames(_stateMachine->getLocator()->Subscribe(DropPolicy::LATEST))
     , paused(true)
 {
     update();
@@ -78,9 +79,10 @@ bool StateMachineWidget::update()
     }
     layerLabel.set_text(std::string("Layer: ") + std::to_string(stateMachine->getStateStep().layer));
     stepLabel.set_text(std::string("Step: ") + std::to_string(stateMachine->getStateStep().step));
-    //Check if new frame to show is available, if so, get it from imageLoader and show it
-    if (imageLoader->Get_new_UI_frame_available()) {
-        imageArea.setImage(imageLoader->Get_UI_frame());
+    //Check if new frame to show is available, if so, show it
+    std::shared_ptr<const Frame> frame = previewFrames->tryTake();
+    if (frame) {
+        imageArea.setFrame(frame);
     }
     return true;
 }
@@ -0,0 +1,39 @@
+#include "util/CaptureStatistics.hpp"
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+TEST(CaptureStatisticsSuite, HistogramKeepsExactMinMaxAndMean)
+{
+    Histogram histogram(1.0, 10);
+    EXPECT_EQ(histogram.getCount(), 0u);
+    EXPECT_EQ(histogram.getPercentile(0.5), 0.0);
+
+    histogram.add(2.5);
+    histogram.add(3.5);
+    histogram.add(42.0);
+    EXPECT_EQ(histogram.getCount(), 3u);
+    EXPECT_DOUBLE_EQ(histogram.getMin(), 2.5);
+    EXPECT_DOUBLE_EQ(histogram.getMax(), 42.0);
+    EXPECT_DOUBLE_EQ(histogram.getMean(), 16.0);
+    // Values past the range end up in the last bucket.
+    EXPECT_EQ(histogram.getBuckets()[2], 1u);
+    EXPECT_EQ(histogram.getBuckets()[3], 1u);
+    EXPECT_EQ(histogram.getBuckets()[9], 1u);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getCount(), 0u);
+    EXPECT_EQ(histogram.getBuckets()[9], 0u);
+}
+
+TEST(CaptureStatisticsSuite, PercentilesAreBucketEdges)
+{
+    Histogram histogram(2.0, 50);
+    for (int i = 0; i < 99; i++) {
+        histogram.add(33.0);
+    }
+    histogram.add(70.0);
+    EXPECT_DOUBLE_EQ(histogram.getPercentile(0.5), 34.0);
+    EXPECT_DOUBLE_EQ(histogram.getPercentile(0.99), 34.0);
+    EXPECT_DOUBLE_EQ(histogram.getPercentile(1.0), 72.0);
+}
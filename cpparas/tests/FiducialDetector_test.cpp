@@ -0,0 +1,134 @@
+#include "FiducialDetector.hpp"
+#include "MarkerDetector.hpp"
+#include "Timing.hpp"
+#include "operators.h"
+#include "util/ImageUtils.hpp"
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+static const int32_t MARKER_SIZE = 108;
+
+// Draws a gray baseplate on a table, like SyntheticSource, with a white margin for every marker.
+static image_t* baseplateFrame(std::vector<Point<int32_t>>& positions)
+{
+    image_t* image = newRGB888Image(1440, 1440);
+    pixel_t color;
+    int32_t topLeft[2] = { 0, 0 };
+    int32_t size[2] = { image->cols, image->rows };
+    color.rgb888_pixel = { 196, 140, 80 };
+    drawRect(image, topLeft, size, color, SHAPE_FILL, 0);
+    topLeft[0] = 330;
+    topLeft[1] = 300;
+    size[0] = size[1] = 792;
+    color.rgb888_pixel = { 160, 160, 165 };
+    drawRect(image, topLeft, size, color, SHAPE_FILL, 0);
+
+    positions = { { 330, 300 }, { 330 + 792 - MARKER_SIZE, 300 }, { 330 + 792 - MARKER_SIZE, 300 + 792 - MARKER_SIZE } };
+    color.rgb888_pixel = { 245, 245, 245 };
+    for (const Point<int32_t>& position : positions) {
+        int32_t margin[2] = { position.col - MARKER_SIZE / 6, position.row - MARKER_SIZE / 6 };
+        int32_t marginSize[2] = { MARKER_SIZE * 8 / 6, MARKER_SIZE * 8 / 6 };
+        drawRect(image, margin, marginSize, color, SHAPE_FILL, 0);
+    }
+    return image;
+}
+
+TEST(FiducialDetectorSuite, FindsMarkersByTheirCodes)
+{
+    std::vector<Point<int32_t>> positions;
+    image_t* image = baseplateFrame(positions);
+    for (uint32_t id = 0; id < FiducialDetector::FIDUCIAL_MARKER_COUNT; id++) {
+        FiducialDetector::drawMarker(image, id, positions[id], MARKER_SIZE);
+    }
+
+    FiducialDetector::Detection detection = FiducialDetector::detect(image);
+    ASSERT_EQ(detection.markers.size(), 3u);
+    for (const FiducialDetector::Marker& marker : detection.markers) {
+        EXPECT_EQ(marker.bitErrors, 0u);
+        // The corners lie on the outer edges of the marker pixels.
+        const Point<int32_t>& position = positions[marker.id];
+        EXPECT_NEAR(marker.corners[0].col, position.col - 0.5, 1.0) << "marker " << marker.id;
+        EXPECT_NEAR(marker.corners[0].row, position.row - 0.5, 1.0) << "marker " << marker.id;
+        EXPECT_NEAR(marker.corners[2].col, position.col + MARKER_SIZE - 0.5, 1.0) << "marker " << marker.id;
+        EXPECT_NEAR(marker.corners[2].row, position.row + MARKER_SIZE - 0.5, 1.0) << "marker " << marker.id;
+    }
+    // The outer corners of the baseplate, in the order of MarkerDetector::detectMarkers
+    const std::vector<Point<int32_t>> expected = { { 330, 300 }, { 1122, 300 }, { 1122, 1092 } };
+    std::vector<Point<int32_t>> points = FiducialDetector::detectMarkers(image);
+    ASSERT_EQ(points.size(), expected.size());
+    for (std::size_t i = 0; i < points.size(); i++) {
+        EXPECT_LE(points[i].distanceTo(expected[i]), 1) << "point " << i << " " << points[i].to_string();
+    }
+    deleteImage(image);
+}
+
+TEST(FiducialDetectorSuite, FindsTurnedMarkers)
+{
+    std::vector<Point<int32_t>> positions;
+    image_t* image = baseplateFrame(positions);
+    image_t* marker = newRGB888Image(MARKER_SIZE, MARKER_SIZE);
+    for (uint32_t id = 0; id < FiducialDetector::FIDUCIAL_MARKER_COUNT; id++) {
+        FiducialDetector::drawMarker(marker, id, { 0, 0 }, MARKER_SIZE);
+        // A quarter turn clockwise
+        for (int32_t row = 0; row < MARKER_SIZE; row++) {
+            for (int32_t col = 0; col < MARKER_SIZE; col++) {
+                setRGB888Pixel(image, positions[id].col + MARKER_SIZE - 1 - row, positions[id].row + col, getRGB888Pixel(marker, col, row));
+            }
+        }
+    }
+
+    FiducialDetector::Detection detection = FiducialDetector::detect(image);
+    ASSERT_EQ(detection.markers.size(), 3u);
+    for (const FiducialDetector::Marker& marker : detection.markers) {
+        // The left-top corner of the code turned to the right-top
+        const Point<int32_t>& position = positions[marker.id];
+        EXPECT_NEAR(marker.corners[0].col, position.col + MARKER_SIZE - 0.5, 1.0) << "marker " << marker.id;
+        EXPECT_NEAR(marker.corners[0].row, position.row - 0.5, 1.0) << "marker " << marker.id;
+    }
+    deleteImage(marker);
+    deleteImage(image);
+}
+
+TEST(FiducialDetectorSuite, IgnoresSquaresWithoutCode)
+{
+    // The markers in the test images are plain white squares.
+    image_t* image = ImageUtils::loadImageFromFile(CPPARAS_TEST_DATA_DIR "/corners1.jpg");
+    FiducialDetector::Detection detection = FiducialDetector::detect(image);
+    EXPECT_TRUE(detection.markers.empty());
+    EXPECT_TRUE(detection.points.empty());
+    deleteImage(image);
+
+    // A black square with a white center has a border, but no code.
+    std::vector<Point<int32_t>> positions;
+    image = baseplateFrame(positions);
+    pixel_t color;
+    for (const Point<int32_t>& position : positions) {
+        int32_t topLeft[2] = { position.col, position.row };
+        int32_t size[2] = { MARKER_SIZE, MARKER_SIZE };
+        color.rgb888_pixel = { 0, 0, 0 };
+        drawRect(image, topLeft, size, color, SHAPE_FILL, 0);
+        topLeft[0] += MARKER_SIZE / 6;
+        topLeft[1] += MARKER_SIZE / 6;
+        size[0] = size[1] = MARKER_SIZE * 4 / 6;
+        color.rgb888_pixel = { 255, 255, 255 };
+        drawRect(image, topLeft, size, color, SHAPE_FILL, 0);
+    }
+    EXPECT_TRUE(FiducialDetector::detect(image).markers.empty());
+    deleteImage(image);
+}
+
+TEST(FiducialDetectorSuite, OnePassTiming)
+{
+    // Only reported, the coded markers are found in one pass while the Harris path runs again for every threshold it tries.
+    for (const char* imgPath : { CPPARAS_TEST_DATA_DIR "/corners1.jpg", CPPARAS_TEST_DATA_DIR "/corners2.jpg" }) {
+        image_t* image = ImageUtils::loadImageFromFile(imgPath);
+        uint32_t attempts = 0;
+        const std::string name = std::string(imgPath).substr(std::string(imgPath).rfind('/') + 1);
+        RecordProperty(name + " harris us", fastestMicroseconds([&]() { attempts = MarkerDetector::detect(image).attempts; }, 5));
+        RecordProperty(name + " harris thresholds", (int)attempts);
+        RecordProperty(name + " fiducial us", fastestMicroseconds([&]() { FiducialDetector::detect(image); }, 5));
+        deleteImage(image);
+    }
+}
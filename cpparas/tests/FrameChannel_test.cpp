@@ -0,0 +1,123 @@
+#include "util/FrameChannel.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace cpparas;
+
+static void publish(FrameChannel& channel, uint8_t value)
+{
+    std::shared_ptr<Frame> frame = channel.acquire();
+    frame->getImage()->data[0] = value;
+    FrameInfo info;
+    info.sequence = value;
+    info.timestamp = CaptureClock::now();
+    frame->setInfo(info);
+    channel.publish(frame);
+}
+
+TEST(FrameChannelSuite, LatestSubscriberSkipsToNewestFrame)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY);
+    std::shared_ptr<FrameSubscriber> subscriber = channel->subscribe(DropPolicy::LATEST);
+    EXPECT_EQ(subscriber->tryTake(), nullptr);
+    for (uint8_t i = 1; i <= 3; i++) {
+        publish(*channel, i);
+    }
+    std::shared_ptr<const Frame> frame = subscriber->tryTake();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->getImage()->data[0], 3);
+    EXPECT_EQ(frame->getInfo().sequence, 3u);
+    EXPECT_EQ(subscriber->getDroppedFrames(), 2u);
+    // Nothing new since the last take
+    EXPECT_EQ(subscriber->tryTake(), nullptr);
+}
+
+TEST(FrameChannelSuite, NextSubscriberTakesFramesInOrder)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY, 3);
+    std::shared_ptr<FrameSubscriber> subscriber = channel->subscribe(DropPolicy::NEXT);
+    for (uint8_t i = 1; i <= 5; i++) {
+        publish(*channel, i);
+    }
+    // Only the last three frames are kept.
+    for (uint8_t i = 3; i <= 5; i++) {
+        std::shared_ptr<const Frame> frame = subscriber->tryTake();
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->getImage()->data[0], i);
+    }
+    EXPECT_EQ(subscriber->getDroppedFrames(), 2u);
+    EXPECT_EQ(subscriber->tryTake(), nullptr);
+}
+
+TEST(FrameChannelSuite, HeldFramesAreNeverOverwritten)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY, 1);
+    std::shared_ptr<FrameSubscriber> slowSubscriber = channel->subscribe(DropPolicy::LATEST);
+    std::shared_ptr<FrameSubscriber> fastSubscriber = channel->subscribe(DropPolicy::LATEST);
+    publish(*channel, 1);
+    std::shared_ptr<const Frame> held = slowSubscriber->tryTake();
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(fastSubscriber->tryTake(), held);
+    for (uint8_t i = 2; i <= 20; i++) {
+        publish(*channel, i);
+        std::shared_ptr<const Frame> frame = fastSubscriber->tryTake();
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->getImage()->data[0], i);
+        EXPECT_NE(frame, held);
+    }
+    EXPECT_EQ(held->getImage()->data[0], 1);
+    EXPECT_EQ(fastSubscriber->getDroppedFrames(), 0u);
+    // The held frame, the kept frame and the one the fast subscriber just dropped
+    EXPECT_LE(channel->getPool().getAllocatedFrames(), 3u);
+}
+
+TEST(FrameChannelSuite, NewSubscriberStartsAtNewestFrame)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY);
+    publish(*channel, 1);
+    publish(*channel, 2);
+    std::shared_ptr<FrameSubscriber> subscriber = channel->subscribe(DropPolicy::NEXT);
+    std::shared_ptr<const Frame> frame = subscriber->tryTake();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->getImage()->data[0], 2);
+    EXPECT_EQ(subscriber->getDroppedFrames(), 0u);
+}
+
+TEST(FrameChannelSuite, TakeWaitsForFrameOrClose)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY);
+    std::shared_ptr<FrameSubscriber> subscriber = channel->subscribe(DropPolicy::LATEST);
+    EXPECT_EQ(subscriber->take(std::chrono::milliseconds(10)), nullptr);
+
+    std::thread publisher([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        publish(*channel, 7);
+    });
+    std::shared_ptr<const Frame> frame = subscriber->take(std::chrono::milliseconds(5000));
+    publisher.join();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->getImage()->data[0], 7);
+
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        channel->close();
+    });
+    EXPECT_EQ(subscriber->take(std::chrono::milliseconds(5000)), nullptr);
+    closer.join();
+    EXPECT_TRUE(subscriber->isClosed());
+}
+
+TEST(FrameChannelSuite, RewindLetsNewestFrameBeTakenAgain)
+{
+    std::shared_ptr<FrameChannel> channel = FrameChannel::create(4, 4, FrameFormat::GRAY);
+    std::shared_ptr<FrameSubscriber> subscriber = channel->subscribe(DropPolicy::LATEST);
+    subscriber->rewind();
+    EXPECT_EQ(subscriber->tryTake(), nullptr);
+    publish(*channel, 1);
+    std::shared_ptr<const Frame> frame = subscriber->tryTake();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(subscriber->tryTake(), nullptr);
+    subscriber->rewind();
+    EXPECT_EQ(subscriber->tryTake(), frame);
+    EXPECT_EQ(subscriber->getDroppedFrames(), 0u);
+}
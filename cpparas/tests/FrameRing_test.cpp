@@ -0,0 +1,65 @@
+#include "util/FrameRing.hpp"
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+TEST(FrameRingSuite, NoFrameBeforeFirstCommit)
+{
+    FrameRing ring(4, 4);
+    RingFrame frame;
+    EXPECT_FALSE(ring.acquireLatest(frame));
+    EXPECT_EQ(ring.latestSequence(), 0u);
+}
+
+TEST(FrameRingSuite, ReaderGetsNewestFrame)
+{
+    FrameRing ring(4, 4);
+    for (int i = 0; i < 5; i++) {
+        image_t* slot = ring.beginWrite();
+        ASSERT_NE(slot, nullptr);
+        slot->data[0] = (uint8_t)i;
+        ring.commitWrite(CaptureClock::now());
+    }
+
+    RingFrame frame;
+    ASSERT_TRUE(ring.acquireLatest(frame));
+    EXPECT_EQ(frame.sequence, 5u);
+    EXPECT_EQ(frame.image->data[0], 4);
+    ring.release(frame);
+}
+
+TEST(FrameRingSuite, WriterNeverTouchesHeldFrame)
+{
+    FrameRing ring(4, 4);
+    image_t* slot = ring.beginWrite();
+    slot->data[0] = 42;
+    ring.commitWrite(CaptureClock::now());
+
+    RingFrame held;
+    ASSERT_TRUE(ring.acquireLatest(held));
+    for (int i = 0; i < 10; i++) {
+        image_t* writeSlot = ring.beginWrite();
+        ASSERT_NE(writeSlot, nullptr) << "writer ran out of slots at frame " << i;
+        EXPECT_NE(writeSlot, held.image) << "writer was handed the slot that is held by the reader";
+        writeSlot->data[0] = 0;
+        ring.commitWrite(CaptureClock::now());
+    }
+    EXPECT_EQ(held.image->data[0], 42);
+    EXPECT_EQ(held.sequence, 1u);
+    EXPECT_EQ(ring.latestSequence(), 11u);
+    ring.release(held);
+}
+
+TEST(FrameRingSuite, AbortedWriteIsNotPublished)
+{
+    FrameRing ring(4, 4);
+    ring.beginWrite();
+    ring.commitWrite(CaptureClock::now());
+    ring.beginWrite();
+    ring.abortWrite();
+
+    RingFrame frame;
+    ASSERT_TRUE(ring.acquireLatest(frame));
+    EXPECT_EQ(frame.sequence, 1u);
+    ring.release(frame);
+}
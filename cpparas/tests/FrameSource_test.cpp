@@ -0,0 +1,441 @@
+#include "DirectorySource.hpp"
+#include "MarkerDetector.hpp"
+#include "RawStreamSource.hpp"
+#include "StillImageSource.hpp"
+#include "SyntheticSource.hpp"
+#include "operators.h"
+#include "util/ImageUtils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace cpparas;
+
+TEST(FrameSourceSuite, RawStreamStopsAfterLastFrameWithoutLoop)
+{
+    const uint32_t cols = 8;
+    const uint32_t rows = 4;
+    const std::string path = "framesource_test.rgb";
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    for (uint8_t i = 0; i < 3; i++) {
+        std::vector<uint8_t> frame(cols * rows * 3, i + 1);
+        fwrite(frame.data(), 1, frame.size(), file);
+    }
+    fclose(file);
+
+    // Without looping, the source stops after the last frame.
+    RawStreamSource source(path, cols, rows, FRAME_RATE_UNLIMITED, false);
+    source.start();
+    while (source.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(source.getFrame(), nullptr);
+    remove(path.c_str());
+}
+
+TEST(FrameSourceSuite, RawStreamDeliversNewestFrame)
+{
+    const uint32_t cols = 8;
+    const uint32_t rows = 4;
+    const std::string path = "framesource_test_loop.rgb";
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::vector<uint8_t> frame(cols * rows * 3, 7);
+    fwrite(frame.data(), 1, frame.size(), file);
+    fclose(file);
+
+    RawStreamSource source(path, cols, rows, FRAME_RATE_UNLIMITED);
+    source.start();
+    image_t* img = source.getFrame();
+    ASSERT_NE(img, nullptr);
+    EXPECT_EQ(img->cols, cols);
+    EXPECT_EQ(img->rows, rows);
+    EXPECT_EQ(img->data[0], 7);
+    uint64_t firstSequence = source.getFrameInfo().sequence;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_NE(source.getFrame(), nullptr);
+    EXPECT_GT(source.getFrameInfo().sequence, firstSequence);
+    source.stop();
+    remove(path.c_str());
+}
+
+TEST(FrameSourceSuite, MissingFilesStopTheSource)
+{
+    RawStreamSource rawSource("does-not-exist.rgb", 8, 4, FRAME_RATE_UNLIMITED);
+    rawSource.start();
+    EXPECT_FALSE(rawSource.isRunning());
+    EXPECT_EQ(rawSource.getFrame(), nullptr);
+
+    DirectorySource directorySource("does-not-exist", FRAME_RATE_UNLIMITED);
+    directorySource.start();
+    EXPECT_FALSE(directorySource.isRunning());
+}
+
+TEST(FrameSourceSuite, RawStreamFormatFollowsTheExtension)
+{
+    FrameFormat format = FrameFormat::GRAY;
+    EXPECT_TRUE(RawStreamSource::formatOfFile("/tmp/capture.rgb", format));
+    EXPECT_EQ(format, FrameFormat::RGB888);
+    EXPECT_TRUE(RawStreamSource::formatOfFile("capture.YUV", format));
+    EXPECT_EQ(format, FrameFormat::YUV420);
+    EXPECT_TRUE(RawStreamSource::formatOfFile("capture.gray", format));
+    EXPECT_EQ(format, FrameFormat::GRAY);
+    EXPECT_FALSE(RawStreamSource::formatOfFile("corners1.jpg", format));
+    EXPECT_FALSE(RawStreamSource::formatOfFile("capture", format));
+    EXPECT_EQ(format, FrameFormat::GRAY);
+}
+
+TEST(FrameSourceSuite, DirectoryFramesAreSorted)
+{
+    std::vector<std::string> frames = DirectorySource::listFrames(CPPARAS_TEST_DATA_DIR);
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0], CPPARAS_TEST_DATA_DIR "/corners1.jpg");
+    EXPECT_EQ(frames[1], CPPARAS_TEST_DATA_DIR "/corners2.jpg");
+    EXPECT_EQ(frames[2], CPPARAS_TEST_DATA_DIR "/loadimage.png");
+}
+
+TEST(FrameSourceSuite, DirectoryFramesHaveTheSizeOfTheFirstFrame)
+{
+    image_t* firstFrame = ImageUtils::loadImageFromFile(CPPARAS_TEST_DATA_DIR "/corners1.jpg");
+    DirectorySource source(CPPARAS_TEST_DATA_DIR, FRAME_RATE_UNLIMITED, false);
+    source.start();
+    image_t* img = source.getFrame();
+    ASSERT_NE(img, nullptr);
+    EXPECT_EQ(img->cols, firstFrame->cols);
+    EXPECT_EQ(img->rows, firstFrame->rows);
+    source.stop();
+    deleteImage(firstFrame);
+}
+
+TEST(FrameSourceSuite, FrameRateIsApplied)
+{
+    SyntheticSource source(64, 64, 50.0);
+    source.start();
+    source.getFrame();
+    uint64_t firstSequence = source.getFrameInfo().sequence;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    source.getFrame();
+    uint64_t frames = source.getFrameInfo().sequence - firstSequence;
+    source.stop();
+    // 10 frames are due, leave some room for a slow build machine.
+    EXPECT_GE(frames, 5u);
+    EXPECT_LE(frames, 11u);
+}
+
+TEST(FrameSourceSuite, RGB888FramesAreConvertedToYUV420)
+{
+    const rgb888_pixel_t color = { 200, 150, 120 };
+    image_t* img = newRGB888Image(9, 7);
+    for (int32_t row = 0; row < img->rows; row++) {
+        for (int32_t col = 0; col < img->cols; col++) {
+            setRGB888Pixel(img, col, row, color);
+        }
+    }
+    StillImageSource source(img, FRAME_RATE_UNLIMITED);
+    deleteImage(img);
+    source.setFormat(FrameFormat::YUV420);
+    source.start();
+    image_t* luma = source.getFrame();
+    ASSERT_NE(luma, nullptr);
+    ASSERT_NE(source.getChromaU(), nullptr);
+    ASSERT_NE(source.getChromaV(), nullptr);
+    EXPECT_EQ(luma->type, IMGTYPE_BASIC);
+    EXPECT_EQ(luma->cols, 8);
+    EXPECT_EQ(luma->rows, 6);
+    EXPECT_EQ(source.getChromaU()->cols, 4);
+    EXPECT_EQ(source.getChromaU()->rows, 3);
+    EXPECT_NEAR(luma->data[0], 162, 1);
+
+    // Only the region is converted back to RGB.
+    image_t* region = newRGB888Image(4, 4);
+    int32_t colpos[3] = { 0, 7, 7 };
+    int32_t rowpos[3] = { 0, 0, 5 };
+    warpYUV420(luma, source.getChromaU(), source.getChromaV(), region, colpos, rowpos);
+    rgb888_pixel_t pixel = getRGB888Pixel(region, 1, 1);
+    EXPECT_NEAR(pixel.r, color.r, 3);
+    EXPECT_NEAR(pixel.g, color.g, 3);
+    EXPECT_NEAR(pixel.b, color.b, 3);
+    deleteImage(region);
+    source.stop();
+}
+
+TEST(FrameSourceSuite, SyntheticMarkersAreDetected)
+{
+    SyntheticSource source(1440, 1440, FRAME_RATE_UNLIMITED);
+    source.setHandPresent(true);
+    source.start();
+    image_t* img = source.getFrame();
+    ASSERT_NE(img, nullptr);
+    std::vector<Point<int32_t>> corners = MarkerDetector::detectMarkers(img);
+    std::vector<Point<int32_t>> expected = source.getMarkerCorners();
+    source.stop();
+
+    // The corners are refined to the sharp marker corners in the full resolution frame.
+    const int32_t maxDeviation = 2;
+    ASSERT_EQ(corners.size(), expected.size());
+    for (std::size_t i = 0; i < corners.size(); i++) {
+        EXPECT_LE(corners[i].distanceTo(expected[i]), maxDeviation) << "point " << i << " " << corners[i].to_string() << " and " << expected[i].to_string() << " are not equal";
+    }
+}
+
+TEST(FrameSourceSuite, PreviewFramesAreScaledDown)
+{
+    image_t* img = newRGB888Image(1440, 960);
+    erase(img);
+    StillImageSource source(img, FRAME_RATE_UNLIMITED);
+    deleteImage(img);
+    source.setFormat(FrameFormat::YUV420);
+    source.start();
+    image_t* frame = source.getFrame();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->cols, 1440);
+
+    source.setStreamMode(StreamMode::PREVIEW);
+    // The frames in the new mode come in on the capture thread.
+    for (int i = 0; i < 100 && frame->cols != 480; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = source.getFrame();
+        ASSERT_NE(frame, nullptr);
+    }
+    EXPECT_EQ(frame->cols, 480);
+    EXPECT_EQ(frame->rows, 320);
+    EXPECT_EQ(source.getChromaU()->cols, 240);
+    // The preview still shows the full field of view.
+    EXPECT_EQ(source.getFrameInfo().fieldOfView.width, 1440);
+    EXPECT_EQ(source.getFrameInfo().fieldOfView.height, 960);
+    uint64_t previewSequence = source.getFrameInfo().sequence;
+
+    source.setStreamMode(StreamMode::FULL);
+    for (int i = 0; i < 100 && frame->cols != 1440; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = source.getFrame();
+        ASSERT_NE(frame, nullptr);
+    }
+    EXPECT_EQ(frame->cols, 1440);
+    // Sequence numbers continue over both modes.
+    EXPECT_GT(source.getFrameInfo().sequence, previewSequence);
+    source.stop();
+}
+
+TEST(FrameSourceSuite, RegionOfInterestIsCropped)
+{
+    image_t* img = newBasicImage(64, 48);
+    for (int32_t row = 0; row < img->rows; row++) {
+        for (int32_t col = 0; col < img->cols; col++) {
+            setBasicPixel(img, col, row, (uint8_t)(col + row));
+        }
+    }
+    image_t* rgb = newRGB888Image(img->cols, img->rows);
+    convertImage(img, rgb);
+    deleteImage(img);
+    StillImageSource source(rgb, FRAME_RATE_UNLIMITED);
+    deleteImage(rgb);
+    source.setFormat(FrameFormat::YUV420);
+    source.start();
+    EXPECT_EQ(source.getFullCols(), 64u);
+    EXPECT_EQ(source.getFullRows(), 48u);
+
+    // The odd origin is aligned for the chroma planes, and the region is clamped to the frame.
+    source.setRegionOfInterest({ { 11, 20 }, 70, 10 });
+    image_t* frame = source.getFrame();
+    for (int i = 0; i < 100 && frame->cols == 64; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = source.getFrame();
+        ASSERT_NE(frame, nullptr);
+    }
+    const Rect<int32_t>& fieldOfView = source.getFrameInfo().fieldOfView;
+    EXPECT_EQ(fieldOfView.origin.col, 10);
+    EXPECT_EQ(fieldOfView.origin.row, 20);
+    EXPECT_EQ(fieldOfView.width, 54);
+    EXPECT_EQ(fieldOfView.height, 10);
+    EXPECT_EQ(frame->cols, 54);
+    EXPECT_EQ(frame->rows, 10);
+    EXPECT_EQ(source.getChromaU()->cols, 27);
+    EXPECT_NEAR(getBasicPixel(frame, 5, 3), 10 + 5 + 20 + 3, 1);
+
+    // An empty region captures the whole frame again.
+    source.setRegionOfInterest({ { 0, 0 }, 0, 0 });
+    for (int i = 0; i < 100 && frame->cols != 64; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = source.getFrame();
+        ASSERT_NE(frame, nullptr);
+    }
+    EXPECT_EQ(frame->cols, 64);
+    source.stop();
+}
+
+// Captures regions itself like the camera, the pixels hold their column in the full frame.
+class RegionCapturingSource : public FrameSource {
+public:
+    RegionCapturingSource()
+        : FrameSource(200.0, FrameFormat::GRAY)
+        , restarts(0)
+        , captured({ { 0, 0 }, 96, 96 })
+    {
+    }
+    ~RegionCapturingSource() override
+    {
+        stop();
+    }
+    std::atomic<uint32_t> restarts;
+
+protected:
+    bool open() override
+    {
+        setFrameSize(96, 96);
+        captured = { { 0, 0 }, 96, 96 };
+        return true;
+    }
+    bool readFrame(image_t* dst) override
+    {
+        EXPECT_EQ(dst->cols, captured.width);
+        EXPECT_EQ(dst->rows, captured.height);
+        for (int32_t row = 0; row < dst->rows; row++) {
+            for (int32_t col = 0; col < dst->cols; col++) {
+                setBasicPixel(dst, col, row, (uint8_t)(captured.origin.col + col));
+            }
+        }
+        return true;
+    }
+    void close() override
+    {
+    }
+    uint32_t warmupFrames() const override
+    {
+        return 2;
+    }
+    FrameFormat nativeFormat() const override
+    {
+        return FrameFormat::GRAY;
+    }
+    bool configureStream(StreamMode mode, const Rect<int32_t>& region, uint32_t cols, uint32_t rows, Rect<int32_t>& nativeRegion) override
+    {
+        (void)mode;
+        (void)cols;
+        (void)rows;
+        if (region.origin.col != captured.origin.col || region.origin.row != captured.origin.row || region.width != captured.width || region.height != captured.height) {
+            captured = region;
+            restarts++;
+        }
+        nativeRegion = captured;
+        return true;
+    }
+
+private:
+    Rect<int32_t> captured;
+};
+
+// Waits until the source delivers frames of the given width.
+static image_t* frameOfWidth(FrameSource& source, int32_t cols)
+{
+    image_t* frame = source.getFrame();
+    for (int i = 0; i < 200 && frame->cols != cols; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = source.getFrame();
+    }
+    EXPECT_EQ(frame->cols, cols);
+    return frame;
+}
+
+TEST(FrameSourceSuite, PreviewIsScaledDownFromTheCapturedRegion)
+{
+    RegionCapturingSource source;
+    source.start();
+    source.setRegionOfInterest({ { 30, 0 }, 60, 60 });
+    image_t* frame = frameOfWidth(source, 60);
+    EXPECT_EQ(getBasicPixel(frame, 10, 5), 40);
+    EXPECT_EQ(source.restarts, 1u);
+    EXPECT_EQ(source.getStatistics().warmupFrames, 4u);
+
+    // Switching the mode keeps the backend stream and its warm-up
+    source.setStreamMode(StreamMode::PREVIEW);
+    frame = frameOfWidth(source, 20);
+    EXPECT_EQ(frame->rows, 20);
+    EXPECT_EQ(getBasicPixel(frame, 2, 1), 36);
+    EXPECT_EQ(source.getFrameInfo().fieldOfView.origin.col, 30);
+    source.setStreamMode(StreamMode::FULL);
+    frameOfWidth(source, 60);
+    EXPECT_EQ(source.restarts, 1u);
+    EXPECT_EQ(source.getStatistics().warmupFrames, 4u);
+    source.stop();
+}
+
+TEST(FrameSourceSuite, StatisticsCountCapturedAndSkippedFrames)
+{
+    SyntheticSource source(64, 64, 200.0);
+    source.start();
+    ASSERT_NE(source.getFrame(), nullptr);
+    uint64_t firstSequence = source.getFrameInfo().sequence;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_NE(source.getFrame(), nullptr);
+    uint64_t lastSequence = source.getFrameInfo().sequence;
+    source.stop();
+
+    CaptureStatistics statistics = source.getStatistics();
+    EXPECT_EQ(statistics.consumedFrames, 2u);
+    EXPECT_EQ(statistics.skippedFrames, lastSequence - firstSequence - 1);
+    EXPECT_GE(statistics.capturedFrames, lastSequence - firstSequence + 1);
+    EXPECT_EQ(statistics.frameInterval.getCount(), statistics.capturedFrames - 1);
+    EXPECT_EQ(statistics.readDuration.getCount(), statistics.capturedFrames);
+    EXPECT_EQ(statistics.readerLag.getCount(), 2u);
+    // 5 ms between frames, leave some room for a slow build machine.
+    EXPECT_GT(statistics.frameInterval.getMean(), 3.0);
+    EXPECT_LT(statistics.frameInterval.getMean(), 20.0);
+
+    source.resetStatistics();
+    EXPECT_EQ(source.getStatistics().capturedFrames, 0u);
+}
+
+TEST(FrameSourceSuite, WaitForFrameWakesOnNewFrames)
+{
+    SyntheticSource source(64, 64, 20.0);
+    source.start();
+    ASSERT_NE(source.getFrame(), nullptr);
+    uint64_t sequence = source.getFrameInfo().sequence;
+    // A new frame is due after 50 ms.
+    EXPECT_TRUE(source.waitForFrame(sequence, std::chrono::milliseconds(5000)));
+    ASSERT_NE(source.getFrame(), nullptr);
+    EXPECT_GT(source.getFrameInfo().sequence, sequence);
+
+    // A woken reader returns before the next frame is due.
+    sequence = source.getFrameInfo().sequence + 1000;
+    std::thread waker([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        source.wakeReader();
+    });
+    CaptureClock::time_point waitStart = CaptureClock::now();
+    EXPECT_FALSE(source.waitForFrame(sequence, std::chrono::milliseconds(5000)));
+    EXPECT_LT(CaptureClock::now() - waitStart, std::chrono::milliseconds(2000));
+    waker.join();
+
+    source.stop();
+    EXPECT_FALSE(source.waitForFrame(sequence, std::chrono::milliseconds(5000)));
+}
+
+TEST(FrameSourceSuite, StillImagesArePublishedOnce)
+{
+    image_t* img = newRGB888Image(8, 4);
+    erase(img);
+    StillImageSource source(img, 200.0);
+    deleteImage(img);
+    EXPECT_TRUE(source.deliversStillFrames());
+    source.start();
+    ASSERT_NE(source.getFrame(), nullptr);
+    uint64_t sequence = source.getFrameInfo().sequence;
+    // At 200 fps ten frames would be due, but they would all show the same picture.
+    EXPECT_FALSE(source.waitForFrame(sequence, std::chrono::milliseconds(50)));
+    EXPECT_EQ(source.getStatistics().capturedFrames, 1u);
+
+    // Another region is published once
+    source.setRegionOfInterest({ { 2, 0 }, 4, 4 });
+    EXPECT_TRUE(source.waitForFrame(sequence, std::chrono::milliseconds(5000)));
+    ASSERT_NE(source.getFrame(), nullptr);
+    EXPECT_EQ(source.getFrame()->cols, 4);
+    sequence = source.getFrameInfo().sequence;
+    EXPECT_FALSE(source.waitForFrame(sequence, std::chrono::milliseconds(50)));
+    EXPECT_EQ(source.getStatistics().capturedFrames, 2u);
+    source.stop();
+}
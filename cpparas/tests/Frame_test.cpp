@@ -0,0 +1,78 @@
+#include "util/Frame.hpp"
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+TEST(FrameSuite, FramesGoBackToPoolWhenUnreferenced)
+{
+    std::shared_ptr<FramePool> pool = FramePool::create(8, 6, FrameFormat::RGB888);
+    std::shared_ptr<Frame> frame = pool->acquire();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->getImage()->cols, 8u);
+    EXPECT_EQ(frame->getImage()->rows, 6u);
+    const image_t* image = frame->getImage();
+
+    std::shared_ptr<const Frame> reader = frame;
+    frame.reset();
+    EXPECT_EQ(pool->getFreeFrames(), 0u);
+    // A second frame is allocated while the first one is still referenced
+    std::shared_ptr<Frame> second = pool->acquire();
+    EXPECT_NE(second->getImage(), image);
+    EXPECT_EQ(pool->getAllocatedFrames(), 2u);
+
+    reader.reset();
+    EXPECT_EQ(pool->getFreeFrames(), 1u);
+    std::shared_ptr<Frame> reused = pool->acquire();
+    EXPECT_EQ(reused->getImage(), image);
+    EXPECT_EQ(reused->getInfo().sequence, 0u);
+    EXPECT_EQ(pool->getAllocatedFrames(), 2u);
+}
+
+TEST(FrameSuite, FramesMayOutliveThePool)
+{
+    std::shared_ptr<FramePool> pool = FramePool::create(4, 4, FrameFormat::YUV420);
+    std::shared_ptr<Frame> frame = pool->acquire();
+    FrameInfo info;
+    info.sequence = 5;
+    frame->setInfo(info);
+    pool.reset();
+    EXPECT_EQ(frame->getInfo().sequence, 5u);
+    frame->getImage()->data[0] = 1;
+    frame.reset();
+}
+
+TEST(FrameSuite, HSVImageIsConvertedOnceForAllReaders)
+{
+    std::shared_ptr<FramePool> pool = FramePool::create(8, 6, FrameFormat::RGB888);
+    std::shared_ptr<Frame> frame = pool->acquire();
+    for (int32_t row = 0; row < 6; row++) {
+        for (int32_t col = 0; col < 8; col++) {
+            setRGB888Pixel(frame->getImage(), col, row, { 200, 100, (uint8_t)(col * 20) });
+        }
+    }
+    std::shared_ptr<const Frame> reader = frame;
+    const image_t* hsv = reader->getHSVImage();
+    ASSERT_NE(hsv, nullptr);
+    EXPECT_EQ(hsv->type, IMGTYPE_HSV);
+    hsv_pixel_t pixel = getHSVPixel(hsv, 0, 0);
+    EXPECT_EQ(pixel.h, 30u);
+    EXPECT_EQ(pixel.s, 100u);
+    EXPECT_EQ(pixel.v, 78u);
+
+    // A second reader gets the same conversion, even when the image changed since.
+    setRGB888Pixel(frame->getImage(), 0, 0, { 0, 0, 255 });
+    std::shared_ptr<const Frame> other = frame;
+    EXPECT_EQ(other->getHSVImage(), hsv);
+    EXPECT_EQ(getHSVPixel(other->getHSVImage(), 0, 0).h, 30u);
+
+    // A reused frame is converted again, unless its writer provides the HSV image.
+    frame.reset();
+    reader.reset();
+    other.reset();
+    std::shared_ptr<Frame> reused = pool->acquire();
+    EXPECT_EQ(getHSVPixel(reused->getHSVImage(), 0, 0).h, 240u);
+    reused.reset();
+    reused = pool->acquire();
+    setHSVPixel(reused->provideHSVImage(), 0, 0, { 120, 50, 50 });
+    EXPECT_EQ(getHSVPixel(static_cast<const Frame&>(*reused).getHSVImage(), 0, 0).h, 120u);
+}
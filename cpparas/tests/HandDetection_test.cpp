@@ -0,0 +1,56 @@
+#include "HandDetection.hpp"
+#include "operators.h"
+#include "operators_hsv.h"
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+static const rgb888_pixel_t SKIN = { 178, 132, 116 };
+
+// Draws a square of skin colored pixels (H 15, S 35%, V 70%) on a black frame, and returns its HSV image.
+static image_t* frameWithSkin(int32_t size)
+{
+    image_t* image = newRGB888Image(400, 400);
+    const rgb888_pixel_t black = { 0, 0, 0 };
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            setRGB888Pixel(image, col, row, row >= 100 && row < 100 + size && col >= 100 && col < 100 + size ? SKIN : black);
+        }
+    }
+    image_t* hsv = newHSVImage(image->cols, image->rows);
+    convertToHSVImage(image, hsv);
+    deleteImage(image);
+    return hsv;
+}
+
+TEST(HandDetectionSuite, HandAreaIsCountedInFramePixels)
+{
+    HandDetection detection;
+    // 14400 pixels, more than the threshold area
+    image_t* large = frameWithSkin(120);
+    detection.update(large);
+    EXPECT_TRUE(detection.containsHand());
+    deleteImage(large);
+
+    // 6400 pixels
+    image_t* small = frameWithSkin(80);
+    detection.update(small);
+    EXPECT_FALSE(detection.containsHand());
+    deleteImage(small);
+}
+
+TEST(HandDetectionSuite, SkinColoredSpecksAreNoHand)
+{
+    HandDetection detection;
+    // Single pixels of skin color all over the frame, more of them than the threshold area
+    image_t* specks = frameWithSkin(0);
+    const hsv_pixel_t skin = rgb888ToHSV(SKIN);
+    for (int32_t row = 0; row < specks->rows; row += 3) {
+        for (int32_t col = 0; col < specks->cols; col += 3) {
+            setHSVPixel(specks, col, row, skin);
+        }
+    }
+    detection.update(specks);
+    EXPECT_FALSE(detection.containsHand());
+    deleteImage(specks);
+}
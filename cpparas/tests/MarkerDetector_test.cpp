@@ -1,7 +1,11 @@
 #include "MarkerDetector.hpp"
+#include "Timing.hpp"
 #include "operators.h"
 #include "types/Point.hpp"
 #include "util/ImageUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <gtest/gtest.h>
 
 using namespace cpparas;
@@ -18,14 +22,14 @@ TEST(MarkerDetectorSuite, DetectMarkers)
     }
 
     const std::vector<std::vector<Point<int32_t>>> expectedResults = {
-        { { 178, 282 },
-            { 968, 320 },
-            { 944, 1080 } },
-        { { 362, 218 },
-            { 1160, 232 },
-            { 1120, 1016 } }
+        { { 167, 273 },
+            { 976, 309 },
+            { 954, 1093 } },
+        { { 349, 203 },
+            { 1164, 219 },
+            { 1130, 1026 } }
     };
-    const int32_t maxDeviation = 10;
+    const int32_t maxDeviation = 2;
 
     std::vector<std::vector<Point<int32_t>>> results;
     for (const image_t* image : images) {
@@ -40,3 +44,326 @@ TEST(MarkerDetectorSuite, DetectMarkers)
         deleteImage(images[idx]);
     }
 }
+
+TEST(MarkerDetectorSuite, DetectMarkersOnLuma)
+{
+    image_t* image = ImageUtils::loadImageFromFile(CPPARAS_TEST_DATA_DIR "/corners1.jpg");
+    image_t* luma = newBasicImage(image->cols & ~1, image->rows & ~1);
+    convertRGB888ToYUV420(image, luma, NULL, NULL);
+
+    const std::vector<Point<int32_t>> expectedResult = { { 167, 273 }, { 976, 309 }, { 954, 1093 } };
+    const int32_t maxDeviation = 2;
+    std::vector<Point<int32_t>> result = MarkerDetector::detectMarkers(luma);
+
+    ASSERT_EQ(result.size(), expectedResult.size());
+    for (std::size_t i = 0; i < result.size(); i++) {
+        EXPECT_LE(result[i].distanceTo(expectedResult[i]), maxDeviation) << "point " << i << " " << result[i].to_string() << " and " << expectedResult[i].to_string() << " are not equal";
+    }
+    deleteImage(luma);
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, HistogramLevelsSplitTwoClasses)
+{
+    // A dark half around 40 and a bright half around 200
+    image_t* image = newBasicImage(64, 64);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            setBasicPixel(image, col, row, (col < 32 ? 40 : 200) + (row % 5) - 2);
+        }
+    }
+    uint32_t hist[256];
+    histogram32(image, hist);
+    // Rows 2, 7, ..., 62 of the dark half
+    EXPECT_EQ(hist[40], 13u * 32);
+
+    uint8_t otsu = thresholdOtsuLevel(hist);
+    uint8_t twoMeans = threshold2MeansLevel(hist);
+    EXPECT_GE(otsu, 42);
+    EXPECT_LT(otsu, 198);
+    EXPECT_NEAR(twoMeans, 120, 2);
+
+    // The bright half is outside the dark range
+    image_t* binary = newBasicImage(image->cols, image->rows);
+    thresholdOtsu(image, binary, DARK);
+    EXPECT_EQ(getBasicPixel(binary, 0, 0), 0);
+    EXPECT_EQ(getBasicPixel(binary, 63, 0), 1);
+    deleteImage(binary);
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, HistogramSelectionFindsMarkers)
+{
+    // The markers are found at one of the first two histogram levels, also in a dim frame whose markers lie below every sweep threshold
+    const uint32_t maxAttempts = 2;
+    const std::vector<const char*> imgPaths = {
+        CPPARAS_TEST_DATA_DIR "/corners1.jpg",
+        CPPARAS_TEST_DATA_DIR "/corners2.jpg",
+    };
+    for (const char* imgPath : imgPaths) {
+        image_t* image = ImageUtils::loadImageFromFile(imgPath);
+        MarkerDetector::Detection sweep = MarkerDetector::detect(image, MarkerDetector::ThresholdSelection::SWEEP);
+        MarkerDetector::Detection histogram = MarkerDetector::detect(image, MarkerDetector::ThresholdSelection::HISTOGRAM);
+
+        ASSERT_EQ(histogram.points.size(), 3u) << imgPath;
+        ASSERT_EQ(sweep.points.size(), 3u) << imgPath;
+        EXPECT_LE(histogram.attempts, maxAttempts) << imgPath;
+        // The refined corners don't depend on the threshold
+        for (std::size_t i = 0; i < histogram.corners.size(); i++) {
+            EXPECT_LE(histogram.corners[i].distanceTo(sweep.corners[i]), 1.0) << imgPath << " point " << i;
+        }
+
+        image_t* dim = newRGB888Image(image->cols, image->rows);
+        for (int32_t row = 0; row < image->rows; row++) {
+            for (int32_t col = 0; col < image->cols; col++) {
+                rgb888_pixel_t pixel = getRGB888Pixel(image, col, row);
+                setRGB888Pixel(dim, col, row, { (uint8_t)(pixel.r * 4 / 5), (uint8_t)(pixel.g * 4 / 5), (uint8_t)(pixel.b * 4 / 5) });
+            }
+        }
+        sweep = MarkerDetector::detect(dim, MarkerDetector::ThresholdSelection::SWEEP);
+        histogram = MarkerDetector::detect(dim, MarkerDetector::ThresholdSelection::HISTOGRAM);
+        ASSERT_EQ(histogram.points.size(), 3u) << imgPath << " dimmed";
+        EXPECT_LE(histogram.attempts, maxAttempts) << imgPath << " dimmed";
+        EXPECT_GT(sweep.attempts, maxAttempts) << imgPath << " dimmed";
+        deleteImage(dim);
+        deleteImage(image);
+    }
+}
+
+TEST(MarkerDetectorSuite, ConcurrentDetectionMatchesInOrder)
+{
+    const std::vector<const char*> imgPaths = {
+        CPPARAS_TEST_DATA_DIR "/corners1.jpg",
+        CPPARAS_TEST_DATA_DIR "/corners2.jpg",
+    };
+    for (const char* imgPath : imgPaths) {
+        image_t* image = ImageUtils::loadImageFromFile(imgPath);
+        for (MarkerDetector::ThresholdSelection selection : { MarkerDetector::ThresholdSelection::SWEEP, MarkerDetector::ThresholdSelection::HISTOGRAM }) {
+            MarkerDetector::Detection inOrder = MarkerDetector::detect(image, selection, 1);
+            EXPECT_EQ(inOrder.evaluated, inOrder.attempts);
+            for (uint32_t workers : { 2u, 4u }) {
+                MarkerDetector::Detection concurrent = MarkerDetector::detect(image, selection, workers);
+                ASSERT_EQ(concurrent.points.size(), 3u) << imgPath;
+                EXPECT_EQ(concurrent.points, inOrder.points) << imgPath;
+                EXPECT_EQ(concurrent.threshold, inOrder.threshold) << imgPath;
+                EXPECT_EQ(concurrent.attempts, inOrder.attempts) << imgPath;
+                EXPECT_GE(concurrent.evaluated, concurrent.attempts) << imgPath;
+            }
+        }
+        deleteImage(image);
+    }
+
+    // Without markers every threshold is tried, and the last one is reported
+    image_t* blank = newBasicImage(720, 720);
+    erase(blank);
+    MarkerDetector::Detection inOrder = MarkerDetector::detect(blank, MarkerDetector::ThresholdSelection::SWEEP, 1);
+    MarkerDetector::Detection concurrent = MarkerDetector::detect(blank, MarkerDetector::ThresholdSelection::SWEEP, 4);
+    EXPECT_TRUE(concurrent.points.empty());
+    EXPECT_EQ(concurrent.threshold, inOrder.threshold);
+    EXPECT_EQ(concurrent.attempts, inOrder.attempts);
+    EXPECT_EQ(concurrent.evaluated, inOrder.attempts);
+    deleteImage(blank);
+}
+
+// A bright square of 40 pixels at (left, top) on a dark image of 180x180 pixels, like the corner image of the detector
+static image_t* squareImage(int32_t left, int32_t top)
+{
+    image_t* image = newBasicImage(180, 180);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            bool inside = col >= left && col < left + 40 && row >= top && row < top + 40;
+            setBasicPixel(image, col, row, inside ? 200 : 20);
+        }
+    }
+    return image;
+}
+
+TEST(MarkerDetectorSuite, CornerResponseFindsSquareCorners)
+{
+    image_t* image = squareImage(60, 50);
+    corner_scratch_t* scratch = newCornerScratch(image->cols, image->rows);
+    corner_t corners[64];
+    uint32_t found = cornerResponse(image, scratch, CORNER_HARRIS, 7, 0.04f, 0, corners, 64);
+    ASSERT_EQ(found, 64u);
+    for (uint32_t i = 1; i < found; i++) {
+        EXPECT_GE(corners[i - 1].response, corners[i].response);
+    }
+
+    // The strongest responses lie around the four corners of the square
+    const std::vector<Point<int32_t>> squareCorners = { { 60, 50 }, { 99, 50 }, { 60, 89 }, { 99, 89 } };
+    std::vector<bool> seen(squareCorners.size(), false);
+    for (uint32_t i = 0; i < 16; i++) {
+        Point<int32_t> corner = { corners[i].col, corners[i].row };
+        double nearest = 1e9;
+        for (std::size_t j = 0; j < squareCorners.size(); j++) {
+            double distance = corner.distanceTo(squareCorners[j]);
+            nearest = std::min(nearest, distance);
+            seen[j] = seen[j] || distance <= 3;
+        }
+        EXPECT_LE(nearest, 3) << corner.to_string();
+    }
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 4);
+
+    // Moving the square moves the responses without changing them
+    image_t* moved = squareImage(70, 60);
+    corner_t movedCorners[64];
+    ASSERT_EQ(cornerResponse(moved, scratch, CORNER_HARRIS, 7, 0.04f, 0, movedCorners, 64), found);
+    EXPECT_EQ(movedCorners[0].response, corners[0].response);
+
+    // The smallest eigenvalue is largest at the corners as well
+    ASSERT_GT(cornerResponse(image, scratch, CORNER_SHI_TOMASI, 5, 0.0f, 0, corners, 4), 0u);
+    Point<int32_t> strongest = { corners[0].col, corners[0].row };
+    double nearest = 1e9;
+    for (const Point<int32_t>& squareCorner : squareCorners) {
+        nearest = std::min<double>(nearest, strongest.distanceTo(squareCorner));
+    }
+    EXPECT_LE(nearest, 3);
+
+    deleteImage(moved);
+    deleteCornerScratch(scratch);
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, CornerResponseSuppressesNonMaxima)
+{
+    image_t* image = squareImage(60, 50);
+    corner_scratch_t* scratch = newCornerScratch(image->cols, image->rows);
+    corner_t corners[16];
+
+    // One corner for every corner of the square, instead of the pixels around the strongest one
+    ASSERT_EQ(cornerResponse(image, scratch, CORNER_HARRIS, 7, 0.04f, 8, corners, 16), 4u);
+    const std::vector<Point<int32_t>> squareCorners = { { 60, 50 }, { 99, 50 }, { 60, 89 }, { 99, 89 } };
+    for (uint32_t i = 0; i < 4; i++) {
+        Point<int32_t> corner = { corners[i].col, corners[i].row };
+        double nearest = 1e9;
+        for (const Point<int32_t>& squareCorner : squareCorners) {
+            nearest = std::min<double>(nearest, corner.distanceTo(squareCorner));
+        }
+        EXPECT_LE(nearest, 3) << corner.to_string();
+        for (uint32_t j = 0; j < i; j++) {
+            EXPECT_GE(corners[j].response, corners[i].response);
+            EXPECT_TRUE(std::abs(corners[i].col - corners[j].col) > 8 || std::abs(corners[i].row - corners[j].row) > 8);
+        }
+    }
+
+    deleteCornerScratch(scratch);
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, DetectPointsChoosesMarkersAmongStrongerCorners)
+{
+    // At these thresholds parts of the frame give stronger corners than the markers,
+    // the markers are found by how they lie and on which side of the corners they are.
+    const std::vector<std::pair<const char*, uint8_t>> images = {
+        { CPPARAS_TEST_DATA_DIR "/corners1.jpg", 145 },
+        { CPPARAS_TEST_DATA_DIR "/corners2.jpg", 150 },
+    };
+    const std::vector<std::vector<Point<int32_t>>> expectedResults = {
+        { { 167, 273 }, { 976, 309 }, { 954, 1093 } },
+        { { 349, 203 }, { 1164, 219 }, { 1130, 1026 } }
+    };
+    for (std::size_t idx = 0; idx < images.size(); idx++) {
+        image_t* image = ImageUtils::loadImageFromFile(images[idx].first);
+        std::vector<Point<int32_t>> points = MarkerDetector::detectPoints(image, images[idx].second);
+        ASSERT_EQ(points.size(), 3u) << images[idx].first;
+        for (std::size_t i = 0; i < points.size(); i++) {
+            EXPECT_LE(points[i].distanceTo(expectedResults[idx][i]), 2) << images[idx].first << " point " << i;
+        }
+        deleteImage(image);
+    }
+
+    // Too low a threshold gives corners all over the frame, but none that lie like the markers
+    image_t* image = ImageUtils::loadImageFromFile(CPPARAS_TEST_DATA_DIR "/corners1.jpg");
+    EXPECT_TRUE(MarkerDetector::detectPoints(image, 70).empty());
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, DetectsMarkersInDownscaledFrames)
+{
+    // Corners detected at a quarter of the resolution and refined in the full resolution frame
+    // are as precise as corners detected in the full resolution frame.
+    const std::vector<const char*> imgPaths = {
+        CPPARAS_TEST_DATA_DIR "/corners1.jpg",
+        CPPARAS_TEST_DATA_DIR "/corners2.jpg",
+    };
+    for (const char* imgPath : imgPaths) {
+        image_t* image = ImageUtils::loadImageFromFile(imgPath);
+        MarkerDetector::Detection full = MarkerDetector::detect(image);
+        ASSERT_EQ(full.corners.size(), 3u) << imgPath;
+        for (uint8_t factor : { 2, 4 }) {
+            image_t* small = newBasicImage(image->cols / factor, image->rows / factor);
+            downscale(image, small, factor);
+            MarkerDetector::Detection detection = MarkerDetector::detect(small);
+            ASSERT_EQ(detection.corners.size(), 3u) << imgPath << " factor " << (int)factor;
+            std::vector<Point<double>> scaled;
+            for (const Point<double>& corner : detection.corners) {
+                scaled.push_back({ corner.col * factor, corner.row * factor });
+            }
+            std::vector<Point<double>> refined = MarkerDetector::refineCorners(image, scaled);
+            for (std::size_t i = 0; i < refined.size(); i++) {
+                EXPECT_LE(refined[i].distanceTo(full.corners[i]), 1.0) << imgPath << " factor " << (int)factor << " point " << i;
+            }
+            deleteImage(small);
+        }
+        deleteImage(image);
+    }
+}
+
+TEST(MarkerDetectorSuite, RefineCornersFindsSubpixelCorner)
+{
+    // A bright square whose left-top corner lies between pixels, with the edge pixels partly covered
+    const double cornerCol = 40.3;
+    const double cornerRow = 50.7;
+    image_t* image = newBasicImage(600, 600);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            double coverCol = std::min(std::max(col + 0.5 - cornerCol, 0.0), 1.0);
+            double coverRow = std::min(std::max(row + 0.5 - cornerRow, 0.0), 1.0);
+            setBasicPixel(image, col, row, (uint8_t)std::lround(40 + 160 * coverCol * coverRow));
+        }
+    }
+    // Inside the square, like the detector finds it
+    std::vector<Point<double>> refined = MarkerDetector::refineCorners(image, { { 44.0, 54.0 } });
+    ASSERT_EQ(refined.size(), 1u);
+    EXPECT_NEAR(refined[0].col, cornerCol, 0.1);
+    EXPECT_NEAR(refined[0].row, cornerRow, 0.1);
+
+    // A straight edge has no corner
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            setBasicPixel(image, col, row, col < cornerCol ? 40 : 200);
+        }
+    }
+    refined = MarkerDetector::refineCorners(image, { { 44.0, 54.0 } });
+    EXPECT_DOUBLE_EQ(refined[0].col, 44.0);
+    EXPECT_DOUBLE_EQ(refined[0].row, 54.0);
+    deleteImage(image);
+}
+
+TEST(MarkerDetectorSuite, CornerResponseTiming)
+{
+    image_t* image = squareImage(60, 50);
+    image_t* harris = newBasicImage(image->cols, image->rows);
+    corner_scratch_t* scratch = newCornerScratch(image->cols, image->rows);
+    corner_t corners[32];
+    uint32_t found = 0;
+
+    // Only reported, the corner response was around 6 times faster than Corner()
+    RecordProperty("Corner us", fastestMicroseconds([&]() { Corner(image, harris, 2, 7, 0.04, 0); }, 10));
+    RecordProperty("cornerResponse us", fastestMicroseconds([&]() { found = cornerResponse(image, scratch, CORNER_HARRIS, 7, 0.04f, 8, corners, 32); }, 10));
+
+    // The scratch that was reused for every run gives the same corners as a new one
+    corner_scratch_t* fresh = newCornerScratch(image->cols, image->rows);
+    corner_t freshCorners[32];
+    ASSERT_EQ(cornerResponse(image, fresh, CORNER_HARRIS, 7, 0.04f, 8, freshCorners, 32), found);
+    for (uint32_t i = 0; i < found; i++) {
+        EXPECT_EQ(corners[i].col, freshCorners[i].col) << i;
+        EXPECT_EQ(corners[i].row, freshCorners[i].row) << i;
+        EXPECT_EQ(corners[i].response, freshCorners[i].response) << i;
+    }
+
+    deleteCornerScratch(fresh);
+    deleteCornerScratch(scratch);
+    deleteImage(harris);
+    deleteImage(image);
+}
@@ -0,0 +1,144 @@
+#include "MarkerDetector.hpp"
+#include "MarkerTracker.hpp"
+#include "SyntheticSource.hpp"
+#include "Timing.hpp"
+#include "operators.h"
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+// Returns a frame with the baseplate at the given offset.
+static image_t* syntheticFrame(SyntheticSource& source, int32_t offsetCols, int32_t offsetRows)
+{
+    source.setBaseplateOffset(offsetCols, offsetRows);
+    // The frame after next is the first one that was read after the offset changed.
+    source.getFrame();
+    EXPECT_TRUE(source.waitForFrame(source.getFrameInfo().sequence + 1, std::chrono::milliseconds(5000)));
+    image_t* frame = source.getFrame();
+    image_t* copied = newRGB888Image(frame->cols, frame->rows);
+    copy(frame, copied);
+    return copied;
+}
+
+static void expectCorners(const std::vector<Point<int32_t>>& corners, const std::vector<Point<int32_t>>& expected, int32_t maxDeviation)
+{
+    ASSERT_EQ(corners.size(), expected.size());
+    for (std::size_t i = 0; i < corners.size(); i++) {
+        EXPECT_LE(corners[i].distanceTo(expected[i]), maxDeviation) << "point " << i << " " << corners[i].to_string() << " and " << expected[i].to_string() << " are not equal";
+    }
+}
+
+TEST(MarkerTrackerSuite, TracksMarkersAndFallsBackToFullSearch)
+{
+    SyntheticSource source(1440, 1440, 100.0);
+    source.start();
+    image_t* frame = syntheticFrame(source, 0, 0);
+    std::vector<Point<int32_t>> expected = source.getMarkerCorners();
+
+    MarkerTracker tracker;
+    EXPECT_FALSE(tracker.isTracking());
+    // The first frame is searched as a whole, after which the sharp corners are known.
+    expectCorners(tracker.update(frame), expected, 2);
+    EXPECT_TRUE(tracker.isTracking());
+    expectCorners(tracker.update(frame), expected, 2);
+    deleteImage(frame);
+
+    // A small shift stays within the windows.
+    frame = syntheticFrame(source, 20, -15);
+    expected = source.getMarkerCorners();
+    expectCorners(tracker.update(frame), expected, 2);
+    EXPECT_DOUBLE_EQ(tracker.getConfidence(), 1.0);
+    deleteImage(frame);
+
+    TrackingStatistics statistics = tracker.getStatistics();
+    EXPECT_EQ(statistics.fullSearches, 1u);
+    EXPECT_EQ(statistics.foundSearches, 1u);
+    EXPECT_EQ(statistics.trackedFrames, 2u);
+    EXPECT_EQ(statistics.lostTracks, 0u);
+
+    // A large shift loses the markers, and the whole frame is searched again.
+    frame = syntheticFrame(source, -100, 80);
+    expected = source.getMarkerCorners();
+    expectCorners(tracker.update(frame), expected, 2);
+    EXPECT_TRUE(tracker.isTracking());
+    statistics = tracker.getStatistics();
+    EXPECT_EQ(statistics.lostTracks, 1u);
+    EXPECT_EQ(statistics.fullSearches, 2u);
+    deleteImage(frame);
+    source.stop();
+}
+
+TEST(MarkerTrackerSuite, RegionsAreTrackedInFullResolutionPixels)
+{
+    SyntheticSource source(1440, 1440, 100.0);
+    source.start();
+    image_t* frame = syntheticFrame(source, 0, 0);
+    std::vector<Point<int32_t>> expected = source.getMarkerCorners();
+    source.stop();
+
+    MarkerTracker tracker;
+    expectCorners(tracker.update(frame), expected, 2);
+    // The same frame, cropped to the baseplate
+    const Point<int32_t> origin = { expected[0].col - 100, expected[0].row - 100 };
+    image_t* region = newRGB888Image(expected[1].col - origin.col + 100, expected[2].row - origin.row + 100);
+    int32_t topLeft[2] = { origin.col, origin.row };
+    crop(frame, region, topLeft);
+    expectCorners(tracker.update(region, origin), expected, 2);
+    EXPECT_EQ(tracker.getStatistics().trackedFrames, 1u);
+    deleteImage(region);
+    deleteImage(frame);
+}
+
+TEST(MarkerTrackerSuite, RegionsAreSearchedWithTheSpacingOfTheFullFrame)
+{
+    SyntheticSource source(1440, 1440, 100.0);
+    source.start();
+    image_t* frame = syntheticFrame(source, 0, 0);
+    std::vector<Point<int32_t>> expected = source.getMarkerCorners();
+    source.stop();
+
+    // A tight capture region, in which the markers span far more than MARKER_SPACING of its shorter side
+    const int32_t margin = 60;
+    const Point<int32_t> origin = { expected[0].col - margin, expected[0].row - margin };
+    image_t* region = newRGB888Image(expected[1].col - origin.col + margin, expected[2].row - origin.row + margin);
+    int32_t topLeft[2] = { origin.col, origin.row };
+    crop(frame, region, topLeft);
+
+    MarkerTracker tracker;
+    expectCorners(tracker.update(region, origin, MarkerDetector::markerSpacing(frame->cols, frame->rows)), expected, 2);
+    TrackingStatistics statistics = tracker.getStatistics();
+    EXPECT_EQ(statistics.fullSearches, 1u);
+    EXPECT_EQ(statistics.foundSearches, 1u);
+    deleteImage(region);
+    deleteImage(frame);
+}
+
+TEST(MarkerTrackerSuite, TrackingSkipsTheFullSearch)
+{
+    SyntheticSource source(1440, 1440, 100.0);
+    source.start();
+    image_t* frame = syntheticFrame(source, 0, 0);
+    source.stop();
+
+    MarkerTracker tracker;
+    // Every run searches the whole frame again
+    auto search = [&]() {
+        tracker.reset();
+        tracker.update(frame);
+    };
+    RecordProperty("search us", fastestMicroseconds(search, 5));
+    TrackingStatistics searched = tracker.getStatistics();
+    EXPECT_EQ(searched.fullSearches, 5u);
+    EXPECT_EQ(searched.foundSearches, 5u);
+    EXPECT_EQ(searched.trackedFrames, 0u);
+
+    // Tracked frames only look at the windows, the detector doesn't try a single threshold
+    RecordProperty("track us", fastestMicroseconds([&]() { tracker.update(frame); }, 5));
+    TrackingStatistics tracked = tracker.getStatistics();
+    EXPECT_TRUE(tracker.isTracking());
+    EXPECT_EQ(tracked.trackedFrames, 5u);
+    EXPECT_EQ(tracked.fullSearches, searched.fullSearches);
+    EXPECT_EQ(tracked.detectionAttempts, searched.detectionAttempts);
+    deleteImage(frame);
+}
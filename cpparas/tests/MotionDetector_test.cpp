@@ -0,0 +1,82 @@
+#include "MotionDetector.hpp"
+#include "operators.h"
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+static void fillRect(image_t* img, int32_t col, int32_t row, int32_t cols, int32_t rows, uint8_t value)
+{
+    for (int32_t r = row; r < row + rows; r++) {
+        for (int32_t c = col; c < col + cols; c++) {
+            setBasicPixel(img, c, r, value);
+        }
+    }
+}
+
+TEST(MotionDetectorSuite, ChangedTilesAreFound)
+{
+    image_t* img = newBasicImage(640, 640);
+    fillRect(img, 0, 0, 640, 640, 100);
+    const Rect<int32_t> fieldOfView = { { 0, 0 }, 640, 640 };
+    const Rect<int32_t> whole = { { 0, 0 }, 0, 0 };
+    MotionDetector motion;
+    std::size_t reference = motion.addReference();
+
+    // Nothing to compare with yet
+    motion.update(img, fieldOfView);
+    EXPECT_TRUE(motion.changed(reference, whole));
+    motion.accept(reference);
+    EXPECT_FALSE(motion.changed(reference, whole));
+
+    // A bright square in the top left tile, which is 80x80 pixels here
+    fillRect(img, 10, 10, 60, 60, 200);
+    motion.update(img, fieldOfView);
+    EXPECT_TRUE(motion.changed(reference, whole));
+    EXPECT_TRUE(motion.changed(reference, { { 0, 0 }, 100, 100 }));
+    EXPECT_FALSE(motion.changed(reference, { { 200, 200 }, 400, 400 }));
+    std::vector<double> scores = motion.tileScores(reference);
+    ASSERT_EQ(scores.size(), 64u);
+    EXPECT_GT(scores[0], 50.0);
+    EXPECT_EQ(scores[9], 0.0);
+
+    // The change stays until the reference is accepted
+    motion.update(img, fieldOfView);
+    EXPECT_TRUE(motion.changed(reference, whole));
+    motion.accept(reference);
+    EXPECT_FALSE(motion.changed(reference, whole));
+    deleteImage(img);
+}
+
+TEST(MotionDetectorSuite, ReferencesAreIndependent)
+{
+    image_t* img = newBasicImage(320, 320);
+    fillRect(img, 0, 0, 320, 320, 50);
+    const Rect<int32_t> fieldOfView = { { 100, 100 }, 320, 320 };
+    MotionDetector motion;
+    std::size_t first = motion.addReference();
+    std::size_t second = motion.addReference();
+    motion.update(img, fieldOfView);
+    motion.accept(first);
+    motion.accept(second);
+
+    // Regions are in full resolution pixels, the frame starts at 100, 100
+    fillRect(img, 300, 300, 20, 20, 250);
+    motion.update(img, fieldOfView);
+    EXPECT_TRUE(motion.changed(first, { { 400, 400 }, 20, 20 }));
+    EXPECT_FALSE(motion.changed(first, { { 100, 100 }, 20, 20 }));
+    motion.accept(first);
+    EXPECT_FALSE(motion.changed(first, { { 400, 400 }, 20, 20 }));
+    EXPECT_TRUE(motion.changed(second, { { 400, 400 }, 20, 20 }));
+
+    // A frame of another region can't be compared
+    motion.update(img, { { 0, 0 }, 320, 320 });
+    EXPECT_TRUE(motion.changed(first, { { 100, 100 }, 20, 20 }));
+
+    // A preview of the same region can
+    image_t* preview = newBasicImage(160, 160);
+    scaleImage(img, preview);
+    motion.update(preview, fieldOfView);
+    EXPECT_FALSE(motion.changed(first, { { 0, 0 }, 0, 0 }));
+    deleteImage(preview);
+    deleteImage(img);
+}
@@ -0,0 +1,174 @@
+#include "operators.h"
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+
+TEST(OperatorsSuite, DownscaleAveragesBlocks)
+{
+    image_t* image = newRGB888Image(9, 5);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            uint8_t value = (col / 2 + row / 2) % 2 == 0 ? 0 : 200;
+            setRGB888Pixel(image, col, row, { value, (uint8_t)(col * 10), 100 });
+        }
+    }
+
+    // Every block of 2x2 has a single color, the trailing col and row are left out
+    image_t* color = newRGB888Image(4, 2);
+    downscale(image, color, 2);
+    EXPECT_EQ(getRGB888Pixel(color, 0, 0).r, 0);
+    EXPECT_EQ(getRGB888Pixel(color, 1, 0).r, 200);
+    EXPECT_EQ(getRGB888Pixel(color, 1, 1).r, 0);
+    EXPECT_EQ(getRGB888Pixel(color, 3, 1).g, 65);
+
+    // Luma like convertRGB888ToYUV420, averaged over the block
+    image_t* luma = newBasicImage(8, 4);
+    convertRGB888ToYUV420(image, luma, NULL, NULL);
+    image_t* gray = newBasicImage(4, 2);
+    downscale(image, gray, 2);
+    for (int32_t row = 0; row < gray->rows; row++) {
+        for (int32_t col = 0; col < gray->cols; col++) {
+            int32_t sum = getBasicPixel(luma, 2 * col, 2 * row) + getBasicPixel(luma, 2 * col + 1, 2 * row)
+                + getBasicPixel(luma, 2 * col, 2 * row + 1) + getBasicPixel(luma, 2 * col + 1, 2 * row + 1);
+            EXPECT_NEAR(getBasicPixel(gray, col, row), sum / 4.0, 1.0) << col << ", " << row;
+        }
+    }
+
+    // Basic images are averaged as they are
+    image_t* grayer = newBasicImage(2, 1);
+    downscale(luma, grayer, 4);
+    EXPECT_NEAR(getBasicPixel(grayer, 0, 0), (getBasicPixel(gray, 0, 0) + getBasicPixel(gray, 1, 0) + getBasicPixel(gray, 0, 1) + getBasicPixel(gray, 1, 1)) / 4.0, 1.0);
+
+    deleteImage(grayer);
+    deleteImage(gray);
+    deleteImage(luma);
+    deleteImage(color);
+    deleteImage(image);
+}
+
+// Erodes or dilates every pixel of a basic image of zeroes and ones with the pixels [first, first + size> around it
+static uint8_t referenceMorphology(const image_t* image, int32_t col, int32_t row, int32_t size, int32_t first, bool erode)
+{
+    for (int32_t r = row + first; r < row + first + size; r++) {
+        for (int32_t c = col + first; c < col + first + size; c++) {
+            if (c < 0 || c >= image->cols || r < 0 || r >= image->rows) {
+                continue;
+            }
+            if (getBasicPixel(image, c, r) != (erode ? 1 : 0)) {
+                return erode ? 0 : 1;
+            }
+        }
+    }
+    return erode ? 1 : 0;
+}
+
+TEST(OperatorsSuite, PackedMorphologyMatchesPixelByPixel)
+{
+    // Wider than two words, so the shifts cross words and the last word is partly used
+    image_t* image = newBasicImage(150, 90);
+    std::srand(7);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            // Blobs of different sizes, so erosion and dilation both leave something to compare
+            bool blob = ((col / 9) * 7 + (row / 13) * 3) % 5 < 3;
+            setBasicPixel(image, col, row, blob != (std::rand() % 23 == 0) ? 1 : 0);
+        }
+    }
+    image_t* packed = newBinaryImage(image->cols, image->rows);
+    image_t* result = newBinaryImage(image->cols, image->rows);
+    convertImage(image, packed);
+    binary_scratch_t* scratch = newBinaryScratch(image->cols, image->rows);
+
+    pixel_t one;
+    one.basic_pixel = 1;
+    EXPECT_EQ(pixelCount(packed, one), pixelCount(image, one));
+
+    for (uint8_t size : { 1, 2, 3, 8, 15, 20, 70 }) {
+        binaryErode(packed, result, size, scratch);
+        uint32_t wrong = 0;
+        for (int32_t row = 0; row < image->rows; row++) {
+            for (int32_t col = 0; col < image->cols; col++) {
+                wrong += getBinaryPixel(result, col, row) != referenceMorphology(image, col, row, size, -(size / 2), true);
+            }
+        }
+        EXPECT_EQ(wrong, 0u) << "erode " << (int)size;
+
+        binaryDilate(packed, result, size, scratch);
+        wrong = 0;
+        for (int32_t row = 0; row < image->rows; row++) {
+            for (int32_t col = 0; col < image->cols; col++) {
+                wrong += getBinaryPixel(result, col, row) != referenceMorphology(image, col, row, size, -(size - 1 - size / 2), false);
+            }
+        }
+        EXPECT_EQ(wrong, 0u) << "dilate " << (int)size;
+    }
+
+    // Opening never adds pixels, closing never removes them, and both only change what doesn't fit the element
+    image_t* opened = newBinaryImage(image->cols, image->rows);
+    image_t* closed = newBinaryImage(image->cols, image->rows);
+    binaryOpen(packed, opened, 4, scratch);
+    binaryClose(packed, closed, 4, scratch);
+    uint32_t added = 0;
+    uint32_t removed = 0;
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            added += getBinaryPixel(opened, col, row) > getBasicPixel(image, col, row);
+            removed += getBinaryPixel(closed, col, row) < getBasicPixel(image, col, row);
+        }
+    }
+    EXPECT_EQ(added, 0u);
+    EXPECT_EQ(removed, 0u);
+    EXPECT_LT(pixelCount(opened, one), pixelCount(packed, one));
+    EXPECT_GT(pixelCount(closed, one), pixelCount(packed, one));
+
+    // Bits past the last col stay 0, so counting whole words is exact
+    invert(packed, result, 1);
+    EXPECT_EQ(pixelCount(result, one), pixelCount(image, pixel_t { 0 }));
+    one.basic_pixel = 0;
+    EXPECT_EQ(pixelCount(result, one), pixelCount(packed, pixel_t { 1 }));
+
+    // A scratch that is too small leaves dst as it is
+    binary_scratch_t* small = newBinaryScratch(image->cols - 1, image->rows);
+    binaryErode(packed, result, 8, small);
+    EXPECT_EQ(pixelCount(result, one), pixelCount(packed, pixel_t { 1 }));
+    binaryDilate(packed, result, 8, nullptr);
+    EXPECT_EQ(pixelCount(result, one), pixelCount(packed, pixel_t { 1 }));
+    deleteBinaryScratch(small);
+
+    deleteBinaryScratch(scratch);
+    deleteImage(closed);
+    deleteImage(opened);
+    deleteImage(result);
+    deleteImage(packed);
+    deleteImage(image);
+}
+
+TEST(OperatorsSuite, PackedThresholdMatchesBasicThreshold)
+{
+    image_t* image = newBasicImage(100, 3);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            setBasicPixel(image, col, row, (col * 5 + row * 40) % 256);
+        }
+    }
+    image_t* basic = newBasicImage(image->cols, image->rows);
+    image_t* packed = newBinaryImage(image->cols, image->rows);
+    threshold(image, basic, 180, 255, 1);
+    threshold(image, packed, 180, 255, 1);
+    clear_center(basic);
+    clear_center(packed);
+    for (int32_t row = 0; row < image->rows; row++) {
+        for (int32_t col = 0; col < image->cols; col++) {
+            EXPECT_EQ(getBinaryPixel(packed, col, row), getBasicPixel(basic, col, row)) << col << ", " << row;
+        }
+    }
+
+    image_t* unpacked = newBasicImage(image->cols, image->rows);
+    convertImage(packed, unpacked);
+    EXPECT_EQ(std::memcmp(unpacked->data, basic->data, image->cols * image->rows), 0);
+
+    deleteImage(unpacked);
+    deleteImage(packed);
+    deleteImage(basic);
+    deleteImage(image);
+}
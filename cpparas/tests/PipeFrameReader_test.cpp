@@ -0,0 +1,109 @@
+#include "util/PipeFrameReader.hpp"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace cpparas;
+
+static void writeFrame(int fd, uint8_t value, std::size_t size)
+{
+    std::vector<uint8_t> frame(size, value);
+    ASSERT_EQ(write(fd, frame.data(), size), (ssize_t)size);
+}
+
+TEST(PipeFrameReaderSuite, PartialFramesAreReassembled)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const std::size_t frameSize = 64;
+    PipeFrameReader reader(fds[0], frameSize);
+    std::vector<uint8_t> dst(frameSize, 0);
+
+    writeFrame(fds[1], 1, frameSize / 2);
+    EXPECT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::TIMEOUT);
+    writeFrame(fds[1], 2, frameSize / 2);
+    ASSERT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::FRAME);
+    EXPECT_EQ(dst[0], 1);
+    EXPECT_EQ(dst[frameSize - 1], 2);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(PipeFrameReaderSuite, OutdatedFramesAreDropped)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const std::size_t frameSize = 64;
+    PipeFrameReader reader(fds[0], frameSize);
+    std::vector<uint8_t> dst(frameSize, 0);
+
+    // Half a frame is read before the consumer falls behind.
+    writeFrame(fds[1], 1, frameSize / 2);
+    EXPECT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::TIMEOUT);
+    writeFrame(fds[1], 1, frameSize / 2);
+    writeFrame(fds[1], 2, frameSize);
+    writeFrame(fds[1], 3, frameSize);
+    writeFrame(fds[1], 4, frameSize / 2);
+
+    ASSERT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::FRAME);
+    EXPECT_EQ(dst[0], 3);
+    EXPECT_EQ(dst[frameSize - 1], 3);
+    EXPECT_EQ(reader.getDroppedFrames(), 2u);
+
+    // The partial frame stays aligned.
+    writeFrame(fds[1], 4, frameSize / 2);
+    ASSERT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::FRAME);
+    EXPECT_EQ(dst[0], 4);
+    EXPECT_EQ(dst[frameSize - 1], 4);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(PipeFrameReaderSuite, FramesLargerThanThePipeAreDropped)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    // More than the 64 KB a pipe holds by default, like a real YUV420 frame
+    const std::size_t frameSize = 256 * 1024;
+    PipeFrameReader reader(fds[0], frameSize);
+    std::vector<uint8_t> dst(frameSize, 0);
+    ASSERT_GE(fcntl(fds[0], F_GETPIPE_SZ), (int)(2 * frameSize)) << "the pipe was not enlarged";
+
+    writeFrame(fds[1], 1, frameSize);
+    writeFrame(fds[1], 2, frameSize);
+    ASSERT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::FRAME);
+    EXPECT_EQ(dst[0], 2);
+    EXPECT_EQ(dst[frameSize - 1], 2);
+    EXPECT_EQ(reader.getDroppedFrames(), 1u);
+    EXPECT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::TIMEOUT);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(PipeFrameReaderSuite, ClosedPipeIsReportedAndResetRealigns)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const std::size_t frameSize = 64;
+    PipeFrameReader reader(fds[0], frameSize);
+    std::vector<uint8_t> dst(frameSize, 0);
+
+    writeFrame(fds[1], 1, frameSize / 2);
+    close(fds[1]);
+    EXPECT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::CLOSED);
+    close(fds[0]);
+
+    // A restarted writer starts at a frame boundary.
+    ASSERT_EQ(pipe(fds), 0);
+    reader.reset(fds[0]);
+    writeFrame(fds[1], 5, frameSize);
+    ASSERT_EQ(reader.readLatest(dst.data(), 10), PipeFrameReader::Status::FRAME);
+    EXPECT_EQ(dst[0], 5);
+
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,392 @@
+#include "RegionExtractor.hpp"
+#include "operators.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+static const std::vector<Point<int32_t>> CORNERS = { { 167, 273 }, { 976, 309 }, { 954, 1093 } };
+
+// A smooth pattern, so nearest and bilinear sampling give about the same values.
+static image_t* smoothLuma(int32_t cols, int32_t rows)
+{
+    image_t* luma = newBasicImage(cols, rows);
+    for (int32_t row = 0; row < rows; row++) {
+        for (int32_t col = 0; col < cols; col++) {
+            setBasicPixel(luma, col, row, (uint8_t)(128 + 100 * std::sin(col / 60.0) * std::cos(row / 80.0)));
+        }
+    }
+    return luma;
+}
+
+static image_t* chromaPlane(int32_t cols, int32_t rows, uint8_t value)
+{
+    image_t* plane = newBasicImage(cols, rows);
+    for (int32_t row = 0; row < rows; row++) {
+        for (int32_t col = 0; col < cols; col++) {
+            setBasicPixel(plane, col, row, value);
+        }
+    }
+    return plane;
+}
+
+TEST(RegionExtractorSuite, TableWarpMatchesWarpYUV420)
+{
+    image_t* luma = smoothLuma(1440, 1440);
+    image_t* chromaU = chromaPlane(720, 720, 110);
+    image_t* chromaV = chromaPlane(720, 720, 150);
+    image_t* expected = newRGB888Image(800, 800);
+    int32_t colpos[3] = { CORNERS[0].col, CORNERS[1].col, CORNERS[2].col };
+    int32_t rowpos[3] = { CORNERS[0].row, CORNERS[1].row, CORNERS[2].row };
+    warpYUV420(luma, chromaU, chromaV, expected, colpos, rowpos);
+
+    RegionExtractor extractor(800, 800);
+    extractor.extractRegion(luma, chromaU, chromaV, CORNERS);
+    const image_t* region = extractor.getRegionImage();
+    int32_t maxDifference = 0;
+    for (int32_t row = 0; row < region->rows; row++) {
+        for (int32_t col = 0; col < region->cols; col++) {
+            rgb888_pixel_t a = getRGB888Pixel(region, col, row);
+            rgb888_pixel_t b = getRGB888Pixel(expected, col, row);
+            maxDifference = std::max({ maxDifference, std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b) });
+        }
+    }
+    // Sampling between the pixels instead of at the nearest one moves a value by less than its slope.
+    EXPECT_LE(maxDifference, 4);
+
+    deleteImage(expected);
+    deleteImage(chromaV);
+    deleteImage(chromaU);
+    deleteImage(luma);
+}
+
+TEST(RegionExtractorSuite, TableWarpInterpolatesBilinearly)
+{
+    // A ramp along the cols, so every dst pixel holds the source col it was sampled at.
+    image_t* ramp = newBasicImage(256, 64);
+    for (int32_t row = 0; row < ramp->rows; row++) {
+        for (int32_t col = 0; col < ramp->cols; col++) {
+            setBasicPixel(ramp, col, row, (uint8_t)col);
+        }
+    }
+    // Four times enlarged, so the dst pixels fall between the source pixels.
+    image_t* dst = newRGB888Image(200, 40);
+    int32_t colpos[3] = { 10, 60, 60 };
+    int32_t rowpos[3] = { 10, 10, 20 };
+    warp_table_t* table = newWarpTable(dst->cols, dst->rows);
+    ASSERT_NE(table, nullptr);
+    warpTableFromCorners(table, ramp->cols, ramp->rows, colpos, rowpos);
+    warpYUV420WithTable(ramp, NULL, NULL, dst, NULL, table);
+
+    float warpMatrix[2][3];
+    warpMatrixFromCorners(dst, colpos, rowpos, warpMatrix);
+    for (int32_t col = 0; col < dst->cols; col++) {
+        // Without a rotation the dst col only depends on the source col.
+        double srcCol = (col - warpMatrix[0][2]) / warpMatrix[0][0];
+        rgb888_pixel_t pixel = getRGB888Pixel(dst, col, 20);
+        EXPECT_NEAR(pixel.r, srcCol, 0.51) << "col " << col;
+        EXPECT_EQ(pixel.r, pixel.g);
+    }
+
+    // RGB input gives the same pixels as its gray Y plane.
+    image_t* rgb = newRGB888Image(ramp->cols, ramp->rows);
+    convertToRGB888Image(ramp, rgb);
+    image_t* rgbDst = newRGB888Image(dst->cols, dst->rows);
+    warpWithTable(rgb, rgbDst, NULL, table);
+    for (int32_t i = 0; i < dst->cols * dst->rows * 3; i++) {
+        ASSERT_EQ(rgbDst->data[i], dst->data[i]) << "byte " << i;
+    }
+
+    deleteWarpTable(table);
+    deleteImage(rgbDst);
+    deleteImage(rgb);
+    deleteImage(dst);
+    deleteImage(ramp);
+}
+
+TEST(RegionExtractorSuite, WarpSamplesEveryRegionPixelOnce)
+{
+    image_t* luma = smoothLuma(1440, 1440);
+    image_t* rgb = newRGB888Image(luma->cols, luma->rows);
+    convertToRGB888Image(luma, rgb);
+    int32_t colpos[3] = { CORNERS[0].col, CORNERS[1].col, CORNERS[2].col };
+    int32_t rowpos[3] = { CORNERS[0].row, CORNERS[1].row, CORNERS[2].row };
+
+    // Enlarged more than twice, so splatting the source pixels would leave gaps.
+    image_t* region = newRGB888Image(2000, 2000);
+    erase(region);
+    warp(rgb, region, colpos, rowpos);
+    warp_table_t* table = newWarpTable(region->cols, region->rows);
+    ASSERT_NE(table, nullptr);
+    warpTableFromCorners(table, rgb->cols, rgb->rows, colpos, rowpos);
+    image_t* expected = newRGB888Image(region->cols, region->rows);
+    warpWithTable(rgb, expected, NULL, table);
+
+    int32_t maxDifference = 0;
+    for (int32_t row = 0; row < region->rows; row++) {
+        for (int32_t col = 0; col < region->cols; col++) {
+            rgb888_pixel_t a = getRGB888Pixel(region, col, row);
+            rgb888_pixel_t b = getRGB888Pixel(expected, col, row);
+            maxDifference = std::max(maxDifference, std::abs(a.r - b.r));
+        }
+    }
+    // The pattern never gets black, so a gap would differ by about its brightness.
+    EXPECT_LE(maxDifference, 2);
+
+    // The nearest pixel is copied as it is, the region beyond the source stays black.
+    float shift[2][3] = { { 1.0f, 0.0f, -100.0f }, { 0.0f, 1.0f, -200.0f } };
+    warpAffine(rgb, region, shift, NEAREST);
+    EXPECT_EQ(getRGB888Pixel(region, 0, 0).r, getRGB888Pixel(rgb, 100, 200).r);
+    EXPECT_EQ(getRGB888Pixel(region, 1339, 1239).r, getRGB888Pixel(rgb, 1439, 1439).r);
+    EXPECT_EQ(getRGB888Pixel(region, 1340, 1239).r, 0);
+    EXPECT_EQ(getRGB888Pixel(region, 1339, 1240).r, 0);
+
+    deleteWarpTable(table);
+    deleteImage(expected);
+    deleteImage(region);
+    deleteImage(rgb);
+    deleteImage(luma);
+}
+
+// A camera 0.65 m above a tilted baseplate of 0.384 m, with the focal length of the capture
+static const double FOCAL_LENGTH = 1584.0;
+
+struct Plate {
+    double origin[3];
+    double sideU[3];
+    double sideV[3];
+};
+
+static Plate tiltedPlate(double tiltX, double tiltY)
+{
+    auto rotate = [&](const double v[3], double out[3]) {
+        double y = v[1] * std::cos(tiltX) - v[2] * std::sin(tiltX);
+        double z = v[1] * std::sin(tiltX) + v[2] * std::cos(tiltX);
+        out[0] = v[0] * std::cos(tiltY) + z * std::sin(tiltY);
+        out[1] = y;
+        out[2] = -v[0] * std::sin(tiltY) + z * std::cos(tiltY);
+    };
+    const double u[3] = { 0.384, 0.0, 0.0 };
+    const double v[3] = { 0.0, 0.384, 0.0 };
+    const double leftTop[3] = { 0.02 - 0.192, -0.01 - 0.192, 0.65 };
+    Plate plate;
+    rotate(u, plate.sideU);
+    rotate(v, plate.sideV);
+    rotate(leftTop, plate.origin);
+    return plate;
+}
+
+static Point<double> project(const Plate& plate, double u, double v)
+{
+    double point[3];
+    for (int i = 0; i < 3; i++) {
+        point[i] = plate.origin[i] + u * plate.sideU[i] + v * plate.sideV[i];
+    }
+    return { 720.0 + FOCAL_LENGTH * point[0] / point[2], 720.0 + FOCAL_LENGTH * point[1] / point[2] };
+}
+
+// A checkerboard of 8 x 8 squares on the plate, seen by the camera
+static image_t* checkerboardFrame(const Plate& plate)
+{
+    image_t* luma = newBasicImage(1440, 1440);
+    const double* a = plate.sideU;
+    const double* b = plate.sideV;
+    for (int32_t row = 0; row < luma->rows; row++) {
+        for (int32_t col = 0; col < luma->cols; col++) {
+            // Where the ray of the pixel meets the plate: origin + u * a + v * b = t * ray
+            const double ray[3] = { (col - 720.0) / FOCAL_LENGTH, (row - 720.0) / FOCAL_LENGTH, 1.0 };
+            auto det = [](const double* x, const double* y, const double* z) {
+                return x[0] * (y[1] * z[2] - y[2] * z[1]) - y[0] * (x[1] * z[2] - x[2] * z[1]) + z[0] * (x[1] * y[2] - x[2] * y[1]);
+            };
+            const double minusRay[3] = { -ray[0], -ray[1], -ray[2] };
+            const double minusOrigin[3] = { -plate.origin[0], -plate.origin[1], -plate.origin[2] };
+            const double d = det(a, b, minusRay);
+            const double u = det(minusOrigin, b, minusRay) / d;
+            const double v = det(a, minusOrigin, minusRay) / d;
+            uint8_t value = 120;
+            if (u >= 0.0 && u < 1.0 && v >= 0.0 && v < 1.0) {
+                value = ((int32_t)(u * 8) + (int32_t)(v * 8)) % 2 ? 220 : 40;
+            }
+            setBasicPixel(luma, col, row, value);
+        }
+    }
+    return luma;
+}
+
+TEST(RegionExtractorSuite, CompletesTheCornersWithThePerspective)
+{
+    const Plate plate = tiltedPlate(0.1, 0.05);
+    std::vector<Point<int32_t>> corners;
+    for (const Point<double>& corner : { project(plate, 0, 0), project(plate, 1, 0), project(plate, 1, 1) }) {
+        corners.push_back({ (int32_t)std::lround(corner.col), (int32_t)std::lround(corner.row) });
+    }
+    const Point<double> expected = project(plate, 0, 1);
+
+    RegionExtractor extractor(800, 800);
+    // Without the camera the corners can only be completed to a parallelogram, which the tilt puts far off.
+    std::vector<Point<int32_t>> completed = extractor.completeCorners(corners);
+    ASSERT_EQ(completed.size(), 4u);
+    EXPECT_EQ(completed[3].col, corners[0].col + corners[2].col - corners[1].col);
+    EXPECT_GT(std::hypot(completed[3].col - expected.col, completed[3].row - expected.row), 20.0);
+
+    extractor.setCamera(FOCAL_LENGTH, { 720.0, 720.0 });
+    completed = extractor.completeCorners(corners);
+    ASSERT_EQ(completed.size(), 4u);
+    EXPECT_LE(std::hypot(completed[3].col - expected.col, completed[3].row - expected.row), 2.0) << completed[3].to_string();
+}
+
+TEST(RegionExtractorSuite, CornersAreMovedOntoTheCornerStuds)
+{
+    RegionExtractor extractor(800, 800);
+    const std::vector<Point<int32_t>> square = { { 100, 100 }, { 1060, 100 }, { 1060, 1060 } };
+    EXPECT_EQ(extractor.studCorners(square), square);
+
+    // Half a stud of 20 pixels inwards along both sides
+    extractor.setBaseplate(48, 48);
+    const std::vector<Point<int32_t>> expectedSquare = { { 110, 110 }, { 1050, 110 }, { 1050, 1050 } };
+    EXPECT_EQ(extractor.studCorners(square), expectedSquare);
+
+    // With the perspective the studs further away are closer together
+    const Plate plate = tiltedPlate(0.1, 0.05);
+    std::vector<Point<int32_t>> corners;
+    for (const Point<double>& corner : { project(plate, 0, 0), project(plate, 1, 0), project(plate, 1, 1), project(plate, 0, 1) }) {
+        corners.push_back({ (int32_t)std::lround(corner.col), (int32_t)std::lround(corner.row) });
+    }
+    const double inset = 0.5 / 48;
+    const std::vector<Point<double>> expected = { project(plate, inset, inset), project(plate, 1 - inset, inset), project(plate, 1 - inset, 1 - inset), project(plate, inset, 1 - inset) };
+    const std::vector<Point<int32_t>> studs = extractor.studCorners(corners);
+    ASSERT_EQ(studs.size(), 4u);
+    for (std::size_t i = 0; i < studs.size(); i++) {
+        EXPECT_LE(std::hypot(studs[i].col - expected[i].col, studs[i].row - expected[i].row), 1.5) << "corner " << i;
+    }
+}
+
+TEST(RegionExtractorSuite, RectifiesThePerspectiveOfTheBaseplate)
+{
+    const Plate plate = tiltedPlate(0.1, 0.05);
+    image_t* luma = checkerboardFrame(plate);
+    std::vector<Point<int32_t>> corners;
+    for (const Point<double>& corner : { project(plate, 0, 0), project(plate, 1, 0), project(plate, 1, 1) }) {
+        corners.push_back({ (int32_t)std::lround(corner.col), (int32_t)std::lround(corner.row) });
+    }
+    RegionExtractor extractor(800, 800);
+    extractor.setCamera(FOCAL_LENGTH, { 720.0, 720.0 });
+    extractor.extractRegion(luma, nullptr, nullptr, extractor.completeCorners(corners));
+    const image_t* region = extractor.getRegionImage();
+
+    // The squares are 100 pixels in the region, along the rows as well as the cols.
+    int32_t maxDeviation = 0;
+    for (int32_t line = 50; line < 800; line += 100) {
+        for (int32_t edge = 100; edge < 800; edge += 100) {
+            int32_t across = edge - 20;
+            while (across < edge + 20 && (getRGB888Pixel(region, across, line).r > 130) == (getRGB888Pixel(region, edge - 20, line).r > 130)) {
+                across++;
+            }
+            int32_t down = edge - 20;
+            while (down < edge + 20 && (getRGB888Pixel(region, line, down).r > 130) == (getRGB888Pixel(region, line, edge - 20).r > 130)) {
+                down++;
+            }
+            maxDeviation = std::max({ maxDeviation, std::abs(across - edge), std::abs(down - edge) });
+        }
+    }
+    EXPECT_LE(maxDeviation, 3);
+
+    // The RGB warp takes the same positions as the table.
+    image_t* rgb = newRGB888Image(luma->cols, luma->rows);
+    convertToRGB888Image(luma, rgb);
+    std::vector<Point<int32_t>> completed = extractor.completeCorners(corners);
+    int32_t colpos[4] = { completed[0].col, completed[1].col, completed[2].col, completed[3].col };
+    int32_t rowpos[4] = { completed[0].row, completed[1].row, completed[2].row, completed[3].row };
+    float homography[3][3];
+    image_t* warped = newRGB888Image(800, 800);
+    ASSERT_TRUE(homographyFromCorners(warped, colpos, rowpos, homography));
+    warpPerspective(rgb, warped, homography, BILINEAR);
+    for (int32_t i = 0; i < warped->cols * warped->rows * 3; i++) {
+        ASSERT_EQ(warped->data[i], region->data[i]) << "byte " << i;
+    }
+
+    deleteImage(warped);
+    deleteImage(rgb);
+    deleteImage(luma);
+}
+
+TEST(RegionExtractorSuite, TableWarpMakesHSVWhileSampling)
+{
+    image_t* luma = smoothLuma(1440, 1440);
+    image_t* chromaU = chromaPlane(720, 720, 90);
+    image_t* chromaV = chromaPlane(720, 720, 170);
+    image_t* color = newRGB888Image(1440, 1440);
+    image_t* rgb = newRGB888Image(800, 800);
+    image_t* hsv = newHSVImage(800, 800);
+    image_t* expected = newHSVImage(800, 800);
+    int32_t colpos[3] = { CORNERS[0].col, CORNERS[1].col, CORNERS[2].col };
+    int32_t rowpos[3] = { CORNERS[0].row, CORNERS[1].row, CORNERS[2].row };
+    warp_table_t* table = newWarpTable(800, 800);
+    ASSERT_NE(table, nullptr);
+    warpTableFromCorners(table, luma->cols, luma->rows, colpos, rowpos);
+    // Colored RGB input, to check the conversion of the RGB warp as well
+    for (int32_t row = 0; row < color->rows; row++) {
+        for (int32_t col = 0; col < color->cols; col++) {
+            const uint8_t y = getBasicPixel(luma, col, row);
+            setRGB888Pixel(color, col, row, { y, (uint8_t)(255 - y), (uint8_t)(col / 8) });
+        }
+    }
+
+    for (int32_t input = 0; input < 3; input++) {
+        if (input == 2) {
+            warpWithTable(color, rgb, hsv, table);
+        } else {
+            warpYUV420WithTable(luma, input == 0 ? NULL : chromaU, input == 0 ? NULL : chromaV, rgb, hsv, table);
+        }
+        convertToHSVImage(rgb, expected);
+        const hsv_pixel_t* a = (const hsv_pixel_t*)hsv->data;
+        const hsv_pixel_t* b = (const hsv_pixel_t*)expected->data;
+        for (int32_t i = 0; i < 800 * 800; i++) {
+            ASSERT_TRUE(a[i].h == b[i].h && a[i].s == b[i].s && a[i].v == b[i].v) << "input " << input << " pixel " << i;
+        }
+    }
+
+    // The cut frames get their HSV image the same way
+    RegionExtractor extractor(800, 800);
+    extractor.extractRegion(luma, chromaU, chromaV, CORNERS, rgb, hsv);
+    convertToHSVImage(rgb, expected);
+    const hsv_pixel_t* a = (const hsv_pixel_t*)hsv->data;
+    const hsv_pixel_t* b = (const hsv_pixel_t*)expected->data;
+    for (int32_t i = 0; i < 800 * 800; i++) {
+        ASSERT_TRUE(a[i].h == b[i].h && a[i].s == b[i].s && a[i].v == b[i].v) << "region pixel " << i;
+    }
+
+    deleteWarpTable(table);
+    deleteImage(expected);
+    deleteImage(hsv);
+    deleteImage(rgb);
+    deleteImage(color);
+    deleteImage(chromaV);
+    deleteImage(chromaU);
+    deleteImage(luma);
+}
+
+TEST(RegionExtractorSuite, TableIsOnlyMadeWhenTheCornersChange)
+{
+    image_t* luma = smoothLuma(1440, 1440);
+    RegionExtractor extractor(800, 800);
+    EXPECT_EQ(extractor.getWarpTableBuilds(), 0u);
+    extractor.extractRegion(luma, nullptr, nullptr, CORNERS);
+    extractor.extractRegion(luma, nullptr, nullptr, CORNERS);
+    EXPECT_EQ(extractor.getWarpTableBuilds(), 1u);
+
+    std::vector<Point<int32_t>> moved = CORNERS;
+    moved[2].col++;
+    extractor.extractRegion(luma, nullptr, nullptr, moved);
+    EXPECT_EQ(extractor.getWarpTableBuilds(), 2u);
+
+    // A dst of another size needs a table of its own.
+    image_t* dst = newRGB888Image(400, 400);
+    extractor.extractRegion(luma, nullptr, nullptr, moved, dst);
+    EXPECT_EQ(extractor.getWarpTableBuilds(), 3u);
+
+    deleteImage(dst);
+    deleteImage(luma);
+}
@@ -0,0 +1,190 @@
+#include "StudGrid.hpp"
+#include "operators.h"
+#include "operators_hsv.h"
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+using namespace cpparas;
+
+// The outer corners of the baseplate in the camera frame
+static const std::vector<Point<int32_t>> CORNERS = { { 200, 200 }, { 1800, 200 }, { 1800, 1800 }, { 200, 1800 } };
+
+static rgb888_pixel_t studPaint(uint32_t col, uint32_t row)
+{
+    return { (uint8_t)(col * 5), (uint8_t)(row * 5), 100 };
+}
+
+// Paints the studs of the layer as squares on a gray frame, around their centers on the baseplate of CORNERS
+// moved away from the center of the baseplate by the parallax of the layer (x' = x / z).
+// Returns whether the stud lies within the frame.
+static std::vector<std::vector<bool>> paintLayer(image_t* frame, const Calibration& calibration, uint32_t layer)
+{
+    const double pitch = 1600.0 / calibration.baseplateCols;
+    const double scale = calibration.cameraHeight / (calibration.cameraHeight - layer * calibration.blockHeight);
+    const int32_t half = (int32_t)(0.3 * pitch * scale);
+
+    pixel_t color;
+    color.rgb888_pixel = { 128, 128, 128 };
+    int32_t topLeft[2] = { 0, 0 };
+    int32_t size[2] = { frame->cols, frame->rows };
+    drawRect(frame, topLeft, size, color, SHAPE_FILL, 0);
+    std::vector<std::vector<bool>> inside(calibration.baseplateRows, std::vector<bool>(calibration.baseplateCols, false));
+    for (uint32_t row = 0; row < calibration.baseplateRows; row++) {
+        for (uint32_t col = 0; col < calibration.baseplateCols; col++) {
+            const double centerCol = 1000.0 + (col + 0.5 - calibration.baseplateCols / 2.0) * pitch * scale;
+            const double centerRow = 1000.0 + (row + 0.5 - calibration.baseplateRows / 2.0) * pitch * scale;
+            topLeft[0] = (int32_t)std::lround(centerCol) - half;
+            topLeft[1] = (int32_t)std::lround(centerRow) - half;
+            size[0] = size[1] = 2 * half + 1;
+            if (topLeft[0] < 0 || topLeft[1] < 0 || topLeft[0] + size[0] > frame->cols || topLeft[1] + size[1] > frame->rows) {
+                continue;
+            }
+            color.rgb888_pixel = studPaint(col, row);
+            drawRect(frame, topLeft, size, color, SHAPE_FILL, 0);
+            inside[row][col] = true;
+        }
+    }
+    return inside;
+}
+
+static void expectHSVOfImage(const Frame& frame)
+{
+    const image_t* image = frame.getImage();
+    const image_t* hsvImage = frame.getHSVImage();
+    for (int32_t row = 0; row < image->rows; row += 7) {
+        for (int32_t col = 0; col < image->cols; col += 7) {
+            const hsv_pixel_t expected = rgb888ToHSV(getRGB888Pixel(image, col, row));
+            const hsv_pixel_t pixel = getHSVPixel(hsvImage, col, row);
+            ASSERT_EQ(pixel.h, expected.h) << col << ", " << row;
+            ASSERT_EQ(pixel.s, expected.s) << col << ", " << row;
+            ASSERT_EQ(pixel.v, expected.v) << col << ", " << row;
+        }
+    }
+}
+
+TEST(StudGridSuite, EveryStudHasItsOwnBlock)
+{
+    const Calibration calibration = DEFAULT_CALIBRATION;
+    const uint32_t layer = 7;
+    StudGrid grid(calibration);
+    grid.setCorners(CORNERS);
+    grid.setLayer(layer);
+    ASSERT_EQ(grid.getCols(), calibration.baseplateCols * grid.getStudPixels());
+    ASSERT_EQ(grid.getRows(), calibration.baseplateRows * grid.getStudPixels() * STUD_FRAME_LAYERS);
+
+    // The camera frame shows the bottom layer, the studs of the layer are sampled from their own painting
+    std::shared_ptr<FramePool> pool = FramePool::create(grid.getCols(), grid.getRows(), FrameFormat::RGB888);
+    std::shared_ptr<Frame> bottomFrame = pool->acquire();
+    std::shared_ptr<Frame> layerFrame = pool->acquire();
+    image_t* camera = newRGB888Image(2000, 2000);
+    const std::vector<std::vector<bool>> bottomInside = paintLayer(camera, calibration, 0);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, bottomFrame->getImage(), bottomFrame->provideHSVImage()));
+    const std::vector<std::vector<bool>> layerInside = paintLayer(camera, calibration, layer);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, layerFrame->getImage(), layerFrame->provideHSVImage()));
+    FrameInfo info;
+    info.studLayer = layer;
+    bottomFrame->setInfo(info);
+    layerFrame->setInfo(info);
+
+    const StudFrame bottomStuds(bottomFrame);
+    const StudFrame layerStuds(layerFrame);
+    EXPECT_TRUE(layerStuds.hasLayer(0));
+    EXPECT_TRUE(layerStuds.hasLayer(layer));
+    EXPECT_FALSE(layerStuds.hasLayer(layer + 1));
+    EXPECT_THROW(layerStuds.blockPosition(layer + 1, { 0, 0 }), std::invalid_argument);
+
+    const uint32_t studPixels = grid.getStudPixels();
+    uint32_t checked = 0;
+    for (uint32_t row = 0; row < calibration.baseplateRows; row++) {
+        for (uint32_t col = 0; col < calibration.baseplateCols; col++) {
+            if (!bottomInside[row][col] || !layerInside[row][col]) {
+                continue;
+            }
+            const rgb888_pixel_t paint = studPaint(col, row);
+            const hsv_pixel_t expected = rgb888ToHSV(paint);
+            for (uint32_t checkedLayer : { 0u, layer }) {
+                const StudFrame& studs = checkedLayer == 0 ? bottomStuds : layerStuds;
+                const Point<int32_t> block = studs.blockPosition(checkedLayer, { col, row });
+                // The middle half of the block lies well within the painted stud
+                for (uint32_t r = studPixels / 4; r < studPixels * 3 / 4; r++) {
+                    for (uint32_t c = studPixels / 4; c < studPixels * 3 / 4; c++) {
+                        const rgb888_pixel_t pixel = getRGB888Pixel(studs.getImage(), block.col + c, block.row + r);
+                        ASSERT_EQ(pixel.r, paint.r) << "layer " << checkedLayer << " stud " << col << ", " << row;
+                        ASSERT_EQ(pixel.g, paint.g) << "layer " << checkedLayer << " stud " << col << ", " << row;
+                    }
+                }
+                const hsv_pixel_t average = studs.studColor(checkedLayer, { col, row });
+                EXPECT_EQ(average.h, expected.h) << "layer " << checkedLayer << " stud " << col << ", " << row;
+                EXPECT_EQ(average.s, expected.s) << "layer " << checkedLayer << " stud " << col << ", " << row;
+                EXPECT_EQ(average.v, expected.v) << "layer " << checkedLayer << " stud " << col << ", " << row;
+            }
+            checked++;
+        }
+    }
+    EXPECT_GT(checked, calibration.baseplateCols * calibration.baseplateRows / 2);
+    expectHSVOfImage(*layerFrame);
+    deleteImage(camera);
+}
+
+TEST(StudGridSuite, YUV420FramesAreGatheredWithTheirColors)
+{
+    StudGrid grid(DEFAULT_CALIBRATION);
+    grid.setCorners(CORNERS);
+    grid.setLayer(4);
+    std::shared_ptr<FramePool> pool = FramePool::create(grid.getCols(), grid.getRows(), FrameFormat::RGB888);
+    std::shared_ptr<Frame> frame = pool->acquire();
+
+    // A saturated red all over the frame
+    image_t* luma = newBasicImage(2000, 2000);
+    image_t* chromaU = newBasicImage(1000, 1000);
+    image_t* chromaV = newBasicImage(1000, 1000);
+    for (int32_t row = 0; row < 2000; row++) {
+        for (int32_t col = 0; col < 2000; col++) {
+            setBasicPixel(luma, col, row, 81);
+            setBasicPixel(chromaU, col / 2, row / 2, 90);
+            setBasicPixel(chromaV, col / 2, row / 2, 240);
+        }
+    }
+    ASSERT_TRUE(grid.sample(luma, chromaU, chromaV, frame->getImage(), frame->provideHSVImage()));
+    const rgb888_pixel_t pixel = getRGB888Pixel(frame->getImage(), 100, grid.getRows() - 100);
+    EXPECT_GT(pixel.r, 200);
+    EXPECT_LT(pixel.g, 50);
+    EXPECT_LT(pixel.b, 50);
+    expectHSVOfImage(*frame);
+    deleteImage(luma);
+    deleteImage(chromaU);
+    deleteImage(chromaV);
+}
+
+TEST(StudGridSuite, TablesAreOnlyMadeWhenTheirLayerChanges)
+{
+    StudGrid grid(DEFAULT_CALIBRATION);
+    image_t* camera = newRGB888Image(2000, 2000);
+    image_t* dst = newRGB888Image(grid.getCols(), grid.getRows());
+    EXPECT_FALSE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+
+    grid.setCorners(CORNERS);
+    grid.setLayer(2);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+    EXPECT_EQ(grid.getTableBuilds(), 2u);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+    EXPECT_EQ(grid.getTableBuilds(), 2u);
+
+    // Only the block of the checked layer is made again, the bottom layer stays
+    grid.setLayer(3);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+    EXPECT_EQ(grid.getTableBuilds(), 3u);
+
+    // The same corners keep the tables, others make both blocks again
+    grid.setCorners(CORNERS);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+    EXPECT_EQ(grid.getTableBuilds(), 3u);
+    std::vector<Point<int32_t>> moved = CORNERS;
+    moved[2].col += 10;
+    grid.setCorners(moved);
+    ASSERT_TRUE(grid.sample(camera, nullptr, nullptr, dst, nullptr));
+    EXPECT_EQ(grid.getTableBuilds(), 5u);
+    deleteImage(camera);
+    deleteImage(dst);
+}
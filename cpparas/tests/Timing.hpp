@@ -0,0 +1,23 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+/**
+ * @brief Returns the fastest of a number of runs in microseconds, the run least disturbed by the rest of the machine.
+ *        Timings are only reported with RecordProperty; tests don't assert on them, so a busy machine can't fail them.
+ */
+inline int fastestMicroseconds(const std::function<void()>& run, int runs)
+{
+    std::chrono::steady_clock::duration best = std::chrono::steady_clock::duration::max();
+    for (int i = 0; i < runs; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    return (int)std::chrono::duration_cast<std::chrono::microseconds>(best).count();
+}
+
+#endif /* TIMING_HPP */